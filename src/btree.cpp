@@ -5,11 +5,17 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
+#include <cassert>
+#include <queue>
+#include <thread>
+
 #include "btree.h"
 #include "filescan.h"
 #include "exceptions/bad_index_info_exception.h"
 #include "exceptions/bad_opcodes_exception.h"
 #include "exceptions/bad_scanrange_exception.h"
+#include "exceptions/bad_scan_param_exception.h"
 #include "exceptions/no_such_key_found_exception.h"
 #include "exceptions/scan_not_initialized_exception.h"
 #include "exceptions/index_scan_completed_exception.h"
@@ -20,6 +26,175 @@
 namespace badgerdb
 {
 
+// -----------------------------------------------------------------------------
+// Scan bounds of each key type
+// -----------------------------------------------------------------------------
+
+template <>
+int& ScanCursor::scanLowVal<int>() { return lowValInt; }
+
+template <>
+DoubleKey& ScanCursor::scanLowVal<DoubleKey>() { return lowValDouble; }
+
+template <>
+StringKey& ScanCursor::scanLowVal<StringKey>() { return lowValString; }
+
+template <>
+int& ScanCursor::scanHighVal<int>() { return highValInt; }
+
+template <>
+DoubleKey& ScanCursor::scanHighVal<DoubleKey>() { return highValDouble; }
+
+template <>
+StringKey& ScanCursor::scanHighVal<StringKey>() { return highValString; }
+
+template <>
+int& ScanCursor::scanNextKey<int>() { return nextKeyInt; }
+
+template <>
+DoubleKey& ScanCursor::scanNextKey<DoubleKey>() { return nextKeyDouble; }
+
+template <>
+StringKey& ScanCursor::scanNextKey<StringKey>() { return nextKeyString; }
+
+template <>
+CompositeKey& ScanCursor::scanLowVal<CompositeKey>() { return lowValComposite; }
+
+template <>
+CompositeKey& ScanCursor::scanHighVal<CompositeKey>() { return highValComposite; }
+
+template <>
+CompositeKey& ScanCursor::scanNextKey<CompositeKey>() { return nextKeyComposite; }
+
+template <>
+CoveringKey& ScanCursor::scanLowVal<CoveringKey>() { return lowValCovering; }
+
+template <>
+CoveringKey& ScanCursor::scanHighVal<CoveringKey>() { return highValCovering; }
+
+template <>
+CoveringKey& ScanCursor::scanNextKey<CoveringKey>() { return nextKeyCovering; }
+
+// -----------------------------------------------------------------------------
+// Keys of each key type
+// -----------------------------------------------------------------------------
+
+template <class T>
+T BTreeIndex::keyFromBytes(const void* key) const { return KeyTraits<T>::fromBytes(key); }
+
+template <>
+CompositeKey BTreeIndex::keyFromBytes<CompositeKey>(const void* key) const { return encodeKey((const char*) key, numKeyAttrs, 0); }
+
+template <class T>
+T BTreeIndex::keyFromRecord(const char* record) const { return KeyTraits<T>::fromBytes(record + attrByteOffset); }
+
+template <>
+CompositeKey BTreeIndex::keyFromRecord<CompositeKey>(const char* record) const { return encodeKey(record, numKeyAttrs, 0); }
+
+template <>
+CoveringKey BTreeIndex::keyFromRecord<CoveringKey>(const char* record) const {
+    CoveringKey key;
+    key.key = encodeKey(record, numKeyAttrs, 0);
+    // the included attributes are kept as the record stores them, only strings are cut to STRINGSIZE
+    memset(key.payload, 0, PAYLOADSIZE);
+    int width = 0;
+    for (int a = 0; a < numIncludeAttrs; a++) {
+        const char* value = record + includeAttrs[a].attrByteOffset;
+        if (includeAttrs[a].attrType == STRING) {
+            strncpy((char*) key.payload + width, value, STRINGSIZE);
+        } else {
+            memcpy(key.payload + width, value, keyAttrWidth(includeAttrs[a].attrType));
+        }
+        width += keyAttrWidth(includeAttrs[a].attrType);
+    }
+    return key;
+}
+
+template <>
+CoveringKey BTreeIndex::keyFromBytes<CoveringKey>(const void* key) const { return keyFromRecord<CoveringKey>((const char*) key); }
+
+void BTreeIndex::copyPayloads(const LeafNode<CoveringKey>* node, const int first, const int n, unsigned char* out) const {
+    for (int i = 0; i < n; i++) {
+        memcpy(out + i * payloadSize, node->payloadArray[first + i], payloadSize);
+    }
+}
+
+void BTreeIndex::checkStorage(const StorageMode storageMode) const {
+    if ((recordSize > 0) != (storageMode == CLUSTERED)) {
+        throw BadIndexInfoException(storageMode == CLUSTERED ? "Error: only the leaves of a clustered index hold records."
+                                                             : "Error: the leaves of a clustered index hold records, not record ids.");
+    }
+}
+
+template <class T>
+void BTreeIndex::moveRecords(LeafNode<T>* from, const int first, LeafNode<T>* to, const int dest, const int n) const {
+    memmove(to->keyArray + dest, from->keyArray + first, n * sizeof(typename KeyTraits<T>::NodeKey));
+    memmove(leafRecord(to, dest), leafRecord(from, first), (size_t) n * recordSize);
+}
+
+template <class T>
+int BTreeIndex::entryCount(const LeafNode<T>* node, const int first, const int last) {
+    return (recordSize > 0) ? last - first : ridCount(node->ridArray, first, last);
+}
+
+CompositeKey BTreeIndex::encodeKey(const char* record, const int numAttrs, const unsigned char fill) const {
+    CompositeKey key;
+    memset(key.data, 0, COMPOSITESIZE);
+    int width = 0;
+    for (int a = 0; a < numKeyAttrs; a++) {
+        if (a < numAttrs) {
+            width += encodeKeyAttr(keyAttrs[a].attrType, record + keyAttrs[a].attrByteOffset, key.data + width);
+        } else {
+            memset(key.data + width, fill, keyAttrWidth(keyAttrs[a].attrType));
+            width += keyAttrWidth(keyAttrs[a].attrType);
+        }
+    }
+    return key;
+}
+
+// -----------------------------------------------------------------------------
+// NodeCache
+// -----------------------------------------------------------------------------
+
+NodeCache::NodeCache() : numCached(0), capacity(0) {
+    for (int slot = 0; slot < NUMSLOTS; slot++) {
+        pageNoArray[slot].store(Page::INVALID_NUMBER, std::memory_order_relaxed);
+        pageArray[slot] = NULL;
+    }
+}
+
+Page* NodeCache::lookup(const PageId pageNo) const {
+    // linear probing from the hash of the page number, an empty slot ends the search since nothing is removed
+    for (int slot = (pageNo * 2654435761u) & (NUMSLOTS - 1); ; slot = (slot + 1) & (NUMSLOTS - 1)) {
+        PageId slotPageNo = pageNoArray[slot].load(std::memory_order_acquire);
+        if (slotPageNo == pageNo) {
+            return pageArray[slot];
+        }
+        if (slotPageNo == Page::INVALID_NUMBER) {
+            return NULL;
+        }
+    }
+}
+
+bool NodeCache::insert(const PageId pageNo, Page* page, const int limit) {
+    std::lock_guard<std::mutex> guard(insertMutex);
+    if (numCached.load(std::memory_order_relaxed) >= std::min(limit, capacity)) {
+        return false;
+    }
+    int slot = (pageNo * 2654435761u) & (NUMSLOTS - 1);
+    while (pageNoArray[slot].load(std::memory_order_relaxed) != Page::INVALID_NUMBER) {
+        if (pageNoArray[slot].load(std::memory_order_relaxed) == pageNo) {
+            return false;
+        }
+        slot = (slot + 1) & (NUMSLOTS - 1);
+    }
+    // lookups that find the page number also find the page
+    pageArray[slot] = page;
+    pageNoArray[slot].store(pageNo, std::memory_order_release);
+    numCached.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
 // -----------------------------------------------------------------------------
 // BTreeIndex::BTreeIndex -- Constructor
 // -----------------------------------------------------------------------------
@@ -28,20 +203,187 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
 		std::string & outIndexName,
 		BufMgr *bufMgrIn,
 		const int attrByteOffset,
-		const Datatype attrType) {
+		const Datatype attrType,
+		const bool bulkLoadMode,
+		const float fillFactor,
+		const SplitPolicy splitPolicy)
+    : indexScan(this) {  // intialize the scan started with startScan, no scan is executing
     bufMgr = bufMgrIn; // initialize buffer manager with given input
+    this->fillFactor = fillFactor;
+    this->splitPolicy = splitPolicy;
     this->attributeType = attrType;  // initialize attrByteOffset and attrType
     this->attrByteOffset = attrByteOffset;
+    numKeyAttrs = 1;
+    keyAttrs[0].attrByteOffset = attrByteOffset;
+    keyAttrs[0].attrType = attrType;
+    numIncludeAttrs = 0;
+    payloadSize = 0;
+    recordSize = 0;
 
     // get the corresponding index file name
     std::ostringstream idxStr;
     idxStr << relationName << '.' << attrByteOffset;
     outIndexName = idxStr.str();
 
+    openIndex(relationName, outIndexName, bulkLoadMode, fillFactor);
+}
+
+BTreeIndex::BTreeIndex(const std::string & relationName,
+		std::string & outIndexName,
+		BufMgr *bufMgrIn,
+		const int attrByteOffset,
+		const Datatype attrType,
+		const StorageMode storageMode,
+		const int recordSize,
+		const float fillFactor,
+		const SplitPolicy splitPolicy)
+    : indexScan(this) {
+    const bool clustered = storageMode == CLUSTERED;
+    if (clustered && (attrType == COMPOSITE || attrType == COVERING ||
+                      recordSize < attrByteOffset + keyAttrWidth(attrType) || recordSize > MAXCLUSTEREDRECORDSIZE)) {
+        throw BadIndexInfoException("Error: a clustered index needs tuples of up to MAXCLUSTEREDRECORDSIZE bytes that hold the key attribute.");
+    }
+    bufMgr = bufMgrIn;
+    this->fillFactor = fillFactor;
+    this->splitPolicy = splitPolicy;
+    this->attributeType = attrType;
+    this->attrByteOffset = attrByteOffset;
+    numKeyAttrs = 1;
+    keyAttrs[0].attrByteOffset = attrByteOffset;
+    keyAttrs[0].attrType = attrType;
+    numIncludeAttrs = 0;
+    payloadSize = 0;
+    this->recordSize = clustered ? recordSize : 0;
+
+    // a clustered index is named apart from the secondary index on the same attribute, so both can exist
+    std::ostringstream idxStr;
+    idxStr << relationName << '.' << attrByteOffset << (clustered ? ".clustered" : "");
+    outIndexName = idxStr.str();
+
+    // the leaves of a clustered index are always bulk built from the heap file
+    openIndex(relationName, outIndexName, true, fillFactor);
+}
+
+BTreeIndex::BTreeIndex(const std::string & relationName,
+		std::string & outIndexName,
+		BufMgr *bufMgrIn,
+		const std::vector<KeyAttr> & keyAttrs,
+		const bool bulkLoadMode,
+		const float fillFactor,
+		const SplitPolicy splitPolicy)
+    : BTreeIndex(relationName, outIndexName, bufMgrIn, keyAttrs, std::vector<KeyAttr>(), bulkLoadMode, fillFactor, splitPolicy) {
+}
+
+BTreeIndex::BTreeIndex(const std::string & relationName,
+		std::string & outIndexName,
+		BufMgr *bufMgrIn,
+		const std::vector<KeyAttr> & keyAttrs,
+		const std::vector<KeyAttr> & includeAttrs,
+		const bool bulkLoadMode,
+		const float fillFactor,
+		const SplitPolicy splitPolicy)
+    : indexScan(this) {
+    // a composite key has at least two attributes, so its index file name never clashes with the one of a single attribute index.
+    // A covering index may have a single key attribute, its file name also lists the included attributes
+    int keyWidth = 0, includeWidth = 0;
+    for (size_t a = 0; a < keyAttrs.size() + includeAttrs.size(); a++) {
+        const KeyAttr& attr = (a < keyAttrs.size()) ? keyAttrs[a] : includeAttrs[a - keyAttrs.size()];
+        if (attr.attrType != INTEGER && attr.attrType != DOUBLE && attr.attrType != STRING) {
+            throw BadIndexInfoException("Error: composite key and included attributes must be INTEGER, DOUBLE or STRING.");
+        }
+        (a < keyAttrs.size() ? keyWidth : includeWidth) += keyAttrWidth(attr.attrType);
+    }
+    if (keyAttrs.size() < (includeAttrs.empty() ? 2u : 1u) || keyAttrs.size() > (size_t) MAXKEYATTRS || keyWidth > COMPOSITESIZE) {
+        throw BadIndexInfoException("Error: a composite key needs 2 to MAXKEYATTRS attributes that fit in COMPOSITESIZE bytes.");
+    }
+    if (includeAttrs.size() > (size_t) MAXINCLUDEATTRS || includeWidth > PAYLOADSIZE) {
+        throw BadIndexInfoException("Error: a covering index includes up to MAXINCLUDEATTRS attributes that fit in PAYLOADSIZE bytes.");
+    }
+
+    bufMgr = bufMgrIn;
+    this->fillFactor = fillFactor;
+    this->splitPolicy = splitPolicy;
+    attributeType = includeAttrs.empty() ? COMPOSITE : COVERING;
+    attrByteOffset = keyAttrs[0].attrByteOffset;
+    numKeyAttrs = (int) keyAttrs.size();
+    std::copy(keyAttrs.begin(), keyAttrs.end(), this->keyAttrs);
+    numIncludeAttrs = (int) includeAttrs.size();
+    std::copy(includeAttrs.begin(), includeAttrs.end(), this->includeAttrs);
+    payloadSize = includeWidth;
+    recordSize = 0;
+
+    // the index file is named after the offsets of all key attributes, and of the included attributes
+    std::ostringstream idxStr;
+    idxStr << relationName;
+    for (int a = 0; a < numKeyAttrs; a++) {
+        idxStr << '.' << keyAttrs[a].attrByteOffset;
+    }
+    for (int a = 0; a < numIncludeAttrs; a++) {
+        idxStr << '+' << includeAttrs[a].attrByteOffset;
+    }
+    outIndexName = idxStr.str();
+
+    openIndex(relationName, outIndexName, bulkLoadMode, fillFactor);
+}
+
+/**
+  * Helper method.
+  * Opens the index file, or creates it and builds the tree if it does not exist. Called by the constructors once
+  * the key attributes and the name of the index file are known.
+  * @param relationName  Name of the base relation
+  * @param indexName  Name of the index file
+  * @param bulkLoadMode  True to build a new index with the bulk loader
+  * @param fillFactor  Fraction of each node filled by the bulk loader
+  */
+void BTreeIndex::openIndex(const std::string & relationName, const std::string & indexName, const bool bulkLoadMode, const float fillFactor) {
+    // the cached nodes stay pinned, so they may only take a small share of the buffer pool
+    nodeCache.capacity = std::min(MAXCACHEDNODES, (int) bufMgr->getNumBufs() / 8);
+
+    // initialize leaf and node occupancy with the sizes for the key type
+    switch (attributeType) {
+        case INTEGER:
+            leafOccupancy = INTARRAYLEAFSIZE;
+            nodeOccupancy = INTARRAYNONLEAFSIZE;
+            break;
+        case DOUBLE:
+            leafOccupancy = DOUBLEARRAYLEAFSIZE;
+            nodeOccupancy = DOUBLEARRAYNONLEAFSIZE;
+            break;
+        case STRING:
+            leafOccupancy = STRINGARRAYLEAFSIZE;
+            nodeOccupancy = STRINGARRAYNONLEAFSIZE;
+            break;
+        case COMPOSITE:
+            leafOccupancy = COMPOSITEARRAYLEAFSIZE;
+            nodeOccupancy = COMPOSITEARRAYNONLEAFSIZE;
+            break;
+        case COVERING:
+            leafOccupancy = COVERINGARRAYLEAFSIZE;
+            nodeOccupancy = COVERINGARRAYNONLEAFSIZE;
+            break;
+    }
+    // a leaf of a clustered index holds as many keys as fit in the page with their records
+    if (recordSize > 0) {
+        switch (attributeType) {
+            case INTEGER:
+                leafOccupancy = clusteredLeafSize<int>(recordSize);
+                break;
+            case DOUBLE:
+                leafOccupancy = clusteredLeafSize<DoubleKey>(recordSize);
+                break;
+            case STRING:
+                leafOccupancy = clusteredLeafSize<StringKey>(recordSize);
+                break;
+            case COMPOSITE:
+            case COVERING:
+                break;
+        }
+    }
+
     // check to see if the corresponding index file exists
-    if (File::exists(outIndexName)) {
+    if (File::exists(indexName)) {
         // Case: file exists, open the file.
-        File *file = (File *) new BlobFile(outIndexName, false);
+        File *file = (File *) new BlobFile(indexName, false);
         // Access page with metadata of the existing file
         PageId metaPageId = 1; // metapage is always first page of the btree index file
         Page *metaPage;
@@ -49,13 +391,24 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
         // casting to retrieve information
         IndexMetaInfo *metadata = (IndexMetaInfo *) metaPage;
         // check if values in metapage match with values received through constructor parameters
-        if(metadata->relationName != relationName || metadata->attrByteOffset != attrByteOffset || metadata->attrType != attrType){
+        bool keyAttrsMatch = metadata->numKeyAttrs == numKeyAttrs;
+        for (int a = 0; keyAttrsMatch && a < numKeyAttrs; a++) {
+            keyAttrsMatch = metadata->keyAttrs[a].attrByteOffset == keyAttrs[a].attrByteOffset && metadata->keyAttrs[a].attrType == keyAttrs[a].attrType;
+        }
+        keyAttrsMatch = keyAttrsMatch && metadata->numIncludeAttrs == numIncludeAttrs;
+        for (int a = 0; keyAttrsMatch && a < numIncludeAttrs; a++) {
+            keyAttrsMatch = metadata->includeAttrs[a].attrByteOffset == includeAttrs[a].attrByteOffset && metadata->includeAttrs[a].attrType == includeAttrs[a].attrType;
+        }
+        if(metadata->relationName != relationName || metadata->attrByteOffset != attrByteOffset || metadata->attrType != attributeType ||
+           metadata->leafRidSize != (int) sizeof(LeafRid) || metadata->recordSize != recordSize || !keyAttrsMatch){
             // unpin the metapage after use and throw exception and print error info
             bufMgr -> unPinPage(file, metaPageId, false);
             throw BadIndexInfoException("Error: value in metapage do not match with given parameters.");
         }
         headerPageNum = metaPageId;
         rootPageNum = metadata -> rootPageNo;
+        onlyOneRoot = metadata -> rootIsLeaf;
+        treeHeight = metadata -> treeHeight;
         this->file = file;
         // unpin the metapage after use
         bufMgr -> unPinPage(file, metaPageId, false);
@@ -63,7 +416,43 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
     }
 
     // Case: file does not exist, create it
-    file = (File *) new BlobFile(outIndexName, true);
+    file = (File *) new BlobFile(indexName, true);
+    switch (attributeType) {
+        case INTEGER:
+            buildIndex<int>(relationName, indexName, bulkLoadMode, fillFactor);
+            break;
+        case DOUBLE:
+            buildIndex<DoubleKey>(relationName, indexName, bulkLoadMode, fillFactor);
+            break;
+        case STRING:
+            buildIndex<StringKey>(relationName, indexName, bulkLoadMode, fillFactor);
+            break;
+        case COMPOSITE:
+            buildIndex<CompositeKey>(relationName, indexName, bulkLoadMode, fillFactor);
+            break;
+        case COVERING:
+            buildIndex<CoveringKey>(relationName, indexName, bulkLoadMode, fillFactor);
+            break;
+    }
+}
+
+/**
+  * Helper method.
+  * Creates the tree of a new index file over the tuples of the base relation, either with the bulk loader or by
+  * inserting the entry of every tuple one at a time.
+  * @param relationName  Name of the base relation
+  * @param indexName  Name of the index file
+  * @param bulkLoadMode  True to use the bulk loader
+  * @param fillFactor  Fraction of each node filled by the bulk loader
+  */
+template <class T>
+void BTreeIndex::buildIndex(const std::string & relationName, const std::string & indexName, const bool bulkLoadMode, const float fillFactor) {
+    // sort the entries of the base relation and build the tree bottom-up
+    if (bulkLoadMode) {
+        bulkLoad<T>(relationName, indexName, fillFactor);
+        return;
+    }
+
     // create the metadata (header) page and root page
     PageId metaPageId, rootPageId;
     Page *metaPage, *rootPage;
@@ -73,11 +462,21 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
     IndexMetaInfo *metadata = (IndexMetaInfo *) metaPage;
     strcpy(metadata -> relationName, relationName.c_str());
     metadata -> attrByteOffset = attrByteOffset;
-    metadata -> attrType = attrType;
+    metadata -> attrType = attributeType;
     metadata -> rootPageNo = rootPageId;
+    metadata -> rootIsLeaf = true;
+    metadata -> treeHeight = 0;
+    metadata -> leafRidSize = sizeof(LeafRid);
+    metadata -> numKeyAttrs = numKeyAttrs;
+    std::copy(keyAttrs, keyAttrs + numKeyAttrs, metadata -> keyAttrs);
+    metadata -> numIncludeAttrs = numIncludeAttrs;
+    std::copy(includeAttrs, includeAttrs + numIncludeAttrs, metadata -> includeAttrs);
+    metadata -> recordSize = recordSize;
     // set up the rootPage
-    ((LeafNodeInt *) rootPage) -> numOccupied = 0;
-    ((LeafNodeInt *) rootPage) -> rightSibPageNo = Page::INVALID_NUMBER;
+    ((LeafNode<T> *) rootPage) -> numOccupied = 0;
+    ((LeafNode<T> *) rootPage) -> rightSibPageNo = Page::INVALID_NUMBER;
+    ((LeafNode<T> *) rootPage) -> leftSibPageNo = Page::INVALID_NUMBER;
+    ((LeafNode<T> *) rootPage) -> pendingCount = 0;
     // unpin rootpage and metapage after initialization
     bufMgr -> unPinPage(file, metaPageId, true);
     bufMgr -> unPinPage(file, rootPageId, true);
@@ -85,12 +484,8 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
     // set up necessary private variables
     headerPageNum = metaPageId;
     rootPageNum = rootPageId;
-    // initialize leaf and node occupancy with integer size for insertion
-    leafOccupancy = INTARRAYLEAFSIZE; 
-    nodeOccupancy = INTARRAYNONLEAFSIZE;
-    
     onlyOneRoot = true;  // initialized tree to be empty at first
-    scanExecuting = false;  // intialize the status of scanExecuting
+    treeHeight = 0;
 
     // insert entries for every tuple in the base relation using FileScan class
     FileScan fscan(relationName, bufMgr);
@@ -100,12 +495,11 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
             fscan.scanNext(scanRid);
             std::string recordStr = fscan.getRecord();
             const char *record = recordStr.c_str();
-            int key = *((int *)(record + attrByteOffset));
-            insertEntry(&key, scanRid);
+            insertEntryTyped(keyFromRecord<T>(record), scanRid);
         }
 
-    // check if reach the end of the relation file    
-    } catch(EndOfFileException e) {
+    // check if reach the end of the relation file
+    } catch(const EndOfFileException &e) {
         // all records have been read
     }
 }
@@ -116,7 +510,14 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
 
 BTreeIndex::~BTreeIndex()
 {
-    if (scanExecuting) endScan();  // End any initialized scan
+    if (indexScan.isScanExecuting()) endScan();  // End any initialized scan
+    flushCounts();  // the subtree counts in the file take in every insert
+    // release the pins of the upper level cache, the nodes are written out with the rest of the file
+    for (int slot = 0; slot < nodeCache.numSlots(); slot++) {
+        if (nodeCache.slotPageNo(slot) != Page::INVALID_NUMBER) {
+            bufMgr->unPinPage(file, nodeCache.slotPageNo(slot), false);
+        }
+    }
     bufMgr -> flushFile(file);  // flush index file
     delete file;  // delete file instance thereby closing the index file
 }
@@ -126,493 +527,3392 @@ BTreeIndex::~BTreeIndex()
 // -----------------------------------------------------------------------------
 
 void BTreeIndex::insertEntry(const void *key, const RecordId rid) {
-    PageId pageNo = Page::INVALID_NUMBER;  // initialize pageNo, i.e. page, to be inserted
-    std::vector<PageId> visitedNodes;  // a list to track all visited nodes
-    searchEntry(*(int*)key, pageNo, this->rootPageNum, visitedNodes);  // we search through the tree to find a leaf page to insert in
-    insertEntryLeaf(*(int*)key, rid, pageNo, visitedNodes);  // performs actual insert
-}
-
-/**
-  * Helper method.
-  * Searches for the node in B+ Tree where the wanted key value belongs recursively, 
-  * loop through all keys in the node and stop once it finds a key that is strictly greater than the given key value.
-  * When there is only one root in the tree, it defaults to return the rootPageNum.
-  * @param key  Key to insert, according specification, assuming it is an int
-  * @param pageNo   PageId of a Page/node, this is being passed in from caller method
-  * @param rootPageNum  PageId of the Page/node we are operating on, rootPageNum is passed in to this method in the initial call to this method
-  * @param visitedNodes   List of Pages, stores all visited Pages/nodes, used in splitting
-  */
-void BTreeIndex::searchEntry(int key, PageId &pageNo, PageId rootPageNum, std::vector<PageId> &visitedNodes){
-    // When there is only one root node, the pageNo should be equal to rootPageNum
-    if (onlyOneRoot) {
-        pageNo = rootPageNum;
-        return; 
-    }
-
-    Page* currPage;  // initialize the current page we are on
-    bufMgr->readPage(file, rootPageNum, currPage);
-    NonLeafNodeInt* currNode = (NonLeafNodeInt*) currPage;
-    // search for the index we want by comparing key value with the keys in keyArray
-    // stop once we find a key that is strictly greater than the given key value
-    int i = 0;
-    while (i < currNode->numOccupied) {
-        if (currNode->keyArray[i] < key) {
-            i++;
-        } else {
+    checkStorage(SECONDARY);
+    // dispatch once on the key type, everything below works on typed keys
+    switch (attributeType) {
+        case INTEGER:
+            insertEntryTyped(KeyTraits<int>::fromBytes(key), rid);
+            break;
+        case DOUBLE:
+            insertEntryTyped(KeyTraits<DoubleKey>::fromBytes(key), rid);
+            break;
+        case STRING:
+            insertEntryTyped(KeyTraits<StringKey>::fromBytes(key), rid);
+            break;
+        case COMPOSITE:
+            insertEntryTyped(keyFromBytes<CompositeKey>(key), rid);
+            break;
+        case COVERING:
+            insertEntryTyped(keyFromBytes<CoveringKey>(key), rid);
             break;
-        }
-    }
-    
-    // According to btree.h, if the level of an internal node == 0, meaning that the node below current level is still an internal node, we continue search
-    if (currNode->level == 0) {
-        bufMgr -> unPinPage(file, rootPageNum, false);  // remember to unpin 
-        visitedNodes.push_back(rootPageNum);  // add current page to the back of visitedNodes list
-        searchEntry(key, pageNo, currNode->pageNoArray[i], visitedNodes);  // recurse down to next level in the tree
-
-    // else when the level of an internal node == 1, the leaf node at the level below is a leaf page
-    } else {
-        bufMgr->unPinPage(file, rootPageNum, false);  // remember to unpin 
-        visitedNodes.push_back(rootPageNum);  // add current page to the back of visitedNodes list
-        pageNo = currNode->pageNoArray[i];  // pageNo is returned to the called method, we assign the next pageNo to pageNo
     }
 }
 
 /**
   * Helper method.
-  * Inserts data entry key-rid pair into the leaf node specified by pageNo. 
-  * If the leaf node has enough space, we insert. Otherwise, we split by calling splitLeaf.
-  * @param key   Key to insert, according specification, assuming it is an int
+  * Inserts a typed key into the tree. Called by insertEntry once the key type is known.
+  * @param key   Key to insert
   * @param rid	Record ID of a record whose entry is getting inserted into the index.
-  * @param pageNo PageId of a Page/node, this is being passed in from caller method. const because we prevent modifying it
-  * @param visitedNodes  List of Pages, stores all visited Pages/nodes, used in splitting
   */
-void BTreeIndex::insertEntryLeaf(int key, const RecordId rid, const PageId pageNo, std::vector<PageId> &visitedNodes) {
-    Page* currPage;  // page to read into
-    bufMgr->readPage(file, pageNo, currPage);
-    LeafNodeInt* currLeafNode = (LeafNodeInt*) currPage;  // the assumption is that a page is a node
+template <class T>
+void BTreeIndex::insertEntryTyped(const T& key, const RecordId rid) {
+    PageId pageNo = Page::INVALID_NUMBER;  // initialize pageNo, i.e. page, to be inserted
+    TreePath path;  // tracks all visited nodes
+    searchEntry(key, pageNo, path);  // we search through the tree to find a leaf page to insert in
+    insertEntryLeaf(key, rid, pageNo, path);  // performs actual insert
+}
 
-    // Two general cases: if leaf node is not full or leaf node is full
-    // 1. first check if overflow occurs, i.e. not enough open spots to insert into current leaf node, we need to perform split
-    if (currLeafNode->numOccupied >= leafOccupancy) {
-        bufMgr->unPinPage(file, pageNo, false);  // before insertion, unpin curr page
-        splitLeaf(key, rid, pageNo, visitedNodes);  // calls helper method splitLeaf
+/**
+  * Helper method.
+  * Returns how many of the entries of an overflowing node the left node keeps, as the split policy decides.
+  * A packed split keeps the fill factor of the entries on the left, but never fewer than an even split
+  * and always leaves at least one entry for the new node.
+  * @param numEntries  Number of entries, or keys of a non-leaf node, including the one being inserted
+  * @param evenCount  Number the left node keeps in an even split
+  * @param append  True if the insert goes past the last key of the rightmost node of its level
+  */
+int BTreeIndex::splitPoint(const int numEntries, const int evenCount, const bool append) const {
+    if (splitPolicy == EVENSPLIT || (splitPolicy == APPENDSPLIT && !append)) {
+        return evenCount;
+    }
+    return std::min(numEntries - 1, std::max(evenCount, (int) (numEntries * fillFactor)));
+}
 
-    // 2. if there is enough open spots to insert into current leaf node, 
-    // we insert key into keyArray/ridArray of current leaf node by shifting up elements keyArray/ridArray until we find the right slot to insert into 
-    } else {
-        // implements a sorting algorithm where we start from the end and move all elements that are greater than 'key' in keyArray upward by 1 index
-        // Note: GTE is not considered since the assumption is that no duplicate key is present in the B+ tree
-        int i = 0;
-        while (i < currLeafNode->numOccupied) {
-            // if key is greater than last position tracked, break and insert key to last tracked position, i.e. [currLeafNode->numOccupied-i]
-            if (key > currLeafNode->keyArray[currLeafNode->numOccupied-1-i]) {
-                break;
+// -----------------------------------------------------------------------------
+// BTreeIndex::insertBatch
+// -----------------------------------------------------------------------------
 
-            // else, shift each element up by 1
-            } else {
-                // e.g. i=0, numOccupied=3, array[3-0]=array[3-1-0], array[3-1]=array[3-1-1]
-                currLeafNode->ridArray[currLeafNode->numOccupied-1 - i + 1] = currLeafNode->ridArray[currLeafNode->numOccupied-1 - i];
-                currLeafNode->keyArray[currLeafNode->numOccupied-1 - i + 1] = currLeafNode->keyArray[currLeafNode->numOccupied-1 - i];
-            }
-            i++;
-        }
-        currLeafNode->ridArray[currLeafNode->numOccupied - i] = rid;  // insert in the keyArray[currLeafNode->numOccupied - i] position
-        currLeafNode->keyArray[currLeafNode->numOccupied - i] = key;
-        currLeafNode->numOccupied += 1;  // increment numOccupied in curr node
-        bufMgr->unPinPage(file, pageNo, true);  // after insertion, unpin curr page
-        return;
+void BTreeIndex::insertBatch(const void* const* keys, const RecordId* rids, size_t n) {
+    checkStorage(SECONDARY);
+    switch (attributeType) {
+        case INTEGER:
+            insertBatchTyped<int>(keys, rids, n);
+            break;
+        case DOUBLE:
+            insertBatchTyped<DoubleKey>(keys, rids, n);
+            break;
+        case STRING:
+            insertBatchTyped<StringKey>(keys, rids, n);
+            break;
+        case COMPOSITE:
+            insertBatchTyped<CompositeKey>(keys, rids, n);
+            break;
+        case COVERING:
+            insertBatchTyped<CoveringKey>(keys, rids, n);
+            break;
     }
 }
 
 /**
   * Helper method.
-  * Splits a leaf Page/node after an overflow in leaf node
-  * The size, or capacity, of the new node is calculated based on leafOccupancy using the formula ceil((leafOccupancy+1)/2.
-  * @param key   Key to insert, according specification, assuming it is an int
-  * @param rid	Record ID of a record whose entry is getting inserted into the index.
-  * @param pageNo PageId of a Page/node, this is being passed in from caller method.
-  * @param visitedNodes  List of Pages, stores all visited Pages/nodes, used in splitting
+  * Inserts a batch of entries. Called by insertBatch once the key type is known.
+  * The batch is sorted, then each leaf takes the run of entries up to its high key in one merge, at most
+  * as many as MAXBATCHSPLIT leaves of a batch split take. A leaf that overflows is split into as many leaves as the merged entries need.
+  * @param keys	Array of n pointers to the keys to insert
+  * @param rids	Array of n record ids, rids[i] is inserted with keys[i]
+  * @param n	Number of entries
   */
-void BTreeIndex::splitLeaf(int key, const RecordId rid, PageId pageNo, std::vector<PageId> &visitedNodes) {
-    Page* currPage;  // page to read into
-    bufMgr->readPage(file, pageNo, currPage);
-    LeafNodeInt* currLeafNode = (LeafNodeInt*) currPage;  // the assumption is that a page is a node
+template <class T>
+void BTreeIndex::insertBatchTyped(const void* const* keys, const RecordId* rids, size_t n) {
+    std::vector< RIDKeyPair<T> > pairs(n);
+    for (size_t i = 0; i < n; i++) {
+        pairs[i].set(rids[i], keyFromBytes<T>(keys[i]));
+    }
+    std::sort(pairs.begin(), pairs.end());
 
-    Page* newPage;  // new page to split into
-    PageId newPageNo;
-    bufMgr->allocPage(file, newPageNo, newPage);
-    LeafNodeInt* newLeafPage = (LeafNodeInt*) newPage;  // new leaf node
+    std::vector<T> mergedKeys;
+    std::vector<LeafRid> mergedRids;
+    size_t k = 0;
+    while (k < n) {
+        PageId pageNo;
+        TreePath path;
+        searchEntry(pairs[k].key, pageNo, path);
 
-    // the curr node points to the right, i.e. pointing to the new node using rightSibPageNo, as defined in btree.h
-    newLeafPage->rightSibPageNo = currLeafNode->rightSibPageNo;
-    currLeafNode->rightSibPageNo = newPageNo;
-    newLeafPage->numOccupied = 0;  // set numOccupied to zero for new node
+        Page* page;
+        bufMgr->readPage(file, pageNo, page);
+        bufMgr->latchPage(page);
+        LeafNode<T>* leafNode = (LeafNode<T>*) page;
+        // the leaf was split since the descent, move right as insertEntryLeaf does
+        while (leafNode->rightSibPageNo != Page::INVALID_NUMBER && pairs[k].key > leafNode->highKey) {
+            PageId rightSibPageNo = leafNode->rightSibPageNo;
+            bufMgr->unlatchPage(page);
+            bufMgr->unPinPage(file, pageNo, false);
+            pageNo = rightSibPageNo;
+            bufMgr->readPage(file, pageNo, page);
+            bufMgr->latchPage(page);
+            leafNode = (LeafNode<T>*) page;
+        }
 
-    bool insertedFlag = false; // var to keep track whether the new key has been inserted or not.
-    int capacity = ceil((leafOccupancy+1)/2);  // by definition, this is the maximum number of keys to split the nonleaf node into
+        // the run is appended if it starts past the last key of the rightmost leaf
+        const bool lastLeaf = leafNode->rightSibPageNo == Page::INVALID_NUMBER;
+        const bool append = lastLeaf && (leafNode->numOccupied == 0 || pairs[k].key >= leafNode->keyArray[leafNode->numOccupied - 1]);
 
-    // moving & splitting keys
-    int i = 0;
-    while (i < leafOccupancy) {
-        // if key is greater than the key at keyArray[leafOccupancy-1-i] in curr node
-        if (key >= currLeafNode->keyArray[leafOccupancy-1-i]) {
-            // if the new key hasnt been inserted yet
-            if (!insertedFlag) {
-                // if we can't insert in the new node, i.e. it's filled, we insert in curr node
-                if (newLeafPage->numOccupied+capacity >= leafOccupancy+1) {
-                    currLeafNode->numOccupied += 1;
-                    currLeafNode->ridArray[leafOccupancy-i] = rid;
-                    currLeafNode->keyArray[leafOccupancy-i] = key;
-                    insertedFlag = true;
-
-
-                // this means the key hasn't been inserted AND the new key is larger than currLeafNode->keyArray[leafOccupancy-1 - i]
-                // in this case, we insert in new node first if new node has open spots
-                } else {
-                    newLeafPage->numOccupied += 1;
-                    newLeafPage->ridArray[leafOccupancy+1-capacity-1-i] = rid;
-                    newLeafPage->keyArray[leafOccupancy+1-capacity-1-i] = key;
-                    insertedFlag = true;
-                }
-            }
+        // the run of the leaf is every entry up to its high key, as many as the MAXBATCHSPLIT leaves of a batch split take
+        const size_t maxRun = (size_t) (MAXBATCHSPLIT * batchLeafCount(append) - leafNode->numOccupied);
+        size_t end = k;
+        while (end < n && end - k < maxRun && (lastLeaf || pairs[end].key <= leafNode->highKey)) {
+            end++;
+        }
 
-            // else if the new key has been previously inserted AND new node does not have open spots left, i.e. it's filled, continue to next step
-            if(newLeafPage->numOccupied+capacity >= leafOccupancy+1){
-                break;
-               
-            // else if the new key has been previously inserted AND new node has open spots left, hence we reposition the key in keyArray[leafOccupancy-i-1] in the curr node
+        // merge the run with the entries of the leaf, the entries of a key in postingLess order
+        const int total = leafNode->numOccupied + (int) (end - k);
+        mergedKeys.resize(total);
+        mergedRids.resize(total);
+        int i = 0;
+        size_t j = k;
+        for (int m = 0; m < total; m++) {
+            if (j < end && (i == leafNode->numOccupied || pairs[j].key < leafNode->keyArray[i] ||
+                            (pairs[j].key == leafNode->keyArray[i] && !postingLess(leafNode->ridArray[i], pairs[j].rid)))) {
+                mergedKeys[m] = pairs[j].key;
+                mergedRids[m] = pairs[j].rid;
+                j++;
             } else {
-                currLeafNode->numOccupied -= 1;
-                newLeafPage->ridArray[leafOccupancy+1-capacity-2-i] = currLeafNode->ridArray[leafOccupancy-i-1];
-                newLeafPage->keyArray[leafOccupancy+1-capacity-2-i] = currLeafNode->keyArray[leafOccupancy-i-1];
-                newLeafPage->numOccupied += 1;
+                mergedKeys[m] = leafKey(leafNode, i);
+                mergedRids[m] = leafNode->ridArray[i];
+                i++;
             }
+        }
+        const size_t start = k;
+        k = end;
 
-        // else if key > currLeafNode->keyArray[leafOccupancy-1 - i]
-        // this happens when the insert key can be inserted in either curr node or new node
-        } else {
-            // insert key,rids from curr node into new node
-            if (newLeafPage->numOccupied+capacity < leafOccupancy+1) {
-                currLeafNode->numOccupied -= 1;
-
-                // copy from curr node keyArray into new node keyArray
-                newLeafPage->ridArray[leafOccupancy+1-capacity-1-i] = currLeafNode->ridArray[leafOccupancy-1-i];
-                newLeafPage->keyArray[leafOccupancy+1-capacity-1-i] = currLeafNode->keyArray[leafOccupancy-1-i];
-                newLeafPage->numOccupied += 1;
+        // long runs of one key go into posting lists before the merged entries are counted against the leaf
+        const int packed = packPostings(&mergedKeys[0], &mergedRids[0], total);
+        mergedKeys.resize(packed);
+        mergedRids.resize(packed);
 
-            //  else when new node reaches maximum capacity, meaning that we filled new node, we inset in curr node
-            } else {
-                // implements a sorting algorithm where we start from the end and move all elements that are greater than 'key' in keyArray upward by 1 index
-                currLeafNode->keyArray[leafOccupancy - i] = currLeafNode->keyArray[leafOccupancy-1 - i];
-                currLeafNode->ridArray[leafOccupancy - i] = currLeafNode->ridArray[leafOccupancy-1 - i];
-
-                // case when i goes out of range of leafOccupancy, i.e. curr node contains all keys greater than new key
-                if (leafOccupancy == i+1) {
-                    currLeafNode->numOccupied += 1;
-                    currLeafNode->ridArray[leafOccupancy-1 - i] = rid;
-                    currLeafNode->keyArray[leafOccupancy-1 - i] = key;
-                    insertedFlag = true;
-                }
+        if (packed <= leafOccupancy) {
+            for (int m = 0; m < packed; m++) {
+                setLeafKey(leafNode, m, mergedKeys[m]);
             }
+            std::copy(mergedRids.begin(), mergedRids.end(), leafNode->ridArray);
+            leafNode->numOccupied = packed;
+            countLater<T>(pageNo, page, (int) (end - start));
+        } else {
+            splitLeafBatch(mergedKeys, mergedRids, pageNo, page, append, path);
         }
-        i++;
-    }
-    int propagateUpKey = newLeafPage->keyArray[0];  // need to propagate key up tree, so unpin curr page for buffer manager
-    bufMgr->unPinPage(file, pageNo, true);
-    bufMgr->unPinPage(file, newPageNo, true);
-
-    // checks if there is only one node in this tree using our visitedNodes list, a non-empty visited nodes list means we are at least one level in depth of tree
-    if (visitedNodes.size() != 0) {
-        PageId parentPageNo = visitedNodes[visitedNodes.size() - 1];  // gets the parent internal node one level above
-        visitedNodes.erase(visitedNodes.begin()+visitedNodes.size()-1);  // update the current visitedNodes list by erasing the parentPageNo from it since we moved up one level
-        insertEntryInternal(propagateUpKey, parentPageNo, newPageNo, visitedNodes, true);  // need to insert in internal node, we pass in the parent node
-
-    // else, we need to propagate up a key to be a new root
-    } else {
-        PageId rootId; // page to read into
-        Page* rootPage;
-        bufMgr->allocPage(file, rootId, rootPage); 
-        NonLeafNodeInt* rootNode = (NonLeafNodeInt*) rootPage;  // new root node
-
-        rootNode->keyArray[0] = propagateUpKey;  // we insert key into this new internal node
-        rootNode->pageNoArray[0] = pageNo;  
-        rootNode->pageNoArray[1] = newPageNo;
-        rootNode->numOccupied++;
-        rootNode->level = 1;
-
-        bufMgr->unPinPage(file, rootId, true);  // unpin curr page for buffer manager
-        onlyOneRoot = false;  // set this to false since we are on internal node
-        rootPageNum = rootId;  // update root for this B+ tree index
-
-        Page * metaPage;  // initialize the meta page according to btree.h
-        bufMgr->readPage(file, headerPageNum, metaPage);
-        IndexMetaInfo* metadata = (IndexMetaInfo*) metaPage;
-        metadata->rootPageNo = rootId;
-        bufMgr->unPinPage(file, headerPageNum, true);  // remember to unpin
     }
 }
 
 /**
   * Helper method.
-  * Inserts the key that was propagated up into the internal node specified by pageNo. 
-  * If the internal node has enough space, we insert. Otherwise, we split by calling splitInternal.
-  * @param key   Key to insert, according specification, assuming it is an int
-  * @param pageNo PageId of a Page/node, this is being passed in from caller method.
-  * @param newPageNo PageId of a Page/node created after split. const because we prevent modifying it
-  * @param visitedNodes  List of Pages, stores all visited Pages/nodes, used in splitting
-  * @param splitFromLeaf  Boolean, whether the split happens at an internal node 1 level above leaf node or more levels above leaf node
+  * Returns how many entries each leaf of a batch split but the last keeps: leafOccupancy if the entries are spread evenly,
+  * or as many as a single split leaves on the left if the split policy packs the split.
+  * @param append	True if the entries were appended past the last key of the rightmost leaf
   */
-void BTreeIndex::insertEntryInternal(int key, PageId pageNo, const PageId newPageNo, std::vector<PageId> visitedNodes, bool splitFromLeaf) {
-    Page* currPage;  // page to read into
-    bufMgr->readPage(file, pageNo, currPage);
-    NonLeafNodeInt * currInternalNode = (NonLeafNodeInt*) currPage;  // the assumption is that a page is a node
+int BTreeIndex::batchLeafCount(const bool append) const {
+    const int evenCount = (leafOccupancy + 2) / 2;
+    const int leftCount = splitPoint(leafOccupancy + 1, evenCount, append);
+    return (leftCount != evenCount) ? leftCount : leafOccupancy;
+}
 
-    // Two general cases: if internal node is not full or internal node is full
-    // 1. first check if overflow occurs, i.e. not enough open spots to insert into current internal node, we need to perform split
-    if (currInternalNode->numOccupied > nodeOccupancy) {
-        bufMgr->unPinPage(file, pageNo, false);  // before insertion, unpin curr page
-        splitInternal(key, pageNo, newPageNo, visitedNodes, splitFromLeaf);  // calls helper method splitInternal
+/**
+  * Helper method.
+  * Splits a leaf into as many leaves as its merged entries need, at most MAXBATCHSPLIT. The entries are spread evenly,
+  * unless the split policy packs the split: then every leaf but the last keeps batchLeafCount entries.
+  * The new leaves are made one at a time from left to right, each like a split by splitLeaf: the new leaf is allocated,
+  * filled and linked in, then its separator goes into the parent, which releases the leaf on its left.
+  * So no more than the two leaves of one split are latched at once. A new leaf takes the right link and high key
+  * of the leaf until the next one goes in on its right, no reader sees that meanwhile since it stays latched.
+  * @param keys	Merged keys of the leaf, more than leafOccupancy of them
+  * @param rids	Merged record ids of the leaf
+  * @param pageNo	PageId of the leaf
+  * @param page	The leaf, pinned and latched by the caller. Released here.
+  * @param append	True if the entries were appended past the last key of the rightmost leaf
+  * @param path	Path of non-leaf nodes visited from the root
+  */
+template <class T>
+void BTreeIndex::splitLeafBatch(const std::vector<T>& keys, const std::vector<LeafRid>& rids, const PageId pageNo, Page* page, const bool append, TreePath &path) {
+    const int total = (int) keys.size();
+    const int perLeaf = batchLeafCount(append);
+    const bool packed = perLeaf != leafOccupancy;
+    // insertBatchTyped cuts the runs so that this is at most MAXBATCHSPLIT
+    const int numLeaves = (total + perLeaf - 1) / perLeaf;
 
-    // 2. if there is enough open spots to insert into current leaf node, 
-    // we insert key into keyArray/ridArray of current leaf node by shifting up elements keyArray/ridArray until we find the right slot to insert into 
-    } else {
-        // When inserting internal node, we move the last element in currInternalNode->pageNoArray up by 1 index,
-        // this is because the new node will always be on the left of parent node since it has smaller key values than the key we want to insert
-        currInternalNode->pageNoArray[currInternalNode->numOccupied+1] = currInternalNode->pageNoArray[currInternalNode->numOccupied];
-
-        // implements a sorting algorithm where we start from the end and move all elements that are greater than 'key' in keyArray upward by 1 index
-        // Note: this is not LTE since the assumption is that no duplicate key is present in the B+ tree
-        int i = 0; 
-        while (i < currInternalNode->numOccupied) {
-            // if key is greater than last position tracked, break and insert key to last tracked position, i.e. [currLeafNode->numOccupied-i]
-            if(key > currInternalNode->keyArray[currInternalNode->numOccupied-1-i]) {
-                break;
+    // the last new leaf takes over the right link and high key of the leaf
+    LeafNode<T>* leafNode = (LeafNode<T>*) page;
+    const PageId rightSibPageNo = leafNode->rightSibPageNo;
+    const T highKey = leafNode->highKey;
 
-            // else, shift each element up by 1
-            } else {
-                // e.g. i=0, numOccupied=3, array[3-0]=array[3-1-0], array[3-1]=array[3-1-1]
-                currInternalNode->pageNoArray[currInternalNode->numOccupied-1 - i + 1] =  currInternalNode->pageNoArray[currInternalNode->numOccupied-1 - i];
-                currInternalNode->keyArray[currInternalNode->numOccupied-1 - i + 1] =  currInternalNode->keyArray[currInternalNode->numOccupied-1 - i];
+    PageId leftPageNo = pageNo;
+    Page* leftPage = page;
+    for (int l = 0; l < numLeaves; l++) {
+        const int first = packed ? l * perLeaf : (int) ((long long) total * l / numLeaves);
+        const int last = packed ? std::min(total, first + perLeaf) : (int) ((long long) total * (l + 1) / numLeaves);
+        PageId nodePageNo = pageNo;
+        Page* nodePage = page;
+        if (l > 0) {
+            bufMgr->allocPage(file, nodePageNo, nodePage);
+            bufMgr->latchPage(nodePage);
+        }
+        LeafNode<T>* node = (LeafNode<T>*) nodePage;
+        for (int m = first; m < last; m++) {
+            setLeafKey(node, m - first, keys[m]);
+        }
+        std::copy(rids.begin() + first, rids.begin() + last, node->ridArray);
+        node->numOccupied = last - first;
+        node->rightSibPageNo = rightSibPageNo;
+        node->highKey = highKey;
+        node->pendingCount = 0;  // the parent gets the exact counts of the new leaves
+        if (l == 0) {
+            continue;
+        }
 
-            }
-            i++;
+        // link the new leaf in on the right of the last one, which now ends at the separator before the new leaf
+        LeafNode<T>* left = (LeafNode<T>*) leftPage;
+        const T separator = KeyTraits<T>::separator(left->keyArray[left->numOccupied - 1], node->keyArray[0]);
+        node->leftSibPageNo = leftPageNo;
+        left->rightSibPageNo = nodePageNo;
+        left->highKey = separator;
+        if (l + 1 == numLeaves) {
+            linkLeft<T>(rightSibPageNo, nodePageNo);
         }
 
-        // Insertion here, unlike insertEntryLeaf, there are two cases: 
-        // if the split happens at an internal node 1 level above leaf node, we shift pageNoArray[currInternalNode->numOccupied-i+1] down by one index, 
-        // and put newPageNo into that index 
-        if (splitFromLeaf) {
-            currInternalNode->pageNoArray[currInternalNode->numOccupied-i] = currInternalNode->pageNoArray[currInternalNode->numOccupied-i+1];
-            currInternalNode->keyArray[currInternalNode->numOccupied-i] = key;
-            currInternalNode->pageNoArray[currInternalNode->numOccupied-i+1] = newPageNo;
-            currInternalNode->numOccupied += 1;  // increment numOccupied in curr node
+        // insertParent releases the left leaf, the new one is the left leaf of the next split
+        TreePath leafPath = path;
+        insertParent(separator, leftPageNo, leftPage, ridCount(left->ridArray, 0, left->numOccupied),
+                     nodePageNo, ridCount(node->ridArray, 0, node->numOccupied), 0, leafPath);
+        leftPageNo = nodePageNo;
+        leftPage = nodePage;
+    }
+    bufMgr->unlatchPage(leftPage);
+    bufMgr->unPinPage(file, leftPageNo, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::insertRecord
+// -----------------------------------------------------------------------------
 
-        // else if the key to be inserted is not coming from a leaf node, this means that the key has already been propagated up
-        } else {
-            currInternalNode->pageNoArray[currInternalNode->numOccupied-i] = newPageNo;
-            currInternalNode->keyArray[currInternalNode->numOccupied-i] = key;
-            currInternalNode->numOccupied += 1;  // increment numOccupied in curr node
-        }
-        bufMgr->unPinPage(file, pageNo, true);  // after insertion, unpin curr page
-        return;
+void BTreeIndex::insertRecord(const void* record) {
+    checkStorage(CLUSTERED);
+    switch (attributeType) {
+        case INTEGER:
+            insertRecordTyped<int>((const char*) record);
+            break;
+        case DOUBLE:
+            insertRecordTyped<DoubleKey>((const char*) record);
+            break;
+        case STRING:
+            insertRecordTyped<StringKey>((const char*) record);
+            break;
+        case COMPOSITE:
+            insertRecordTyped<CompositeKey>((const char*) record);
+            break;
+        case COVERING:
+            insertRecordTyped<CoveringKey>((const char*) record);
+            break;
     }
 }
 
 /**
   * Helper method.
-  * Splits an internal Page/node after an overflow in internal node
-  * The size, or capacity, of the new node is calculated based on nodeOccupancy using the formula ceil((nodeOccupancy+1)/2.
-  * @param key   Key to insert, according specification, assuming it is an int
-  * @param pageNo PageId of a Page/node, this is being passed in from caller method.
-  * @param newPageNo PageId of a Page/node created after split. const because we prevent modifying it
-  * @param visitedNodes  List of Pages, stores all visited Pages/nodes, used in splitting
-  * @param splitFromLeaf  Boolean, whether the split happens at an internal node 1 level above leaf node or more levels above leaf node
+  * Inserts a record into a clustered index. Called by insertRecord once the key type is known.
+  * Finds the leaf like insertEntryLeaf does, moving right past splits since the descent, and shifts the keys and
+  * records after the slot up by one, or splits the leaf with splitRecordLeaf if it is full.
+  * @param record  The record, recordSize bytes
   */
-void BTreeIndex::splitInternal(int key, PageId pageNo, const PageId newPageNo, std::vector<PageId> &visitedNodes, bool splitFromLeaf) {
-    Page* currPage;  // page to read into
-    bufMgr->readPage(file, pageNo, currPage);
-    NonLeafNodeInt* currInternalNode = (NonLeafNodeInt*) currPage;  // the assumption is that a page is a node
-
-    Page* newPageTemp;  // new page to split into
-    PageId newPageNoTemp;
-    bufMgr->allocPage(file, newPageNoTemp, newPageTemp);
-    NonLeafNodeInt* newInternalNode = (NonLeafNodeInt*) newPageTemp;  // new leaf node
+template <class T>
+void BTreeIndex::insertRecordTyped(const char* record) {
+    const T key = keyFromRecord<T>(record);
+    PageId pageNo;
+    TreePath path;
+    searchEntry(key, pageNo, path);
 
-    newInternalNode->numOccupied = 0;   // set numOccupied to zero for new node
-    newInternalNode->level = currInternalNode->level;
+    Page* page;
+    bufMgr->readPage(file, pageNo, page);
+    bufMgr->latchPage(page);
+    LeafNode<T>* leafNode = (LeafNode<T>*) page;
+    while (leafNode->rightSibPageNo != Page::INVALID_NUMBER && key > leafNode->highKey) {
+        PageId rightSibPageNo = leafNode->rightSibPageNo;
+        bufMgr->unlatchPage(page);
+        bufMgr->unPinPage(file, pageNo, false);
+        pageNo = rightSibPageNo;
+        bufMgr->readPage(file, pageNo, page);
+        bufMgr->latchPage(page);
+        leafNode = (LeafNode<T>*) page;
+    }
 
-    bool insertedFlag = false; // var to keep track whether the new key has been inserted or not.
-    int propagateUpKey; // the key value needed to push up into the upper layer non-leaf node
-    int capacity = ceil((nodeOccupancy+1)/2);  // by definition, this is the maximum number of keys to split the nonleaf node into
-    // moving & splitting keys
-    int i = 0;
-    while (i < nodeOccupancy) {
-        // if key to be inserted is less than the curr internal node's i-th key
-        if (key < currInternalNode->keyArray[i]) {
-            if (!insertedFlag) {
-                // First, if the propagate up value has been pushed up, we reposition curr Internal Node by moving every index down by 1 for (newInternalNode->numOccupied-1) times
-                if (newInternalNode->numOccupied > capacity) {
-                    currInternalNode->keyArray[i-(newInternalNode->numOccupied-1)-1] = key;
-                    // here, currInternalNode->pageNoArray[i-(newInternalNode->numOccupied-1)-1] is the actual left node
-                    if (splitFromLeaf) {
-                        currInternalNode->pageNoArray[i-(newInternalNode->numOccupied-1)-1] = currInternalNode->pageNoArray[i];
-                        currInternalNode->pageNoArray[i] = newPageNo;
-                    } else {
-                        currInternalNode->pageNoArray[i-(newInternalNode->numOccupied-1)-1] = newPageNo;
-                    }
-                    currInternalNode->numOccupied ++;
-
-                // else if the new internal node has open slots, we insert key into new key first
-                } else if (newInternalNode->numOccupied < capacity) {
-                    newInternalNode->keyArray[i] = key;
-
-                    // or reassign curr Internal node's left most child node to be new internal node's left most child
-                    if (splitFromLeaf) {
-                        newInternalNode->pageNoArray[i] = currInternalNode->pageNoArray[i];
-                        currInternalNode->pageNoArray[i] = newPageNo;
-                    // then, depending on if the split happens at an internal node 1 level above leaf node,
-                    // we either assign newPageNo to newInternalNode, or copy nodes in curr internal node to new internal node
-                    } else {
-                        newInternalNode->pageNoArray[i] = newPageNo;
-                    }
-                    newInternalNode->numOccupied ++;
-
-                // else if the new internal node is full (newInternalNode->numOccupied == capacity), we split and propagate up the middle key in the curr internal node.
-                // Note that when splitting an internal node, we do not need to preserve the propagate up key because it can just be pushed up 
-                } else {
-                    propagateUpKey = key;  // need to propagate key up in tree
-
-                    // here, currInternalNode->pageNoArray[i] is the actual left node
-                    if (splitFromLeaf) {
-                        newInternalNode->pageNoArray[newInternalNode->numOccupied] = currInternalNode->pageNoArray[i];
-                        currInternalNode->pageNoArray[i] = newPageNo;
-                    } else {
-                        newInternalNode->pageNoArray[newInternalNode->numOccupied] = newPageNo;
+    if (leafNode->numOccupied >= leafOccupancy) {
+        splitRecordLeaf(key, record, pageNo, page, path);  // releases the leaf
+        return;
+    }
+    const int pos = nodeLowerBound(leafNode->keyArray, leafNode->numOccupied, key);
+    moveRecords(leafNode, pos, leafNode, pos + 1, leafNode->numOccupied - pos);
+    leafNode->keyArray[pos] = key;
+    memcpy(leafRecord(leafNode, pos), record, recordSize);
+    leafNode->numOccupied++;
+    countLater<T>(pageNo, page, 1);  // counts the entry in the leaf, then releases it
+}
+
+/**
+  * Helper method.
+  * Splits a full leaf of a clustered index to insert a record. The split point, links, high keys and separator are those
+  * of splitLeaf, the entries move in runs of keys and records instead of one by one. The new leaf gets the entries from the
+  * split point on, and the leaf the new entry belongs in opens its slot.
+  * @param key   Key of the record
+  * @param record  The record
+  * @param pageNo PageId of the leaf
+  * @param page  The leaf, pinned and latched by the caller. Released here.
+  * @param path  Path of non-leaf nodes visited from the root, used in splitting
+  */
+template <class T>
+void BTreeIndex::splitRecordLeaf(const T& key, const char* record, const PageId pageNo, Page* page, TreePath &path) {
+    LeafNode<T>* currLeafNode = (LeafNode<T>*) page;
+    Page* newPage;
+    PageId newPageNo;
+    bufMgr->allocPage(file, newPageNo, newPage);
+    LeafNode<T>* newLeafNode = (LeafNode<T>*) newPage;
+
+    const int pos = nodeLowerBound(currLeafNode->keyArray, leafOccupancy, key);
+    const bool append = currLeafNode->rightSibPageNo == Page::INVALID_NUMBER && pos == leafOccupancy;
+    const int leftCount = splitPoint(leafOccupancy + 1, (leafOccupancy + 2) / 2, append);
+    if (pos < leftCount) {
+        moveRecords(currLeafNode, leftCount - 1, newLeafNode, 0, leafOccupancy - (leftCount - 1));
+        moveRecords(currLeafNode, pos, currLeafNode, pos + 1, leftCount - 1 - pos);
+        currLeafNode->keyArray[pos] = key;
+        memcpy(leafRecord(currLeafNode, pos), record, recordSize);
+    } else {
+        moveRecords(currLeafNode, leftCount, newLeafNode, 0, pos - leftCount);
+        moveRecords(currLeafNode, pos, newLeafNode, pos - leftCount + 1, leafOccupancy - pos);
+        newLeafNode->keyArray[pos - leftCount] = key;
+        memcpy(leafRecord(newLeafNode, pos - leftCount), record, recordSize);
+    }
+    currLeafNode->numOccupied = leftCount;
+    newLeafNode->numOccupied = leafOccupancy + 1 - leftCount;
+
+    // the shortest key between the two leaves separates them, which for strings may be a prefix of the first key of the new node
+    T propagateUpKey = KeyTraits<T>::separator(currLeafNode->keyArray[leftCount - 1], newLeafNode->keyArray[0]);
+    newLeafNode->rightSibPageNo = currLeafNode->rightSibPageNo;
+    newLeafNode->leftSibPageNo = pageNo;
+    newLeafNode->highKey = currLeafNode->highKey;
+    currLeafNode->rightSibPageNo = newPageNo;
+    currLeafNode->highKey = propagateUpKey;
+    // the parent gets the exact counts of both halves, which take in the pending entries
+    newLeafNode->pendingCount = 0;
+    currLeafNode->pendingCount = 0;
+    const PageId rightSibPageNo = newLeafNode->rightSibPageNo;
+    const int newCount = newLeafNode->numOccupied;
+    bufMgr->unPinPage(file, newPageNo, true);
+    linkLeft<T>(rightSibPageNo, newPageNo);
+
+    insertParent(propagateUpKey, pageNo, page, leftCount, newPageNo, newCount, 0, path);
+}
+
+/**
+  * Helper method.
+  * Searches for the leaf in B+ Tree where the wanted key value belongs, descending level by level from the root.
+  * In every node it follows the child left of the first key that is greater than or equal to the given key value,
+  * or moves right to the sibling if a concurrent split left the key beyond the high key of the node.
+  * Nodes are read optimistically, without their latch: a read that a writer overlapped fails validation and is repeated.
+  * When there is only one root in the tree, it defaults to return the rootPageNum.
+  * @param key  Key to search for
+  * @param pageNo   PageId of the leaf found, returned to the caller method
+  * @param path   Path of non-leaf nodes visited from the root, used in splitting
+  * @param stopHeight  Height above the leaves to stop at, 0 to find the leaf. A split uses it to find the parent of a non-leaf node
+  */
+template <class T>
+void BTreeIndex::searchEntry(const T& key, PageId &pageNo, TreePath &path, const int stopHeight){
+    path.depth = 0;
+    int height;
+    {
+        std::lock_guard<std::mutex> guard(rootMutex);
+        // When there is only one root node, the pageNo should be equal to rootPageNum
+        pageNo = rootPageNum;
+        height = treeHeight;
+    }
+    descend(key, pageNo, height, path, stopHeight);
+}
+
+/**
+  * Helper method.
+  * Descends from the non-leaf node pageNo at the given height to the node at stopHeight where the key belongs,
+  * appending the nodes visited to the path. Does the work of searchEntry below the root.
+  * @param key  Key to search for
+  * @param pageNo   PageId of the node to start from, replaced by the PageId of the node found
+  * @param height   Height of the node to start from above the leaves
+  * @param path   Path to append the non-leaf nodes visited to
+  * @param stopHeight  Height above the leaves to stop at, 0 to find the leaf
+  */
+template <class T>
+void BTreeIndex::descend(const T& key, PageId &pageNo, int height, TreePath &path, const int stopHeight){
+    while (height > stopHeight) {
+        bool cached;
+        Page* currPage = readNonLeaf(pageNo, height, cached);  // initialize the current page we are on
+        PageId nextPageNo;
+        bool moveRight = searchNonLeaf(currPage, key, nextPageNo);
+        releaseNonLeaf(pageNo, cached);  // remember to unpin
+
+        if (moveRight) {
+            pageNo = nextPageNo;
+            continue;
+        }
+        path.pageNoArray[path.depth++] = pageNo;  // add current page to the end of the path
+        pageNo = nextPageNo;
+        height--;
+    }
+}
+
+/**
+  * Helper method.
+  * Finds the page to go to next from a non-leaf node: the child left of the first key that is greater than or equal
+  * to the given key value, or the right sibling if a concurrent split left the key beyond the high key of the node.
+  * The node is read without latching it, then the read is checked against the version of the page and repeated
+  * if a writer latched it meanwhile. Nodes are never removed, so a failed read only has to be repeated on the same node.
+  * @param page  The non-leaf node, pinned by the caller
+  * @param key  Key to search for
+  * @param nextPageNo  PageId of the child or right sibling to go to, returned to the caller
+  * @return  True if nextPageNo is the right sibling
+  */
+template <class T>
+bool BTreeIndex::searchNonLeaf(Page* page, const T& key, PageId &nextPageNo){
+    NonLeafNode<T>* node = (NonLeafNode<T>*) page;
+    bool moveRight;
+    while (true) {
+        std::uint32_t version = bufMgr->pageVersion(page);
+        // a read overlapping a write may see any numOccupied, keep the search inside the node until validation throws it away
+        int numOccupied = std::min(std::max(node->numOccupied, 0), nodeOccupancy);
+        moveRight = node->rightSibPageNo != Page::INVALID_NUMBER && key > node->highKey;
+        nextPageNo = moveRight ? node->rightSibPageNo : nodeChild(node, nodeLowerBound(node, numOccupied, key));
+        if (bufMgr->validatePage(page, version)) {
+            return moveRight;
+        }
+        std::this_thread::yield();  // let the writer finish
+    }
+}
+
+/**
+  * Helper method.
+  * Pins a non-leaf node for reading, through the upper level cache. A node that is not cached is read with readPage
+  * and admitted while there is room, but the parents of the leaves only get half of the cache: the higher levels are
+  * visited by every descent, and a new root must still find room after the tree grows.
+  * @param pageNo  PageId of the node
+  * @param height  Height of the node above the leaves
+  * @param cached  Set to true if the node is in the cache, then it must not be unpinned
+  * @return  The frame of the node
+  */
+Page* BTreeIndex::readNonLeaf(const PageId pageNo, const int height, bool &cached) {
+    Page* page = nodeCache.lookup(pageNo);
+    cached = page != NULL;
+    if (!cached) {
+        bufMgr->readPage(file, pageNo, page);
+        cached = nodeCache.size() < nodeCache.capacity
+                 && nodeCache.insert(pageNo, page, height > 1 ? nodeCache.capacity : nodeCache.capacity / 2);
+    }
+    return page;
+}
+
+/**
+  * Helper method.
+  * Releases a node read with readNonLeaf. Cached nodes stay pinned.
+  * @param pageNo  PageId of the node
+  * @param cached  The flag readNonLeaf returned
+  */
+void BTreeIndex::releaseNonLeaf(const PageId pageNo, const bool cached) {
+    if (!cached) {
+        bufMgr->unPinPage(file, pageNo, false);
+    }
+}
+
+/**
+  * Helper method.
+  * Inserts data entry key-rid pair into the leaf node specified by pageNo, or into a right sibling of it if the leaf
+  * was split since the descent. If the leaf node has enough space, we insert. Otherwise, we split by calling splitLeaf.
+  * @param key   Key to insert
+  * @param rid	Record ID of a record whose entry is getting inserted into the index.
+  * @param pageNo PageId of the leaf found by searchEntry
+  * @param path  Path of non-leaf nodes visited from the root, used in splitting
+  */
+template <class T>
+void BTreeIndex::insertEntryLeaf(const T& key, const RecordId rid, PageId pageNo, TreePath &path) {
+    Page* currPage;  // page to read into
+    bufMgr->readPage(file, pageNo, currPage);
+    bufMgr->latchPage(currPage);
+    LeafNode<T>* currLeafNode = (LeafNode<T>*) currPage;  // the assumption is that a page is a node
+
+    // the leaf was split since the descent and the key now belongs to a right sibling, move right until it is found.
+    // Nodes are never removed, so the latch of a leaf can be released before the next one is taken
+    while (currLeafNode->rightSibPageNo != Page::INVALID_NUMBER && key > currLeafNode->highKey) {
+        PageId rightSibPageNo = currLeafNode->rightSibPageNo;
+        bufMgr->unlatchPage(currPage);
+        bufMgr->unPinPage(file, pageNo, false);
+        pageNo = rightSibPageNo;
+        bufMgr->readPage(file, pageNo, currPage);
+        bufMgr->latchPage(currPage);
+        currLeafNode = (LeafNode<T>*) currPage;
+    }
+
+    // a full leaf first moves long runs of one key into posting lists, which may leave room for the entry
+    if (currLeafNode->numOccupied >= leafOccupancy) {
+        currLeafNode->numOccupied = packPostings(currLeafNode->keyArray, currLeafNode->ridArray, currLeafNode->numOccupied);
+    }
+
+    // a key with a posting list in the leaf adds the record id to the list
+    for (int i = nodeLowerBound(currLeafNode->keyArray, currLeafNode->numOccupied, key);
+         i < currLeafNode->numOccupied && currLeafNode->keyArray[i] == key; i++) {
+        const RecordId entry = currLeafNode->ridArray[i];
+        if (isPosting(entry)) {
+            addPosting(entry.page_number, rid);
+            currLeafNode->ridArray[i] = postingLinkAdd(entry, 1);
+            countLater<T>(pageNo, currPage, 1);
+            return;
+        }
+    }
+
+    // Two general cases: if leaf node is not full or leaf node is full
+    // 1. first check if overflow occurs, i.e. not enough open spots to insert into current leaf node, we need to perform split
+    if (currLeafNode->numOccupied >= leafOccupancy) {
+        splitLeaf(key, rid, pageNo, currPage, path);  // calls helper method splitLeaf, which releases the leaf
+
+    // 2. if there is enough open spots to insert into current leaf node,
+    // we insert key into keyArray/ridArray of current leaf node by shifting up elements keyArray/ridArray after the slot to insert into
+    } else {
+        // the slot is in front of the first key that is greater than 'key', or equal to it with a record id not less than 'rid'
+        int pos = entryLowerBound(currLeafNode->keyArray, currLeafNode->ridArray, currLeafNode->numOccupied, key, rid);
+        // move all elements from the slot on upward by 1 index
+        for (int i = currLeafNode->numOccupied; i > pos; i--) {
+            currLeafNode->ridArray[i] = currLeafNode->ridArray[i - 1];
+            setLeafKey(currLeafNode, i, leafKey(currLeafNode, i - 1));
+        }
+        currLeafNode->ridArray[pos] = rid;  // insert in the keyArray[pos] position
+        setLeafKey(currLeafNode, pos, key);
+        currLeafNode->numOccupied += 1;  // increment numOccupied in curr node
+        countLater<T>(pageNo, currPage, 1);  // counts the entry in the leaf, then releases it
+        return;
+    }
+}
+
+/**
+  * Helper method.
+  * Splits a leaf Page/node after an overflow in leaf node
+  * The left node keeps ceil((leafOccupancy+1)/2) entries and the new node on its right gets the rest.
+  * The new node is linked in, then the separator is inserted into the parent. The leaf stays latched until the parent is,
+  * so that no other inserter can split the new node before the parent knows it.
+  * @param key   Key to insert
+  * @param rid	Record ID of a record whose entry is getting inserted into the index.
+  * @param pageNo PageId of a Page/node, this is being passed in from caller method.
+  * @param page  The leaf, pinned and latched by the caller. Released here.
+  * @param path  Path of non-leaf nodes visited from the root, used in splitting
+  */
+template <class T>
+void BTreeIndex::splitLeaf(const T& key, const RecordId rid, const PageId pageNo, Page* page, TreePath &path) {
+    LeafNode<T>* currLeafNode = (LeafNode<T>*) page;  // the assumption is that a page is a node
+
+    // the new node is not reachable by other threads until the curr node links to it, so it needs no latch while it is filled
+    Page* newPage;  // new page to split into
+    PageId newPageNo;
+    bufMgr->allocPage(file, newPageNo, newPage);
+    LeafNode<T>* newLeafNode = (LeafNode<T>*) newPage;  // new leaf node
+
+    // position of the new key among the leafOccupancy keys already in the node
+    int pos = entryLowerBound(currLeafNode->keyArray, currLeafNode->ridArray, leafOccupancy, key, rid);
+
+    // ceil((leafOccupancy+1)/2) entries stay in the curr node in an even split
+    const bool append = currLeafNode->rightSibPageNo == Page::INVALID_NUMBER && pos == leafOccupancy;
+    const int leftCount = splitPoint(leafOccupancy + 1, (leafOccupancy + 2) / 2, append);
+    if (pos < leftCount) {
+        // the new key stays in the curr node: move the entries from leftCount-1 on to the new node,
+        // then shift the entries from pos on up by 1 index to open the slot
+        for (int i = leftCount - 1; i < leafOccupancy; i++) {
+            setLeafKey(newLeafNode, i - (leftCount - 1), leafKey(currLeafNode, i));
+            newLeafNode->ridArray[i - (leftCount - 1)] = currLeafNode->ridArray[i];
+        }
+        for (int i = leftCount - 1; i > pos; i--) {
+            setLeafKey(currLeafNode, i, leafKey(currLeafNode, i - 1));
+            currLeafNode->ridArray[i] = currLeafNode->ridArray[i - 1];
+        }
+        setLeafKey(currLeafNode, pos, key);
+        currLeafNode->ridArray[pos] = rid;
+    } else {
+        // the new key goes to the new node: move the entries from leftCount on, leaving the slot of the new key open
+        int j = 0;
+        for (int i = leftCount; i < leafOccupancy; i++) {
+            if (j == pos - leftCount) {
+                j++;
+            }
+            setLeafKey(newLeafNode, j, leafKey(currLeafNode, i));
+            newLeafNode->ridArray[j] = currLeafNode->ridArray[i];
+            j++;
+        }
+        setLeafKey(newLeafNode, pos - leftCount, key);
+        newLeafNode->ridArray[pos - leftCount] = rid;
+    }
+    currLeafNode->numOccupied = leftCount;
+    newLeafNode->numOccupied = leafOccupancy + 1 - leftCount;
+
+    // the new node takes over the right link and high key of the curr node, which now ends at the separator
+    // the shortest key between the two leaves separates them, which for strings may be a prefix of the first key of the new node
+    T propagateUpKey = KeyTraits<T>::separator(currLeafNode->keyArray[leftCount - 1], newLeafNode->keyArray[0]);
+    newLeafNode->rightSibPageNo = currLeafNode->rightSibPageNo;
+    newLeafNode->leftSibPageNo = pageNo;
+    newLeafNode->highKey = currLeafNode->highKey;
+    currLeafNode->rightSibPageNo = newPageNo;
+    currLeafNode->highKey = propagateUpKey;
+    // the parent gets the exact counts of both halves, which take in the pending entries
+    newLeafNode->pendingCount = 0;
+    currLeafNode->pendingCount = 0;
+    const PageId rightSibPageNo = newLeafNode->rightSibPageNo;
+    const int newCount = ridCount(newLeafNode->ridArray, 0, newLeafNode->numOccupied);
+    bufMgr->unPinPage(file, newPageNo, true);
+    linkLeft<T>(rightSibPageNo, newPageNo);
+
+    // readers reach the new node through the right link until the separator is in the parent
+    insertParent(propagateUpKey, pageNo, page, ridCount(currLeafNode->ridArray, 0, leftCount), newPageNo, newCount, 0, path);
+}
+
+/**
+  * Helper method.
+  * Points the left link of a leaf to the new leaf a split put on its left. Called by the splitter with the split leaf
+  * still latched, after its right link leads to the new leaf, so leaves are latched from left to right as everywhere else.
+  * @param pageNo PageId of the leaf, Page::INVALID_NUMBER if the split leaf was the rightmost one
+  * @param leftSibPageNo PageId of the new left sibling
+  */
+template <class T>
+void BTreeIndex::linkLeft(const PageId pageNo, const PageId leftSibPageNo) {
+    if (pageNo == Page::INVALID_NUMBER) {
+        return;
+    }
+    Page* page;
+    bufMgr->readPage(file, pageNo, page);
+    bufMgr->latchPage(page);
+    ((LeafNode<T>*) page)->leftSibPageNo = leftSibPageNo;
+    bufMgr->unlatchPage(page);
+    bufMgr->unPinPage(file, pageNo, true);
+}
+
+/**
+  * Helper method.
+  * Moves the entries of every key that has POSTINGTHRESHOLD or more of them among keys[0, n) into a new posting list,
+  * and the entries of a key that already has a posting list there into that list. The entries left are compacted.
+  * @param keys	Sorted keys of the entries
+  * @param rids	Record ids of the entries
+  * @param n	Number of entries
+  * @return	Number of entries left
+  */
+template <class T>
+int BTreeIndex::packPostings(T* keys, LeafRid* rids, const int n) {
+    // the entries of a key in a covering index differ in their included attributes, which a posting list would drop
+    if (attributeType == COVERING) {
+        return n;
+    }
+    int out = 0;
+    int i = 0;
+    while (i < n) {
+        // the run of entries with the key of entry i, and the posting list of the key among them if there is one
+        int end = i;
+        int posting = -1;
+        PageId postingPageNo = Page::INVALID_NUMBER;
+        while (end < n && keys[end] == keys[i]) {
+            const RecordId rid = rids[end];
+            if (posting == -1 && isPosting(rid)) {
+                posting = end;
+                postingPageNo = rid.page_number;
+            }
+            end++;
+        }
+
+        if (posting == -1 && end - i >= POSTINGTHRESHOLD) {
+            std::vector<RecordId> run(rids + i, rids + end);
+            std::sort(run.begin(), run.end(), postingLess);
+            keys[out] = keys[i];
+            rids[out] = postingLink(createPosting(run), (int) run.size());
+            out++;
+        } else if (posting != -1) {
+            // the other entries of the key go into its posting list, which counts them in its leaf entry
+            int added = 0;
+            for (int k = i; k < end; k++) {
+                if (!isPosting(rids[k])) {
+                    addPosting(postingPageNo, rids[k]);
+                    added++;
+                }
+            }
+            // entries are only ever copied to the left, out never passes k
+            for (int k = i; k < end; k++) {
+                const RecordId rid = rids[k];
+                if (isPosting(rid)) {
+                    keys[out] = keys[k];
+                    rids[out] = (k == posting) ? postingLinkAdd(rid, added) : rid;
+                    out++;
+                }
+            }
+        } else {
+            for (int k = i; k < end; k++) {
+                keys[out] = keys[k];
+                rids[out] = rids[k];
+                out++;
+            }
+        }
+        i = end;
+    }
+    return out;
+}
+
+/**
+  * Helper method.
+  * Writes a new posting list.
+  * @param rids	Record ids of the list, at least one, in postingLess order
+  * @return	PageId of the first page of the list
+  */
+PageId BTreeIndex::createPosting(const std::vector<RecordId>& rids) {
+    const int n = (int) rids.size();
+    PageId headPageNo;
+    Page* headPage;
+    bufMgr->allocPage(file, headPageNo, headPage);
+    PostingPage* head = (PostingPage*) headPage;
+    head->totalRids = n;
+    head->prevPageNo = Page::INVALID_NUMBER;
+    head->nextPageNo = Page::INVALID_NUMBER;
+    int done = encodePostingPage(head, &rids[0], n);
+
+    // the rest of the record ids go on new pages chained after the first one
+    PageId pageNo = headPageNo;
+    PostingPage* node = head;
+    while (done < n) {
+        PageId newPageNo;
+        Page* newPage;
+        bufMgr->allocPage(file, newPageNo, newPage);
+        PostingPage* newNode = (PostingPage*) newPage;
+        newNode->totalRids = 0;
+        newNode->lastPageNo = Page::INVALID_NUMBER;
+        newNode->prevPageNo = pageNo;
+        newNode->nextPageNo = Page::INVALID_NUMBER;
+        done += encodePostingPage(newNode, &rids[done], n - done);
+        node->nextPageNo = newPageNo;
+        if (pageNo != headPageNo) {
+            bufMgr->unPinPage(file, pageNo, true);
+        }
+        pageNo = newPageNo;
+        node = newNode;
+    }
+    head->lastPageNo = pageNo;
+    if (pageNo != headPageNo) {
+        bufMgr->unPinPage(file, pageNo, true);
+    }
+    bufMgr->unPinPage(file, headPageNo, true);
+    return headPageNo;
+}
+
+/**
+  * Helper method.
+  * Adds a record id to a posting list. Appends to the last page if the record id sorts after every one in the list,
+  * else decodes and rewrites the page it sorts into, splitting the page if it overflows.
+  * The caller holds the latch of the leaf linking to the list, and counts the record id in its entry with postingLinkAdd.
+  * @param headPageNo	PageId of the first page of the list
+  * @param rid	Record id to add
+  */
+void BTreeIndex::addPosting(const PageId headPageNo, const RecordId rid) {
+    Page* headPage;
+    bufMgr->readPage(file, headPageNo, headPage);
+    PostingPage* head = (PostingPage*) headPage;
+    head->totalRids++;
+
+    // records mostly come in heap order, after the last record id of the list
+    PageId pageNo = head->lastPageNo;
+    Page* page;
+    bufMgr->readPage(file, pageNo, page);
+    PostingPage* node = (PostingPage*) page;
+    if (!postingLess(rid, node->lastRid)) {
+        if (!appendPostingPage(node, rid)) {
+            PageId newPageNo;
+            Page* newPage;
+            bufMgr->allocPage(file, newPageNo, newPage);
+            PostingPage* newNode = (PostingPage*) newPage;
+            newNode->totalRids = 0;
+            newNode->lastPageNo = Page::INVALID_NUMBER;
+            newNode->prevPageNo = pageNo;
+            newNode->nextPageNo = Page::INVALID_NUMBER;
+            newNode->numRids = 0;
+            appendPostingPage(newNode, rid);
+            node->nextPageNo = newPageNo;
+            head->lastPageNo = newPageNo;
+            bufMgr->unPinPage(file, newPageNo, true);
+        }
+        bufMgr->unPinPage(file, pageNo, true);
+        bufMgr->unPinPage(file, headPageNo, true);
+        return;
+    }
+    bufMgr->unPinPage(file, pageNo, false);
+
+    // otherwise it goes to the first page whose last record id does not sort before it, the last page at the latest
+    pageNo = headPageNo;
+    bufMgr->readPage(file, pageNo, page);
+    node = (PostingPage*) page;
+    while (postingLess(node->lastRid, rid)) {
+        PageId nextPageNo = node->nextPageNo;
+        bufMgr->unPinPage(file, pageNo, false);
+        pageNo = nextPageNo;
+        bufMgr->readPage(file, pageNo, page);
+        node = (PostingPage*) page;
+    }
+    std::vector<RecordId> rids;
+    decodePostingPage(node, rids);
+    rids.insert(std::upper_bound(rids.begin(), rids.end(), rid, postingLess), rid);
+    int done = encodePostingPage(node, &rids[0], (int) rids.size());
+
+    // the page overflowed, it keeps the first half and the rest goes on a new page after it
+    if (done < (int) rids.size()) {
+        done = encodePostingPage(node, &rids[0], (int) rids.size() / 2);
+        PageId newPageNo;
+        Page* newPage;
+        bufMgr->allocPage(file, newPageNo, newPage);
+        PostingPage* newNode = (PostingPage*) newPage;
+        newNode->totalRids = 0;
+        newNode->lastPageNo = Page::INVALID_NUMBER;
+        newNode->prevPageNo = pageNo;
+        newNode->nextPageNo = node->nextPageNo;
+        encodePostingPage(newNode, &rids[done], (int) rids.size() - done);
+        if (node->nextPageNo == Page::INVALID_NUMBER) {
+            head->lastPageNo = newPageNo;
+        } else {
+            Page* nextPage;
+            bufMgr->readPage(file, node->nextPageNo, nextPage);
+            ((PostingPage*) nextPage)->prevPageNo = newPageNo;
+            bufMgr->unPinPage(file, node->nextPageNo, true);
+        }
+        node->nextPageNo = newPageNo;
+        bufMgr->unPinPage(file, newPageNo, true);
+    }
+    bufMgr->unPinPage(file, pageNo, true);
+    bufMgr->unPinPage(file, headPageNo, true);
+}
+
+/**
+  * Helper method.
+  * @param link	Record id of a leaf entry linking to a posting list
+  * @return	Number of record ids in the list. Taken from the entry, only lists longer than MAXPOSTINGCOUNT read the first page
+  */
+int BTreeIndex::postingSize(const RecordId& link) {
+    if (postingLinkCount(link) < MAXPOSTINGCOUNT) {
+        return postingLinkCount(link);
+    }
+    Page* page;
+    bufMgr->readPage(file, link.page_number, page);
+    int size = ((PostingPage*) page)->totalRids;
+    bufMgr->unPinPage(file, link.page_number, false);
+    return size;
+}
+
+/**
+  * Helper method.
+  * @param headPageNo	PageId of the first page of a posting list
+  * @param backward	True for the page a BACKWARD copy starts at, the last one
+  * @return	PageId of the page a copy of the list starts at
+  */
+PageId BTreeIndex::postingStart(const PageId headPageNo, const bool backward) {
+    if (!backward) {
+        return headPageNo;
+    }
+    Page* page;
+    bufMgr->readPage(file, headPageNo, page);
+    PageId lastPageNo = ((PostingPage*) page)->lastPageNo;
+    bufMgr->unPinPage(file, headPageNo, false);
+    return lastPageNo;
+}
+
+/**
+  * Helper method.
+  * @param headPageNo	PageId of the first page of a posting list
+  * @param i	Position in the list, less than postingSize
+  * @return	Record id at position i of the list
+  */
+RecordId BTreeIndex::postingRidAt(const PageId headPageNo, int i) {
+    PageId pageNo = headPageNo;
+    Page* page;
+    bufMgr->readPage(file, pageNo, page);
+    PostingPage* node = (PostingPage*) page;
+    // whole pages are skipped by their counts, only the page holding the position is decoded
+    while (i >= node->numRids && node->nextPageNo != Page::INVALID_NUMBER) {
+        i -= node->numRids;
+        PageId nextPageNo = node->nextPageNo;
+        bufMgr->unPinPage(file, pageNo, false);
+        pageNo = nextPageNo;
+        bufMgr->readPage(file, pageNo, page);
+        node = (PostingPage*) page;
+    }
+    std::vector<RecordId> rids;
+    decodePostingPage(node, rids);
+    bufMgr->unPinPage(file, pageNo, false);
+    // the counts of the leaves and the list agree, so the position is always in the list
+    assert(i >= 0 && i < (int) rids.size());
+    return rids[i];
+}
+
+/**
+  * Helper method.
+  * Copies up to max record ids of a posting list, in list order or reversed, from its start or after the record id a
+  * previous copy stopped at. The list is sorted, so the copy goes on right after that record id even if record ids
+  * were added to the list or its pages were split since. A record id can be in the list more than once, so the copy
+  * also skips the copies of it already returned.
+  * @param pageNo	Page to start at: the first page of the list, or the last one in a BACKWARD copy, or the page a previous
+  *                 copy stopped on. Set to the page the copy stopped on, Page::INVALID_NUMBER when it reached the end of the list
+  * @param lastRid	Record id a previous copy stopped at, set to the last one copied
+  * @param lastRidCopies	Number of copies of lastRid returned so far, updated with the ones copied
+  * @param resume	True to go on after lastRid, false to copy from the start of the list
+  * @param backward	True to copy in reverse order
+  * @param out	Array the record ids are copied to
+  * @param max	Maximum number of record ids to copy
+  * @return	Number of record ids copied
+  */
+size_t BTreeIndex::copyPosting(PageId& pageNo, RecordId& lastRid, int& lastRidCopies, const bool resume, const bool backward,
+                               RecordId* out, size_t max) {
+    Page* page;
+    bufMgr->readPage(file, pageNo, page);
+    PostingPage* node = (PostingPage*) page;
+    if (resume) {
+        // the page the last copy stopped on keeps the record ids before lastRid, a split moves later ones to new pages
+        // after it. Find the page holding the first copy of lastRid, or the last copy for a BACKWARD copy
+        while (node->prevPageNo != Page::INVALID_NUMBER &&
+               (backward ? postingLess(lastRid, node->firstRid) : !postingLess(node->firstRid, lastRid))) {
+            PageId prevPageNo = node->prevPageNo;
+            bufMgr->unPinPage(file, pageNo, false);
+            pageNo = prevPageNo;
+            bufMgr->readPage(file, pageNo, page);
+            node = (PostingPage*) page;
+        }
+        while (node->nextPageNo != Page::INVALID_NUMBER &&
+               (backward ? !postingLess(lastRid, node->lastRid) : postingLess(node->lastRid, lastRid))) {
+            PageId nextPageNo = node->nextPageNo;
+            bufMgr->unPinPage(file, pageNo, false);
+            pageNo = nextPageNo;
+            bufMgr->readPage(file, pageNo, page);
+            node = (PostingPage*) page;
+        }
+    }
+
+    std::vector<RecordId> rids;
+    size_t count = 0;
+    int skip = resume ? lastRidCopies : 0;
+    bool first = resume;
+    while (true) {
+        decodePostingPage(node, rids);
+        const PageId nextPageNo = backward ? node->prevPageNo : node->nextPageNo;
+        bufMgr->unPinPage(file, pageNo, false);
+
+        // copies of lastRid already returned are skipped, they may go on over the next pages
+        const int size = (int) rids.size();
+        bool full = false;
+        if (backward) {
+            int i = first ? (int) (std::upper_bound(rids.begin(), rids.end(), lastRid, postingLess) - rids.begin()) - 1 : size - 1;
+            const int skipped = std::min(skip, i + 1);
+            i -= skipped;
+            skip -= skipped;
+            while (i >= 0 && count < max) {
+                out[count++] = rids[i--];
+            }
+            full = i >= 0;
+        } else {
+            int i = first ? (int) (std::lower_bound(rids.begin(), rids.end(), lastRid, postingLess) - rids.begin()) : 0;
+            const int skipped = std::min(skip, size - i);
+            i += skipped;
+            skip -= skipped;
+            while (i < size && count < max) {
+                out[count++] = rids[i++];
+            }
+            full = i < size;
+        }
+        first = false;
+        if (full) {
+            break;
+        }
+        pageNo = nextPageNo;
+        if (pageNo == Page::INVALID_NUMBER) {
+            break;
+        }
+        bufMgr->readPage(file, pageNo, page);
+        node = (PostingPage*) page;
+    }
+
+    // count the copies of the new last record id, adding to the ones returned before when all copied are of it
+    if (count > 0) {
+        int copies = 1;
+        while (copies < (int) count && out[count - 1 - copies] == out[count - 1]) {
+            copies++;
+        }
+        lastRidCopies = (resume && copies == (int) count && lastRid == out[count - 1]) ? lastRidCopies + copies : copies;
+        lastRid = out[count - 1];
+    }
+    return count;
+}
+
+/**
+  * Helper method.
+  * @param rids	Record ids of leaf entries
+  * @param first	Position of the first entry to count
+  * @param last	Position past the last entry to count
+  * @return	Number of record ids the entries stand for, posting lists counted by the size kept in their entry
+  */
+int BTreeIndex::ridCount(const LeafRid* rids, const int first, const int last) {
+    int count = 0;
+    for (int i = first; i < last; i++) {
+        const RecordId rid = rids[i];
+        count += isPosting(rid) ? postingSize(rid) : 1;
+    }
+    return count;
+}
+
+/**
+  * Helper method.
+  * Latches the internal node specified by pageNo and finds the child childPageNo among its children.
+  * If a concurrent split moved the child to a right sibling of the node, moves right until it finds it.
+  * @param key   A key in the key range of the child, at or below its smallest key is enough
+  * @param pageNo PageId of the node to start at, replaced by the PageId of the node holding the child
+  * @param page  The node holding the child, returned pinned and latched
+  * @param childPageNo PageId of the child
+  * @return  Position of the child among the children of the node
+  */
+template <class T>
+int BTreeIndex::latchParent(const T& key, PageId &pageNo, Page* &page, const PageId childPageNo) {
+    bufMgr->readPage(file, pageNo, page);
+    bufMgr->latchPage(page);
+    NonLeafNode<T>* node = (NonLeafNode<T>*) page;  // the assumption is that a page is a node
+
+    // no key before the child is greater than 'key', so start at the first key >= 'key'
+    // and locate it by page number from there, which also works when separator keys repeat.
+    // If it is not in this node, a concurrent split moved it to a right sibling
+    while (true) {
+        int childIndex = nodeLowerBound(node, node->numOccupied, key);
+        while (childIndex <= node->numOccupied && nodeChild(node, childIndex) != childPageNo) {
+            childIndex++;
+        }
+        if (childIndex <= node->numOccupied) {
+            return childIndex;
+        }
+        PageId rightSibPageNo = node->rightSibPageNo;
+        bufMgr->unlatchPage(page);
+        bufMgr->unPinPage(file, pageNo, false);
+        pageNo = rightSibPageNo;
+        bufMgr->readPage(file, pageNo, page);
+        bufMgr->latchPage(page);
+        node = (NonLeafNode<T>*) page;
+    }
+}
+
+/**
+  * Helper method.
+  * Adds the entries an insert put into a node to the subtree counts of its ancestors, from the parent up to the root.
+  * Each node stays latched until its parent is, as in a split. So when a node is latched, every insert below it has
+  * counted its entries in the parent, and a split can hand the exact counts of its two halves to the parent.
+  * @param key   A key in the key range of the node, used to find the parent again if the tree grew
+  * @param pageNo PageId of the node the entries went into
+  * @param page  The node, pinned and latched by the caller, its own entries or counts already updated. Released here.
+  * @param delta  Number of entries inserted below the node
+  * @param height  Height of the node above the leaves, 0 for a leaf
+  * @param path  Path of non-leaf nodes visited from the root
+  */
+template <class T>
+void BTreeIndex::countUp(const T& key, PageId pageNo, Page* page, const int delta, int height, TreePath &path) {
+    while (true) {
+        PageId parentPageNo;
+        if (path.depth == 0) {
+            {
+                std::lock_guard<std::mutex> guard(rootMutex);
+                if (rootPageNum == pageNo) {
+                    break;
+                }
+            }
+            // the tree grew after the node was found, look for its parent from the new root as insertParent does
+            searchEntry(key, parentPageNo, path, height + 1);
+        } else {
+            path.depth--;  // move up one level on the path
+            parentPageNo = path.pageNoArray[path.depth];
+        }
+
+        Page* parentPage;
+        int childIndex = latchParent(key, parentPageNo, parentPage, pageNo);
+        bufMgr->unlatchPage(page);
+        bufMgr->unPinPage(file, pageNo, true);
+        NonLeafNode<T>* parentNode = (NonLeafNode<T>*) parentPage;
+        setNodeCount(parentNode, childIndex, nodeCount(parentNode, childIndex) + delta);
+        pageNo = parentPageNo;
+        page = parentPage;
+        height++;
+    }
+    bufMgr->unlatchPage(page);
+    bufMgr->unPinPage(file, pageNo, true);
+}
+
+template <class T>
+void BTreeIndex::countLater(const PageId pageNo, Page* page, const int delta) {
+    LeafNode<T>* node = (LeafNode<T>*) page;
+    if (node->pendingCount == 0) {
+        std::lock_guard<std::mutex> guard(pendingMutex);
+        pendingLeaves.push_back(pageNo);
+    }
+    node->pendingCount += delta;
+    bufMgr->unlatchPage(page);
+    bufMgr->unPinPage(file, pageNo, true);
+}
+
+void BTreeIndex::flushCounts() {
+    switch (attributeType) {
+        case INTEGER:
+            flushCountsTyped<int>();
+            break;
+        case DOUBLE:
+            flushCountsTyped<DoubleKey>();
+            break;
+        case STRING:
+            flushCountsTyped<StringKey>();
+            break;
+        case COMPOSITE:
+            flushCountsTyped<CompositeKey>();
+            break;
+        case COVERING:
+            flushCountsTyped<CoveringKey>();
+            break;
+    }
+}
+
+template <class T>
+void BTreeIndex::flushCountsTyped() {
+    std::vector<PageId> pageNos;
+    {
+        std::lock_guard<std::mutex> guard(pendingMutex);
+        pageNos.swap(pendingLeaves);
+    }
+    for (size_t l = 0; l < pageNos.size(); l++) {
+        Page* page;
+        bufMgr->readPage(file, pageNos[l], page);
+        bufMgr->latchPage(page);
+        LeafNode<T>* node = (LeafNode<T>*) page;
+        // a split since the leaf was listed already passed its pending entries up
+        const int delta = node->pendingCount;
+        if (delta == 0) {
+            bufMgr->unlatchPage(page);
+            bufMgr->unPinPage(file, pageNos[l], false);
+            continue;
+        }
+        node->pendingCount = 0;
+        // countUp finds the parent from the root with an empty path, the leaf holds entries since some are pending
+        const T key = node->keyArray[0];
+        TreePath path;
+        path.depth = 0;
+        countUp(key, pageNos[l], page, delta, 0, path);
+    }
+}
+
+/**
+  * Helper method.
+  * Inserts the key that was propagated up into the internal node specified by pageNo, right after the child leftPageNo that was split.
+  * If a concurrent split moved the child to a right sibling of the node, the insert moves right until it finds it.
+  * If the internal node has enough space, we insert. Otherwise, we split by calling splitInternal.
+  * The two halves get the entry counts the split passes up, and the entries the split added are counted in the ancestors.
+  * @param key   Key to insert, the separator before the subtree newPageNo, at most its smallest key
+  * @param pageNo PageId of a Page/node, this is being passed in from caller method.
+  * @param leftPageNo PageId of the child that was split
+  * @param leftPage  The child that was split, pinned and latched by the caller. Released once the node holding it is latched.
+  * @param leftCount  Number of entries in the subtree of leftPageNo after the split
+  * @param newPageNo PageId of a Page/node created after split. const because we prevent modifying it
+  * @param newCount  Number of entries in the subtree of newPageNo
+  * @param height  Height of the node pageNo above the leaves, 1 for the level right above them
+  * @param path  Path of non-leaf nodes visited from the root, used in splitting
+  */
+template <class T>
+void BTreeIndex::insertEntryInternal(const T& key, PageId pageNo, const PageId leftPageNo, Page* leftPage, const int leftCount, const PageId newPageNo, const int newCount, const int height, TreePath &path) {
+    Page* currPage;  // page to read into
+    int childIndex = latchParent(key, pageNo, currPage, leftPageNo);
+    NonLeafNode<T>* currInternalNode = (NonLeafNode<T>*) currPage;  // the assumption is that a page is a node
+
+    // the new key lands in this node, which is latched now, so the child can be released
+    bufMgr->unlatchPage(leftPage);
+    bufMgr->unPinPage(file, leftPageNo, true);
+
+    // Two general cases: if internal node is not full or internal node is full
+    // 1. first check if overflow occurs, i.e. not enough room to insert into current internal node, we need to perform split
+    if (!nodeHasRoom(currInternalNode, key)) {
+        splitInternal(key, pageNo, currPage, childIndex, leftCount, newPageNo, newCount, height, path);  // calls helper method splitInternal, which releases the node
+
+    // 2. if there is enough open spots to insert into current internal node,
+    // the key goes right after the child that was split and the new node becomes the child on its right
+    } else {
+        // the count of the split child was exact, so the difference is what the split added
+        const int delta = leftCount + newCount - nodeCount(currInternalNode, childIndex);
+        // move all keys after the split child, and the children on their right, upward by 1 index
+        insertNodeKey(currInternalNode, childIndex, key, newPageNo, newCount);
+        setNodeCount(currInternalNode, childIndex, leftCount);
+        countUp(key, pageNo, currPage, delta, height, path);  // releases the curr node
+    }
+}
+
+/**
+  * Helper method.
+  * Splits an internal Page/node after an overflow in internal node
+  * Of the numOccupied+1 keys, the left node keeps the first half, the middle key is pushed up and the new node gets the rest.
+  * @param key   Key to insert
+  * @param pageNo PageId of a Page/node, this is being passed in from caller method.
+  * @param page  The internal node, pinned and latched by the caller. Released here.
+  * @param childIndex  Position of the child that was split among the children of the node
+  * @param leftCount  Number of entries in the subtree of the child that was split
+  * @param newPageNo PageId of a Page/node created after split. const because we prevent modifying it
+  * @param newCount  Number of entries in the subtree of newPageNo
+  * @param height  Height of the node pageNo above the leaves
+  * @param path  Path of non-leaf nodes visited from the root, used in splitting
+  */
+template <class T>
+void BTreeIndex::splitInternal(const T& key, const PageId pageNo, Page* page, const int childIndex, const int leftCount, const PageId newPageNo, const int newCount, const int height, TreePath &path) {
+    NonLeafNode<T>* currInternalNode = (NonLeafNode<T>*) page;  // the assumption is that a page is a node
+
+    Page* newPageTemp;  // new page to split into
+    PageId newPageNoTemp;
+    bufMgr->allocPage(file, newPageNoTemp, newPageTemp);
+    NonLeafNode<T>* newInternalNode = (NonLeafNode<T>*) newPageTemp;  // new internal node
+    newInternalNode->level = currInternalNode->level;
+
+    // Lay out the node after insertion as numOccupied+1 keys and numOccupied+2 children, then deal them out to the two nodes.
+    // keys [0, middle) stay in the curr node, key middle is pushed up, and the keys after it move to the new node
+    const int numOccupied = currInternalNode->numOccupied;
+    std::vector<typename KeyTraits<T>::NodeKey> keys;
+    std::vector<PageId> pageNos;
+    std::vector<int> counts;
+    for (int i = 0; i < numOccupied; i++) {
+        keys.push_back(nodeKey(currInternalNode, i));
+    }
+    for (int i = 0; i <= numOccupied; i++) {
+        pageNos.push_back(nodeChild(currInternalNode, i));
+        counts.push_back(nodeCount(currInternalNode, i));
+    }
+    keys.insert(keys.begin() + childIndex, key);
+    pageNos.insert(pageNos.begin() + childIndex + 1, newPageNo);
+    counts[childIndex] = leftCount;
+    counts.insert(counts.begin() + childIndex + 1, newCount);
+
+    const bool append = currInternalNode->rightSibPageNo == Page::INVALID_NUMBER && childIndex == numOccupied;
+    int middle = splitPoint(numOccupied + 1, (numOccupied + 1) / 2, append);
+    clearNode(currInternalNode, pageNos[0], counts[0]);
+    int currTotal = counts[0];
+    for (int i = 0; i < middle; i++) {
+        // the separators of a STRING node differ in length, so the first half by count may not fit, then the split moves left
+        if (!nodeHasRoom(currInternalNode, keys[i])) {
+            middle = i;
+            break;
+        }
+        insertNodeKey(currInternalNode, i, keys[i], pageNos[i + 1], counts[i + 1]);
+        currTotal += counts[i + 1];
+    }
+    T propagateUpKey = keys[middle];
+
+    clearNode(newInternalNode, pageNos[middle + 1], counts[middle + 1]);
+    int newTotal = counts[middle + 1];
+    for (int i = middle + 1; i <= numOccupied; i++) {
+        insertNodeKey(newInternalNode, i - middle - 1, keys[i], pageNos[i + 1], counts[i + 1]);
+        newTotal += counts[i + 1];
+    }
+
+    // the new node takes over the right link and high key of the curr node, which now ends at the pushed up key
+    newInternalNode->rightSibPageNo = currInternalNode->rightSibPageNo;
+    newInternalNode->highKey = currInternalNode->highKey;
+    currInternalNode->rightSibPageNo = newPageNoTemp;
+    currInternalNode->highKey = propagateUpKey;
+    bufMgr->unPinPage(file, newPageNoTemp, true);
+
+    insertParent(propagateUpKey, pageNo, page, currTotal, newPageNoTemp, newTotal, height, path);
+}
+
+/**
+  * Helper method.
+  * Inserts the separator of a split node into its parent, the last node on the path. If the path is used up, the split node
+  * is either still the root, and the tree grows by one level, or another inserter grew the tree meanwhile, and the parent
+  * is found by descending again from the new root. The split node stays latched until its parent is.
+  * @param key   Separator, at most the smallest key of the subtree newPageNo
+  * @param leftPageNo PageId of the node that was split
+  * @param leftPage  The node that was split, pinned and latched by the caller. Released here.
+  * @param leftCount  Number of entries in the subtree of leftPageNo after the split
+  * @param newPageNo PageId of the node created by the split
+  * @param newCount  Number of entries in the subtree of newPageNo
+  * @param height  Height of the split node above the leaves, 0 for a leaf
+  * @param path  Path of non-leaf nodes visited from the root
+  */
+template <class T>
+void BTreeIndex::insertParent(const T& key, const PageId leftPageNo, Page* leftPage, const int leftCount, const PageId newPageNo, const int newCount, const int height, TreePath &path) {
+    PageId parentPageNo;
+    if (path.depth == 0) {
+        {
+            std::lock_guard<std::mutex> guard(rootMutex);
+            if (rootPageNum == leftPageNo) {
+                growRoot(key, leftPageNo, leftCount, newPageNo, newCount, height);
+                bufMgr->unlatchPage(leftPage);
+                bufMgr->unPinPage(file, leftPageNo, true);
+                return;
+            }
+        }
+        // the node was split off the root by another inserter, which grew the tree before releasing the root.
+        // Find the parent from the new root; the descent stops above the split node, so it does not latch it again
+        searchEntry(key, parentPageNo, path, height + 1);
+    } else {
+        path.depth--;  // move up one level on the path
+        parentPageNo = path.pageNoArray[path.depth];  // gets the parent internal node one level above
+    }
+    insertEntryInternal(key, parentPageNo, leftPageNo, leftPage, leftCount, newPageNo, newCount, height + 1, path);
+}
+
+/**
+  * Helper method.
+  * Grows the tree by one level after the root was split: allocates a new root holding the two halves and records it in the meta page.
+  * Called with rootMutex held.
+  * @param key   Separator of the two halves, at most the smallest key of the right half
+  * @param leftPageNo PageId of the old root, now the left half
+  * @param leftCount  Number of entries in the left half
+  * @param rightPageNo PageId of the right half
+  * @param rightCount  Number of entries in the right half
+  * @param height  Height of the old root above the leaves, 0 if it was a leaf
+  */
+template <class T>
+void BTreeIndex::growRoot(const T& key, const PageId leftPageNo, const int leftCount, const PageId rightPageNo, const int rightCount, const int height) {
+    PageId rootId; // page to read into
+    Page* rootPage;
+    bufMgr->allocPage(file, rootId, rootPage);
+    NonLeafNode<T>* rootNode = (NonLeafNode<T>*) rootPage;  // new root node
+
+    clearNode(rootNode, leftPageNo, leftCount);
+    insertNodeKey(rootNode, 0, key, rightPageNo, rightCount);  // we insert key into this new internal node
+    rootNode->level = (height == 0) ? 1 : 0;  // 1 if the old root was a leaf
+    rootNode->rightSibPageNo = Page::INVALID_NUMBER;  // the root is alone on its level
+
+    bufMgr->unPinPage(file, rootId, true);  // unpin curr page for buffer manager
+    onlyOneRoot = false;  // set this to false since we are on internal node
+    rootPageNum = rootId;  // update root for this B+ tree index
+    treeHeight = height + 1;
+
+    Page * metaPage;  // initialize the meta page according to btree.h
+    bufMgr->readPage(file, headerPageNum, metaPage);
+    IndexMetaInfo* metadata = (IndexMetaInfo*) metaPage;
+    metadata->rootPageNo = rootId;
+    metadata->rootIsLeaf = false;
+    metadata->treeHeight = treeHeight;
+    bufMgr->unPinPage(file, headerPageNum, true);  // remember to unpin
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::bulkLoad
+// -----------------------------------------------------------------------------
+
+/**
+  * Helper method.
+  * Builds the whole tree bottom-up from the tuples of the base relation instead of inserting them one at a time.
+  * The key-rid pairs are collected with FileScan and sorted. Pairs that do not fit in the sort budget (half of the
+  * buffer pool) are spilled as sorted runs to a temporary file through the buffer manager and merged afterwards.
+  * The sorted stream is packed into leaves, and the non-leaf levels are then packed from the leaves, so every page is written once.
+  * @param relationName  Name of the base relation
+  * @param indexName  Name of the index file, used to name the temporary sort file
+  * @param fillFactor  Fraction of each node that is filled
+  */
+template <class T>
+void BTreeIndex::bulkLoad(const std::string & relationName, const std::string & indexName, const float fillFactor) {
+    // create the metadata (header) page, it stays pinned until the root page is known
+    Page *metaPage;
+    bufMgr->allocPage(file, headerPageNum, metaPage);
+    IndexMetaInfo *metadata = (IndexMetaInfo *) metaPage;
+    strcpy(metadata->relationName, relationName.c_str());
+    metadata->attrByteOffset = attrByteOffset;
+    metadata->attrType = attributeType;
+    metadata->leafRidSize = sizeof(LeafRid);
+    metadata->numKeyAttrs = numKeyAttrs;
+    std::copy(keyAttrs, keyAttrs + numKeyAttrs, metadata->keyAttrs);
+    metadata->numIncludeAttrs = numIncludeAttrs;
+    std::copy(includeAttrs, includeAttrs + numIncludeAttrs, metadata->includeAttrs);
+    metadata->recordSize = recordSize;
+
+    // the sort budget is half of the buffer pool, the other half is left for the scan, the merge and the tree pages
+    const int runCapacity = std::max(1, (int) bufMgr->getNumBufs() / 2) * SortRunPage<T>::capacity(recordSize);
+    const std::string sortFileName = indexName + ".sort";
+    File *sortFile = NULL;  // only created once the pairs do not fit in the sort budget
+    std::vector< RIDKeyPair<T> > pairs;
+    std::vector<char> records;  // records of the pairs in a clustered index, recordSize bytes each
+    std::vector<SortRun> runs;
+    int numEntries = 0;
+
+    // collect a key-rid pair for every tuple in the base relation using FileScan class
+    {
+        FileScan fscan(relationName, bufMgr);
+        try {
+            RecordId scanRid;
+            while(1) {
+                fscan.scanNext(scanRid);
+                std::string recordStr = fscan.getRecord();
+                const char *record = recordStr.c_str();
+                RIDKeyPair<T> pair;
+                pair.set(scanRid, keyFromRecord<T>(record));
+                pairs.push_back(pair);
+                if (recordSize > 0) {
+                    const size_t offset = records.size();
+                    records.resize(offset + recordSize, 0);
+                    memcpy(&records[offset], record, std::min((size_t) recordSize, recordStr.size()));
+                }
+                numEntries++;
+
+                // spill a sorted run once the sort budget is used up
+                if ((int) pairs.size() >= runCapacity) {
+                    if (sortFile == NULL) {
+                        // remove a sort file left behind by a run that crashed
+                        try {
+                            File::remove(sortFileName);
+                        } catch(const FileNotFoundException &e) {
+                        }
+                        sortFile = (File *) new BlobFile(sortFileName, true);
                     }
-                    newInternalNode->numOccupied ++;
+                    writeSortRun(sortFile, pairs, records, runs);
                 }
-                insertedFlag = true;
-            }
-            // at this point, the key must has been inserted, we copy old keys/nodes from currInternalNode over to newInternalNode.
-            // if the propagate up value has been pushed up, we reposition curr Internal Node by moving every index down by 1 for (newInternalNode->numOccupied-1) times
-            if (newInternalNode->numOccupied > capacity) {
-                currInternalNode->keyArray[i-(newInternalNode->numOccupied-1)] = currInternalNode->keyArray[i];
-                currInternalNode->pageNoArray[i-(newInternalNode->numOccupied-1)] =   currInternalNode->pageNoArray[i];
-
-            // if the new internal node has open slots, we copy old keys/nodes from currInternalNode over to newInternalNode.
-            } else if (newInternalNode->numOccupied < capacity) {
-                newInternalNode->keyArray[i+1] = currInternalNode->keyArray[i];
-                newInternalNode->pageNoArray[i+1] = currInternalNode->pageNoArray[i];
-                newInternalNode->numOccupied += 1;
-                currInternalNode->numOccupied -= 1;
-
-            // else if the new internal node is full (newInternalNode->numOccupied == capacity), we split and propagate up the middle key in the curr internal node
-            // Note that when splitting an internal node, we do not need to preserve the propagate up key because it can just be pushed up    
+            }
+
+        // check if reach the end of the relation file
+        } catch(const EndOfFileException &e) {
+            // all records have been read
+        }
+    }
+
+    // spread the entries evenly over as many leaves as the fill factor requires
+    const int leafCapacity = std::min(leafOccupancy, std::max(1, (int) (leafOccupancy * fillFactor)));
+    BulkLoadState<T> state;
+    state.numEntries = numEntries;
+    state.numLeaves = std::max(1, (numEntries + leafCapacity - 1) / leafCapacity);
+    state.leavesStarted = 0;
+    state.leafTarget = 0;
+    state.leafPageNo = Page::INVALID_NUMBER;
+    state.leafPage = NULL;
+
+    if (sortFile == NULL) {
+        // everything fit in memory, sort it in place and pack the leaves directly
+        sortEntries(pairs, records);
+        for (size_t i = 0; i < pairs.size(); i++) {
+            bulkLoadAppend(pairs[i], (recordSize > 0) ? &records[i * recordSize] : NULL, state);
+        }
+    } else {
+        // write out the last partial run and merge all runs into the leaves
+        if (!pairs.empty()) {
+            writeSortRun(sortFile, pairs, records, runs);
+        }
+        mergeSortRuns(sortFile, runs, state);
+        bufMgr->flushFile(sortFile);
+        delete sortFile;
+        File::remove(sortFileName);
+    }
+    bulkLoadFinish(state, fillFactor);
+
+    // the root is the last page written, record it in the meta page
+    metadata->rootPageNo = rootPageNum;
+    metadata->rootIsLeaf = onlyOneRoot;
+    metadata->treeHeight = treeHeight;
+    bufMgr->unPinPage(file, headerPageNum, true);
+}
+
+/**
+  * Helper method.
+  * Sorts the pairs collected in memory, moving the records collected with them in a clustered index along.
+  * @param pairs  Pairs collected in memory
+  * @param records  Records of the pairs in the same order, recordSize bytes each. Empty for an index of record ids
+  */
+template <class T>
+void BTreeIndex::sortEntries(std::vector< RIDKeyPair<T> > &pairs, std::vector<char> &records) {
+    if (recordSize == 0) {
+        std::sort(pairs.begin(), pairs.end());
+        return;
+    }
+    // the pairs are sorted with their positions, then every record is moved once
+    std::vector< std::pair< RIDKeyPair<T>, int > > order(pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        order[i] = std::make_pair(pairs[i], (int) i);
+    }
+    std::sort(order.begin(), order.end());
+    std::vector<char> sorted(records.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        pairs[i] = order[i].first;
+        memcpy(&sorted[i * recordSize], &records[(size_t) order[i].second * recordSize], recordSize);
+    }
+    records.swap(sorted);
+}
+
+/**
+  * Helper method.
+  * Sorts the pairs collected in memory and writes them out as a new sorted run to the temporary sort file.
+  * @param sortFile  Temporary sort file
+  * @param pairs  Pairs collected in memory, cleared on return
+  * @param records  Records of the pairs in a clustered index, written into the run with them and cleared on return
+  * @param runs  List of runs written so far, the new run is appended to it
+  */
+template <class T>
+void BTreeIndex::writeSortRun(File *sortFile, std::vector< RIDKeyPair<T> > &pairs, std::vector<char> &records, std::vector<SortRun> &runs) {
+    sortEntries(pairs, records);
+
+    SortRun run;
+    run.numPairs = pairs.size();
+    size_t i = 0;
+    while (i < pairs.size()) {
+        PageId runPageNo;
+        Page *runPage;
+        bufMgr->allocPage(sortFile, runPageNo, runPage);
+        SortRunPage<T> *runNode = (SortRunPage<T> *) runPage;
+        runNode->numOccupied = 0;
+        // fill the page, then let the buffer manager write it out when it needs the frame
+        while (i < pairs.size() && runNode->numOccupied < SortRunPage<T>::capacity(recordSize)) {
+            runNode->setEntry(runNode->numOccupied, recordSize, pairs[i], (recordSize > 0) ? &records[i * recordSize] : NULL);
+            runNode->numOccupied++;
+            i++;
+        }
+        bufMgr->unPinPage(sortFile, runPageNo, true);
+        run.pageNos.push_back(runPageNo);
+    }
+    runs.push_back(run);
+    pairs.clear();
+    records.clear();
+}
+
+/**
+  * Helper method.
+  * Merges the sorted runs and feeds the merged stream to the leaf level. When there are more runs than can be merged
+  * at once with the buffer pool, groups of runs are first merged into longer runs until one pass is enough.
+  * @param sortFile  Temporary sort file
+  * @param runs  Runs to merge
+  * @param state  Bulk load state of the leaf level
+  */
+template <class T>
+void BTreeIndex::mergeSortRuns(File *sortFile, std::vector<SortRun> &runs, BulkLoadState<T> &state) {
+    // every run being merged keeps one page pinned, so merge at most half of the buffer pool worth of runs at once
+    const int fanIn = std::max(2, (int) bufMgr->getNumBufs() / 2);
+    while ((int) runs.size() > fanIn) {
+        std::vector<SortRun> mergedRuns;
+        for (int first = 0; first < (int) runs.size(); first += fanIn) {
+            int count = std::min(fanIn, (int) runs.size() - first);
+            // a group with a single run is already sorted, carry it over to the next pass as is
+            if (count == 1) {
+                mergedRuns.push_back(runs[first]);
+                continue;
+            }
+            SortRun mergedRun;
+            mergeRunGroup(sortFile, runs, first, count, &mergedRun, state);
+            mergedRuns.push_back(mergedRun);
+        }
+        runs.swap(mergedRuns);
+    }
+    mergeRunGroup(sortFile, runs, 0, runs.size(), NULL, state);
+}
+
+/**
+  * Helper method.
+  * Merges runs [first, first+count) of the list. The merged pairs are appended to outRun if it is given, otherwise to the leaf level.
+  * @param sortFile  Temporary sort file
+  * @param runs  Runs to merge
+  * @param first  Index of the first run to merge
+  * @param count  Number of runs to merge
+  * @param outRun  Run to write the merged pairs to, or NULL to send them to the leaf level
+  * @param state  Bulk load state of the leaf level
+  */
+template <class T>
+void BTreeIndex::mergeRunGroup(File *sortFile, std::vector<SortRun> &runs, const int first, const int count, SortRun *outRun, BulkLoadState<T> &state) {
+    typedef std::pair< RIDKeyPair<T>, int > HeadPair;  // head pair of a run and the run it came from
+    std::priority_queue< HeadPair, std::vector<HeadPair>, std::greater<HeadPair> > heads;
+    std::vector<Page *> runPages(count, NULL);  // current page of every run, kept pinned while it is consumed
+    std::vector<int> pageIndex(count, 0);  // position of the current page within its run
+    std::vector<int> slot(count, 0);  // position of the head pair within the current page
+
+    // pin the first page of every run and put its first pair in the heap
+    for (int r = 0; r < count; r++) {
+        if (runs[first + r].pageNos.empty()) {
+            continue;
+        }
+        bufMgr->readPage(sortFile, runs[first + r].pageNos[0], runPages[r]);
+        heads.push(std::make_pair(((SortRunPage<T> *) runPages[r])->pairAt(0, recordSize), r));
+    }
+
+    PageId outPageNo = Page::INVALID_NUMBER;
+    Page *outPage = NULL;
+    if (outRun != NULL) {
+        outRun->numPairs = 0;
+    }
+
+    while (!heads.empty()) {
+        HeadPair head = heads.top();
+        heads.pop();
+
+        // emit the smallest pair with its record, which is still on the pinned page of its run, either to the leaf level or to the output run
+        int r = head.second;
+        const char *record = ((SortRunPage<T> *) runPages[r])->recordAt(slot[r], recordSize);
+        if (outRun == NULL) {
+            bulkLoadAppend(head.first, (recordSize > 0) ? record : NULL, state);
+        } else {
+            if (outPage == NULL || ((SortRunPage<T> *) outPage)->numOccupied == SortRunPage<T>::capacity(recordSize)) {
+                if (outPage != NULL) {
+                    bufMgr->unPinPage(sortFile, outPageNo, true);
+                }
+                bufMgr->allocPage(sortFile, outPageNo, outPage);
+                ((SortRunPage<T> *) outPage)->numOccupied = 0;
+                outRun->pageNos.push_back(outPageNo);
+            }
+            SortRunPage<T> *outNode = (SortRunPage<T> *) outPage;
+            outNode->setEntry(outNode->numOccupied, recordSize, head.first, record);
+            outNode->numOccupied++;
+            outRun->numPairs++;
+        }
+
+        // advance the run the pair came from, moving on to its next page once the current one is used up
+        slot[r]++;
+        if (slot[r] == ((SortRunPage<T> *) runPages[r])->numOccupied) {
+            bufMgr->unPinPage(sortFile, runs[first + r].pageNos[pageIndex[r]], false);
+            runPages[r] = NULL;
+            pageIndex[r]++;
+            slot[r] = 0;
+            if (pageIndex[r] == (int) runs[first + r].pageNos.size()) {
+                continue;  // run is exhausted
+            }
+            bufMgr->readPage(sortFile, runs[first + r].pageNos[pageIndex[r]], runPages[r]);
+        }
+        heads.push(std::make_pair(((SortRunPage<T> *) runPages[r])->pairAt(slot[r], recordSize), r));
+    }
+
+    if (outPage != NULL) {
+        bufMgr->unPinPage(sortFile, outPageNo, true);
+    }
+}
+
+/**
+  * Helper method.
+  * Appends a pair to the leaf level being bulk loaded. Entries are spread evenly over the leaves,
+  * and a new leaf is started once the current one has received its share. A run of POSTINGTHRESHOLD entries of one key
+  * at the end of the leaf moves into a posting list, which the following entries of the key are added to.
+  * A leaf of a clustered index copies the record of the pair instead, and has no posting lists.
+  * @param pair  Next pair in sorted order
+  * @param record  Record of the pair in a clustered index, recordSize bytes. NULL for an index of record ids
+  * @param state  Bulk load state of the leaf level
+  */
+template <class T>
+void BTreeIndex::bulkLoadAppend(const RIDKeyPair<T> &pair, const char *record, BulkLoadState<T> &state) {
+    if (state.leafPage != NULL && attributeType != COVERING && recordSize == 0) {
+        LeafNode<T> *leafNode = (LeafNode<T> *) state.leafPage;
+        const int n = leafNode->numOccupied;
+        if (n > 0 && leafNode->keyArray[n - 1] == pair.key) {
+            const RecordId last = leafNode->ridArray[n - 1];
+            if (isPosting(last)) {
+                addPosting(last.page_number, pair.rid);
+                leafNode->ridArray[n - 1] = postingLinkAdd(last, 1);
+                state.childCounts.back()++;
+                return;
+            }
+            int first = n - 1;
+            while (first > 0 && leafNode->keyArray[first - 1] == pair.key) {
+                first--;
+            }
+            if (n - first + 1 >= POSTINGTHRESHOLD) {
+                std::vector<RecordId> run(leafNode->ridArray + first, leafNode->ridArray + n);
+                run.push_back(pair.rid);
+                std::sort(run.begin(), run.end(), postingLess);
+                leafNode->ridArray[first] = postingLink(createPosting(run), (int) run.size());
+                leafNode->numOccupied = first + 1;
+                state.childCounts.back()++;
+                return;
+            }
+        }
+    }
+
+    if (state.leafPage == NULL || ((LeafNode<T> *) state.leafPage)->numOccupied == state.leafTarget) {
+        PageId newPageNo;
+        Page *newPage;
+        bufMgr->allocPage(file, newPageNo, newPage);
+        LeafNode<T> *newLeafNode = (LeafNode<T> *) newPage;
+        newLeafNode->numOccupied = 0;
+        newLeafNode->rightSibPageNo = Page::INVALID_NUMBER;
+        newLeafNode->leftSibPageNo = (state.leafPage != NULL) ? state.leafPageNo : Page::INVALID_NUMBER;
+        newLeafNode->pendingCount = 0;
+
+        // link the finished leaf to its right sibling, it is complete now and can be written out
+        T separator = pair.key;
+        if (state.leafPage != NULL) {
+            LeafNode<T> *leafNode = (LeafNode<T> *) state.leafPage;
+            separator = KeyTraits<T>::separator(leafNode->keyArray[leafNode->numOccupied - 1], pair.key);
+            leafNode->rightSibPageNo = newPageNo;
+            leafNode->highKey = separator;
+            bufMgr->unPinPage(file, state.leafPageNo, true);
+        }
+
+        // the first (numEntries % numLeaves) leaves take one extra entry each
+        state.leafTarget = state.numEntries / state.numLeaves + (state.leavesStarted < state.numEntries % state.numLeaves ? 1 : 0);
+        state.leavesStarted++;
+        state.leafPageNo = newPageNo;
+        state.leafPage = newPage;
+
+        PageKeyPair<T> child;
+        child.set(newPageNo, separator);
+        state.children.push_back(child);
+        state.childCounts.push_back(0);
+    }
+
+    LeafNode<T> *leafNode = (LeafNode<T> *) state.leafPage;
+    setLeafKey(leafNode, leafNode->numOccupied, pair.key);
+    if (recordSize > 0) {
+        memcpy(leafRecord(leafNode, leafNode->numOccupied), record, recordSize);
+    } else {
+        leafNode->ridArray[leafNode->numOccupied] = pair.rid;
+    }
+    leafNode->numOccupied++;
+    state.childCounts.back()++;
+}
+
+/**
+  * Helper method.
+  * Finishes the leaf level and packs the non-leaf levels on top of it, one level at a time, until a single root remains.
+  * @param state  Bulk load state of the leaf level
+  * @param fillFactor  Fraction of each non-leaf node that is filled
+  */
+template <class T>
+void BTreeIndex::bulkLoadFinish(BulkLoadState<T> &state, const float fillFactor) {
+    if (state.leafPage == NULL) {
+        // an empty relation still gets a single empty leaf as root
+        bufMgr->allocPage(file, state.leafPageNo, state.leafPage);
+        ((LeafNode<T> *) state.leafPage)->numOccupied = 0;
+        ((LeafNode<T> *) state.leafPage)->rightSibPageNo = Page::INVALID_NUMBER;
+        ((LeafNode<T> *) state.leafPage)->leftSibPageNo = Page::INVALID_NUMBER;
+        ((LeafNode<T> *) state.leafPage)->pendingCount = 0;
+        PageKeyPair<T> child;
+        child.set(state.leafPageNo, T());
+        state.children.push_back(child);
+        state.childCounts.push_back(0);
+    }
+    bufMgr->unPinPage(file, state.leafPageNo, true);
+    state.leafPage = NULL;
+
+    // pack each level from the smallest key and page number of the nodes below it
+    const int childCapacity = std::min(nodeOccupancy + 1, std::max(2, (int) ((nodeOccupancy + 1) * fillFactor)));
+    std::vector< PageKeyPair<T> > &children = state.children;
+    std::vector<int> &childCounts = state.childCounts;
+    bool aboveLeaves = true;
+    int height = 0;
+    while (children.size() > 1) {
+        const int numChildren = children.size();
+        const int numNodes = (numChildren + childCapacity - 1) / childCapacity;
+        std::vector< PageKeyPair<T> > parents;
+        std::vector<int> parentCounts;
+        int next = 0;
+        PageId prevPageNo = Page::INVALID_NUMBER;
+        Page *prevPage = NULL;
+        for (int n = 0; next < numChildren; n++) {
+            // spread the children evenly over the nodes of this level
+            const int nodesLeft = std::max(numNodes - n, 1);
+            const int share = (numChildren - next + nodesLeft - 1) / nodesLeft;
+
+            PageId pageNo;
+            Page *page;
+            bufMgr->allocPage(file, pageNo, page);
+            NonLeafNode<T> *node = (NonLeafNode<T> *) page;
+            node->level = aboveLeaves ? 1 : 0;
+            node->rightSibPageNo = Page::INVALID_NUMBER;
+            clearNode(node, children[next].pageNo, childCounts[next]);
+            int count = childCounts[next];
+            int taken = 1;
+            // the separator is the key the level below put in front of the child on its right. A STRING node fills by the
+            // length of its separators too, then it ends early and the later nodes of the level take the rest
+            while (taken < share && nodeHasRoom(node, children[next + taken].key)
+                   && (taken < 2 || nodeFill(node) < fillFactor)) {
+                insertNodeKey(node, taken - 1, children[next + taken].key, children[next + taken].pageNo, childCounts[next + taken]);
+                count += childCounts[next + taken];
+                taken++;
+            }
+
+            // link the previous node of the level to this one, as the leaves are linked
+            if (prevPage != NULL) {
+                ((NonLeafNode<T> *) prevPage)->rightSibPageNo = pageNo;
+                ((NonLeafNode<T> *) prevPage)->highKey = children[next].key;
+                bufMgr->unPinPage(file, prevPageNo, true);
+            }
+            prevPageNo = pageNo;
+            prevPage = page;
+
+            PageKeyPair<T> parent;
+            parent.set(pageNo, children[next].key);
+            parents.push_back(parent);
+            parentCounts.push_back(count);
+            next += taken;
+        }
+        bufMgr->unPinPage(file, prevPageNo, true);
+        children.swap(parents);
+        childCounts.swap(parentCounts);
+        aboveLeaves = false;
+        height++;
+    }
+
+    rootPageNum = children[0].pageNo;
+    onlyOneRoot = aboveLeaves;
+    treeHeight = height;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookup
+// -----------------------------------------------------------------------------
+
+bool BTreeIndex::lookup(const void* key, RecordId& out) {
+    return lookupAll(key, &out, 1) == 1;
+}
+
+size_t BTreeIndex::lookupAll(const void* key, RecordId* out, size_t max) {
+    checkStorage(SECONDARY);
+    switch (attributeType) {
+        case INTEGER:
+            return lookupTyped(KeyTraits<int>::fromBytes(key), out, max);
+        case DOUBLE:
+            return lookupTyped(KeyTraits<DoubleKey>::fromBytes(key), out, max);
+        case STRING:
+            return lookupTyped(KeyTraits<StringKey>::fromBytes(key), out, max);
+        case COMPOSITE:
+            return lookupTyped(keyFromBytes<CompositeKey>(key), out, max);
+        case COVERING:
+            return lookupTyped(keyFromBytes<CoveringKey>(key), out, max);
+    }
+    return 0;
+}
+
+/**
+  * Helper method.
+  * Finds the record ids of the entries equal to a typed key. Called by lookup and lookupAll once the key type is known.
+  * @param key   Key to look up
+  * @param out	Array the record ids found are returned in
+  * @param max	Maximum number of record ids to return
+  * @return	Number of record ids returned
+  */
+template <class T>
+size_t BTreeIndex::lookupTyped(const T& key, RecordId* out, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    PageId pageNo;
+    TreePath path;
+    searchEntry(key, pageNo, path);
+    return searchLeaf(key, pageNo, out, max);
+}
+
+/**
+  * Helper method.
+  * Copies the record ids of up to max entries equal to a key, starting at the leaf a descent for the key found.
+  * @param key   Key to look up
+  * @param pageNo	PageId of the leaf found by the descent
+  * @param out	Array the record ids found are returned in
+  * @param max	Maximum number of record ids to return, at least 1
+  * @return	Number of record ids returned
+  */
+template <class T>
+size_t BTreeIndex::searchLeaf(const T& key, PageId pageNo, RecordId* out, size_t max) {
+    Page* page;
+    bufMgr->readPage(file, pageNo, page);
+    bufMgr->latchPage(page);
+    LeafNode<T>* node = (LeafNode<T>*) page;
+    size_t count = 0;
+    while (true) {
+        int i = nodeLowerBound(node->keyArray, node->numOccupied, key);
+        while (i < node->numOccupied && node->keyArray[i] == key && count < max) {
+            const RecordId rid = node->ridArray[i];
+            if (isPosting(rid)) {
+                PageId postingPageNo = rid.page_number;
+                RecordId lastRid;
+                int lastRidCopies = 0;
+                count += copyPosting(postingPageNo, lastRid, lastRidCopies, false, false, out + count, max - count);
+            } else {
+                out[count++] = rid;
+            }
+            i++;
+        }
+        // the key may continue in the right sibling, or start there if the leaf was split since the descent
+        // or the descent stopped left of a separator equal to the key
+        if (count == max || i < node->numOccupied || node->rightSibPageNo == Page::INVALID_NUMBER || key < node->highKey) {
+            break;
+        }
+        PageId rightSibPageNo = node->rightSibPageNo;
+        bufMgr->unlatchPage(page);
+        bufMgr->unPinPage(file, pageNo, false);
+        pageNo = rightSibPageNo;
+        bufMgr->readPage(file, pageNo, page);
+        bufMgr->latchPage(page);
+        node = (LeafNode<T>*) page;
+    }
+    bufMgr->unlatchPage(page);
+    bufMgr->unPinPage(file, pageNo, false);
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookupBatch
+// -----------------------------------------------------------------------------
+
+size_t BTreeIndex::lookupBatch(const void* const* keys, size_t n, RecordId* results, bool* found) {
+    checkStorage(SECONDARY);
+    switch (attributeType) {
+        case INTEGER:
+            return lookupBatchTyped<int>(keys, n, results, found);
+        case DOUBLE:
+            return lookupBatchTyped<DoubleKey>(keys, n, results, found);
+        case STRING:
+            return lookupBatchTyped<StringKey>(keys, n, results, found);
+        case COMPOSITE:
+            return lookupBatchTyped<CompositeKey>(keys, n, results, found);
+        case COVERING:
+            return lookupBatchTyped<CoveringKey>(keys, n, results, found);
+    }
+    return 0;
+}
+
+/**
+  * Helper method.
+  * Looks up a batch of keys in key order. Called by lookupBatch once the key type is known.
+  * The keys are sorted, then swept across the leaves: a key in the current leaf needs only a search of the rest of it,
+  * otherwise the path is climbed only until a node whose high key covers the key, and the descent resumes from there.
+  * @param keys	Array of n pointers to the keys to look up
+  * @param n	Number of keys
+  * @param results	Array of n RecordIds, the record id found for keys[i] is returned in results[i]
+  * @param found	Array of n flags, found[i] is set to whether keys[i] is in the index
+  * @return	Number of keys found
+  */
+template <class T>
+size_t BTreeIndex::lookupBatchTyped(const void* const* keys, size_t n, RecordId* results, bool* found) {
+    if (n == 0) {
+        return 0;
+    }
+
+    // sort the keys along with their positions, the results go back to the original positions
+    std::vector< std::pair<T, size_t> > sorted(n);
+    for (size_t i = 0; i < n; i++) {
+        sorted[i] = std::make_pair(keyFromBytes<T>(keys[i]), i);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    PageId pageNo;
+    TreePath path;
+    searchEntry(sorted[0].first, pageNo, path);
+    Page* page;
+    bufMgr->readPage(file, pageNo, page);
+    bufMgr->latchPage(page);
+    LeafNode<T>* node = (LeafNode<T>*) page;
+    int from = 0;  // keys of the current leaf before from are less than the current key
+    size_t numFound = 0;
+
+    size_t k = 0;
+    while (k < n) {
+        const T& key = sorted[k].first;
+        const size_t pos = sorted[k].second;
+
+        // the key is beyond the current leaf: climb until a node on the path covers it, then descend again from there
+        if (node->rightSibPageNo != Page::INVALID_NUMBER && key > node->highKey) {
+            const int leafDepth = path.depth;
+            bufMgr->unlatchPage(page);
+            bufMgr->unPinPage(file, pageNo, false);
+            while (path.depth > 0 && !nodeCoversKey(path.pageNoArray[path.depth - 1], leafDepth - path.depth + 1, key)) {
+                path.depth--;
+            }
+            if (path.depth == 0) {
+                searchEntry(key, pageNo, path);
             } else {
-                propagateUpKey = currInternalNode->keyArray[i];  // need to propagate key up in tree
-                newInternalNode->pageNoArray[newInternalNode->numOccupied] = currInternalNode->pageNoArray[i];
-                currInternalNode->numOccupied -= 1;
-                newInternalNode->numOccupied += 1;
-            }
-
-        // else if key to be inserted is greater than the curr internal node's i-th key
-        // note that we do not insert here, instead, we insert after this loop
-        } else {            
-            // if the propagate up value has been pushed up, we reposition curr Internal Node by moving every index down by 1 for (newInternalNode->numOccupied-1) times
-            if (newInternalNode->numOccupied > capacity) {
-                currInternalNode->keyArray[i-(newInternalNode->numOccupied-1)-1] = currInternalNode->keyArray[i];
-                currInternalNode->pageNoArray[i-(newInternalNode->numOccupied-1)-1] = currInternalNode->pageNoArray[i];
-
-            // else if the new internal node has open slots, we insert key into new key first    
-            } else if (newInternalNode->numOccupied < capacity) {
-                newInternalNode->keyArray[i] =  currInternalNode->keyArray[i];
-                newInternalNode->pageNoArray[i] =  currInternalNode->pageNoArray[i];
-                newInternalNode->numOccupied += 1;
-                currInternalNode->numOccupied -= 1;
-
-            // else if the new internal node is full (newInternalNode->numOccupied == capacity), we propagate up the middle key in the curr internal node.
-            // Note that when splitting an internal node, we do not need to preserve the propagate up key because it can just be pushed up        
+                path.depth--;
+                pageNo = path.pageNoArray[path.depth];
+                descend(key, pageNo, leafDepth - path.depth, path, 0);
+            }
+            bufMgr->readPage(file, pageNo, page);
+            bufMgr->latchPage(page);
+            node = (LeafNode<T>*) page;
+            from = 0;
+            continue;
+        }
+
+        int i = from + nodeLowerBound(node->keyArray + from, node->numOccupied - from, key);
+        from = i;
+        // the key may start in the right sibling if the descent stopped left of a separator equal to it
+        if (i == node->numOccupied && node->rightSibPageNo != Page::INVALID_NUMBER && !(key < node->highKey)) {
+            PageId rightSibPageNo = node->rightSibPageNo;
+            bufMgr->unlatchPage(page);
+            bufMgr->unPinPage(file, pageNo, false);
+            pageNo = rightSibPageNo;
+            bufMgr->readPage(file, pageNo, page);
+            bufMgr->latchPage(page);
+            node = (LeafNode<T>*) page;
+            from = 0;
+            i = nodeLowerBound(node->keyArray, node->numOccupied, key);
+        }
+        found[pos] = i < node->numOccupied && node->keyArray[i] == key;
+        if (found[pos]) {
+            const RecordId rid = node->ridArray[i];
+            results[pos] = isPosting(rid) ? postingRidAt(rid.page_number, 0) : rid;
+            numFound++;
+        }
+        k++;
+    }
+    bufMgr->unlatchPage(page);
+    bufMgr->unPinPage(file, pageNo, false);
+    return numFound;
+}
+
+/**
+  * Helper method.
+  * Reads the high key of a non-leaf node optimistically, like descend does.
+  * @param pageNo	PageId of the non-leaf node
+  * @param height	Height of the node above the leaves
+  * @param key	Key to check
+  * @return	True if the key is not beyond the high key of the node, i.e. a descent from the node finds it without moving right
+  */
+template <class T>
+bool BTreeIndex::nodeCoversKey(const PageId pageNo, const int height, const T& key) {
+    bool cached;
+    Page* page = readNonLeaf(pageNo, height, cached);
+    NonLeafNode<T>* node = (NonLeafNode<T>*) page;
+    bool covers;
+    while (true) {
+        std::uint32_t version = bufMgr->pageVersion(page);
+        covers = node->rightSibPageNo == Page::INVALID_NUMBER || !(key > node->highKey);
+        if (bufMgr->validatePage(page, version)) {
+            break;
+        }
+        std::this_thread::yield();
+    }
+    releaseNonLeaf(pageNo, cached);
+    return covers;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookupInterleaved
+// -----------------------------------------------------------------------------
+
+size_t BTreeIndex::lookupInterleaved(const void* const* keys, size_t n, RecordId* results, bool* found) {
+    checkStorage(SECONDARY);
+    switch (attributeType) {
+        case INTEGER:
+            return lookupInterleavedTyped<int>(keys, n, results, found);
+        case DOUBLE:
+            return lookupInterleavedTyped<DoubleKey>(keys, n, results, found);
+        case STRING:
+            return lookupInterleavedTyped<StringKey>(keys, n, results, found);
+        case COMPOSITE:
+            return lookupInterleavedTyped<CompositeKey>(keys, n, results, found);
+        case COVERING:
+            return lookupInterleavedTyped<CoveringKey>(keys, n, results, found);
+    }
+    return 0;
+}
+
+/**
+  * Helper method.
+  * Looks up a batch of keys with up to INTERLEAVEDPROBES descents in flight. Called by lookupInterleaved once the key type is known.
+  * Every probe is a small state machine: the node it is at and its height. A step reads one node, starts loading the
+  * next one into the CPU cache if the node cache holds it, and moves on to the next probe, so the next node is in the
+  * CPU cache by the time the probe steps again. A node outside the node cache that is not in the buffer pool either is
+  * queued for the prefetch thread of the buffer manager, and its probe waits while the others step until the node is read.
+  * Once every probe waits, the next one reads its node itself, so a prefetch that was dropped holds up nothing.
+  * @param keys	Array of n pointers to the keys to look up
+  * @param n	Number of keys
+  * @param results	Array of n RecordIds, the record id found for keys[i] is returned in results[i]
+  * @param found	Array of n flags, found[i] is set to whether keys[i] is in the index
+  * @return	Number of keys found
+  */
+template <class T>
+size_t BTreeIndex::lookupInterleavedTyped(const void* const* keys, size_t n, RecordId* results, bool* found) {
+    struct Probe {
+        T key;
+        size_t pos;  // position of the key in keys
+        PageId pageNo;  // node the probe reads in its next step
+        int height;  // height of that node above the leaves
+        Page* page;  // frame of that node if the node cache holds it, NULL otherwise
+        bool waiting;  // the node was queued for the prefetch thread, the probe steps again once it is in the buffer pool
+    };
+    Probe probes[INTERLEAVEDPROBES];
+    int numProbes = 0;
+    int numWaiting = 0;
+    size_t nextKey = 0;
+    size_t numFound = 0;
+
+    // fill the probes with the first keys, all starting at the root
+    PageId rootNo;
+    int rootHeight;
+    {
+        std::lock_guard<std::mutex> guard(rootMutex);
+        rootNo = rootPageNum;
+        rootHeight = treeHeight;
+    }
+    while (numProbes < INTERLEAVEDPROBES && nextKey < n) {
+        Probe& probe = probes[numProbes++];
+        probe.key = keyFromBytes<T>(keys[nextKey]);
+        probe.pos = nextKey++;
+        probe.pageNo = rootNo;
+        probe.height = rootHeight;
+        probe.page = NULL;
+        probe.waiting = false;
+    }
+
+    // step the probes round robin until all keys are looked up
+    int p = 0;
+    while (numProbes > 0) {
+        Probe& probe = probes[p];
+        // a node that is not in memory is read in the background while the other probes step
+        if (probe.page == NULL && !bufMgr->isResident(file, probe.pageNo) && numWaiting < numProbes) {
+            if (!probe.waiting) {
+                bufMgr->prefetchPageAsync(file, probe.pageNo);
+                probe.waiting = true;
+                numWaiting++;
+            }
+            if (numWaiting < numProbes) {
+                p = (p + 1 < numProbes) ? p + 1 : 0;
+                continue;
+            }
+        }
+        if (probe.waiting) {
+            probe.waiting = false;
+            numWaiting--;
+        }
+
+        if (probe.height > 0) {
+            // the frame of a cached node stays pinned by the cache, it needs no lookup in the buffer pool
+            bool cached = probe.page != NULL;
+            Page* page = cached ? probe.page : readNonLeaf(probe.pageNo, probe.height, cached);
+            PageId nextPageNo;
+            if (!searchNonLeaf(page, probe.key, nextPageNo)) {
+                probe.height--;
+            }
+            releaseNonLeaf(probe.pageNo, cached);
+            probe.pageNo = nextPageNo;
+            probe.page = (probe.height > 0) ? prefetchNode<T>(probe.pageNo) : NULL;
+            p++;
+        } else {
+            found[probe.pos] = searchLeaf(probe.key, probe.pageNo, &results[probe.pos], 1) == 1;
+            if (found[probe.pos]) {
+                numFound++;
+            }
+            // start the next key in this probe, or retire it. Late keys read the root again to see a new root
+            if (nextKey < n) {
+                std::lock_guard<std::mutex> guard(rootMutex);
+                probe.key = keyFromBytes<T>(keys[nextKey]);
+                probe.pos = nextKey++;
+                probe.pageNo = rootPageNum;
+                probe.height = treeHeight;
+                probe.page = NULL;
+                p++;
             } else {
-                propagateUpKey =  currInternalNode->keyArray[i];  // propagate this key up
-                newInternalNode->pageNoArray[newInternalNode->numOccupied] = currInternalNode->pageNoArray[i];
-                currInternalNode->numOccupied -= 1;
-                newInternalNode->numOccupied += 1;
+                probe = probes[--numProbes];
+            }
+        }
+        if (p >= numProbes) {
+            p = 0;
+        }
+    }
+    return numFound;
+}
+
+/**
+  * Helper method.
+  * Starts loading a non-leaf node held by the node cache into the CPU cache: its header, and the keys
+  * the first two steps of the binary search of the node compare against. Takes no lock and reads nothing from disk.
+  * @param pageNo	PageId of the node
+  * @return	The frame of the node, pinned by the cache, NULL if the node cache does not hold it
+  */
+template <class T>
+Page* BTreeIndex::prefetchNode(const PageId pageNo) {
+    Page* page = nodeCache.lookup(pageNo);
+    if (page == NULL) {
+        return NULL;
+    }
+    const NonLeafNode<T>* node = (const NonLeafNode<T>*) page;
+    const char* keys = (const char*) nodeSearchArray(node);
+    const int keyBytes = nodeOccupancy * nodeSearchStride(node);
+    __builtin_prefetch(page);
+    __builtin_prefetch(keys + keyBytes / 4);
+    __builtin_prefetch(keys + keyBytes / 2);
+    __builtin_prefetch(keys + 3 * keyBytes / 4);
+    return page;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookupRecord
+// -----------------------------------------------------------------------------
+
+bool BTreeIndex::lookupRecord(const void* key, void* record) {
+    checkStorage(CLUSTERED);
+    switch (attributeType) {
+        case INTEGER:
+            return lookupRecordTyped(KeyTraits<int>::fromBytes(key), (char*) record);
+        case DOUBLE:
+            return lookupRecordTyped(KeyTraits<DoubleKey>::fromBytes(key), (char*) record);
+        case STRING:
+            return lookupRecordTyped(KeyTraits<StringKey>::fromBytes(key), (char*) record);
+        case COMPOSITE:
+            return lookupRecordTyped(keyFromBytes<CompositeKey>(key), (char*) record);
+        case COVERING:
+            return lookupRecordTyped(keyFromBytes<CoveringKey>(key), (char*) record);
+    }
+    return false;
+}
+
+/**
+  * Helper method.
+  * Finds the first record with a key in a clustered index. Called by lookupRecord once the key type is known.
+  * The record is copied from the leaf the descent ends at, or from its right sibling if the key starts there, as in searchLeaf.
+  * @param key   Key to look up
+  * @param out	The record found, returned in recordSize bytes
+  * @return	True if there is a record with the key
+  */
+template <class T>
+bool BTreeIndex::lookupRecordTyped(const T& key, char* out) {
+    PageId pageNo;
+    TreePath path;
+    searchEntry(key, pageNo, path);
+
+    Page* page;
+    bufMgr->readPage(file, pageNo, page);
+    bufMgr->latchPage(page);
+    LeafNode<T>* node = (LeafNode<T>*) page;
+    int i = nodeLowerBound(node->keyArray, node->numOccupied, key);
+    while (i == node->numOccupied && node->rightSibPageNo != Page::INVALID_NUMBER && !(key < node->highKey)) {
+        PageId rightSibPageNo = node->rightSibPageNo;
+        bufMgr->unlatchPage(page);
+        bufMgr->unPinPage(file, pageNo, false);
+        pageNo = rightSibPageNo;
+        bufMgr->readPage(file, pageNo, page);
+        bufMgr->latchPage(page);
+        node = (LeafNode<T>*) page;
+        i = nodeLowerBound(node->keyArray, node->numOccupied, key);
+    }
+    const bool found = i < node->numOccupied && node->keyArray[i] == key;
+    if (found) {
+        memcpy(out, leafRecord(node, i), recordSize);
+    }
+    bufMgr->unlatchPage(page);
+    bufMgr->unPinPage(file, pageNo, false);
+    return found;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::countRange
+// -----------------------------------------------------------------------------
+
+size_t BTreeIndex::countRange(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp) {
+    if (lowOp != GT && lowOp != GTE)
+        throw BadOpcodesException();
+    if (highOp != LT && highOp != LTE)
+        throw BadOpcodesException();
+
+    switch (attributeType) {
+        case INTEGER:
+            return countRangeTyped(KeyTraits<int>::fromBytes(lowVal), lowOp, KeyTraits<int>::fromBytes(highVal), highOp);
+        case DOUBLE:
+            return countRangeTyped(KeyTraits<DoubleKey>::fromBytes(lowVal), lowOp, KeyTraits<DoubleKey>::fromBytes(highVal), highOp);
+        case STRING:
+            return countRangeTyped(KeyTraits<StringKey>::fromBytes(lowVal), lowOp, KeyTraits<StringKey>::fromBytes(highVal), highOp);
+        case COMPOSITE:
+            return countRangeTyped(keyFromBytes<CompositeKey>(lowVal), lowOp, keyFromBytes<CompositeKey>(highVal), highOp);
+        case COVERING:
+            return countRangeTyped(keyFromBytes<CoveringKey>(lowVal), lowOp, keyFromBytes<CoveringKey>(highVal), highOp);
+    }
+    return 0;
+}
+
+/**
+  * Helper method.
+  * Counts the entries in a range of typed keys. Called by countRange once the operators are checked and the key type is known.
+  * The count is the difference of the number of entries below the two bounds.
+  * @param lowVal	Low value of range
+  * @param lowOp		Low operator (GT/GTE)
+  * @param highVal	High value of range
+  * @param highOp	High operator (LT/LTE)
+  * @return	Number of entries in the range
+  */
+template <class T>
+size_t BTreeIndex::countRangeTyped(const T& lowVal, const Operator lowOp, const T& highVal, const Operator highOp) {
+    if (lowVal > highVal)
+        throw BadScanrangeException();
+    size_t high = countBelow(highVal, highOp == LTE);
+    size_t low = countBelow(lowVal, lowOp == GT);
+    // concurrent inserts may land between the two descents
+    return high > low ? high - low : 0;
+}
+
+/**
+  * Helper method.
+  * Counts the entries less than a key, or less than or equal to it. Descends like searchEntry, adding up the subtree counts
+  * of the children left of the one followed, and of every node it moves right past. Only the leaf at the end is read entry by entry.
+  * The entries pending in leaves are flushed into the counts first. The count is exact if no insert runs concurrently,
+  * otherwise it may miss inserts that are not flushed yet.
+  * @param key  Key to count below
+  * @param orEqual  True to count the entries equal to the key as well
+  * @return  Number of entries less than the key, or less than or equal to it
+  */
+template <class T>
+size_t BTreeIndex::countBelow(const T& key, const bool orEqual) {
+    flushCounts();
+    PageId pageNo;
+    int height;
+    {
+        std::lock_guard<std::mutex> guard(rootMutex);
+        pageNo = rootPageNum;
+        height = treeHeight;
+    }
+
+    size_t count = 0;
+    while (height > 0) {
+        bool cached;
+        Page* page = readNonLeaf(pageNo, height, cached);
+        NonLeafNode<T>* node = (NonLeafNode<T>*) page;
+        PageId nextPageNo;
+        bool moveRight;
+        size_t skipped;
+        while (true) {
+            std::uint32_t version = bufMgr->pageVersion(page);
+            int numOccupied = std::min(std::max(node->numOccupied, 0), nodeOccupancy);
+            // entries equal to the high key may continue in the right sibling
+            moveRight = node->rightSibPageNo != Page::INVALID_NUMBER && (orEqual ? !(key < node->highKey) : key > node->highKey);
+            int childIndex = moveRight ? numOccupied + 1
+                           : (orEqual ? nodeUpperBound(node, numOccupied, key) : nodeLowerBound(node, numOccupied, key));
+            skipped = 0;
+            for (int i = 0; i < childIndex; i++) {
+                skipped += nodeCount(node, i);
+            }
+            nextPageNo = moveRight ? node->rightSibPageNo : nodeChild(node, childIndex);
+            if (bufMgr->validatePage(page, version)) {
+                break;
+            }
+            std::this_thread::yield();  // let the writer finish
+        }
+        releaseNonLeaf(pageNo, cached);
+        count += skipped;
+        pageNo = nextPageNo;
+        if (!moveRight) {
+            height--;
+        }
+    }
+
+    Page* page;
+    bufMgr->readPage(file, pageNo, page);
+    bufMgr->latchPage(page);
+    LeafNode<T>* node = (LeafNode<T>*) page;
+    while (node->rightSibPageNo != Page::INVALID_NUMBER && (orEqual ? !(key < node->highKey) : key > node->highKey)) {
+        count += entryCount(node, 0, node->numOccupied);
+        PageId rightSibPageNo = node->rightSibPageNo;
+        bufMgr->unlatchPage(page);
+        bufMgr->unPinPage(file, pageNo, false);
+        pageNo = rightSibPageNo;
+        bufMgr->readPage(file, pageNo, page);
+        bufMgr->latchPage(page);
+        node = (LeafNode<T>*) page;
+    }
+    count += entryCount(node, 0, orEqual ? nodeUpperBound(node->keyArray, node->numOccupied, key)
+                                         : nodeLowerBound(node->keyArray, node->numOccupied, key));
+    bufMgr->unlatchPage(page);
+    bufMgr->unPinPage(file, pageNo, false);
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::rank
+// -----------------------------------------------------------------------------
+
+size_t BTreeIndex::rank(const void* key) {
+    switch (attributeType) {
+        case INTEGER:
+            return countBelow(KeyTraits<int>::fromBytes(key), false);
+        case DOUBLE:
+            return countBelow(KeyTraits<DoubleKey>::fromBytes(key), false);
+        case STRING:
+            return countBelow(KeyTraits<StringKey>::fromBytes(key), false);
+        case COMPOSITE:
+            return countBelow(keyFromBytes<CompositeKey>(key), false);
+        case COVERING:
+            return countBelow(keyFromBytes<CoveringKey>(key), false);
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::select
+// -----------------------------------------------------------------------------
+
+bool BTreeIndex::select(size_t i, RecordId& out) {
+    checkStorage(SECONDARY);
+    switch (attributeType) {
+        case INTEGER:
+            return selectTyped<int>(i, out);
+        case DOUBLE:
+            return selectTyped<DoubleKey>(i, out);
+        case STRING:
+            return selectTyped<StringKey>(i, out);
+        case COMPOSITE:
+            return selectTyped<CompositeKey>(i, out);
+        case COVERING:
+            return selectTyped<CoveringKey>(i, out);
+    }
+    return false;
+}
+
+/**
+  * Helper method.
+  * Finds the entry at a position in key order. Called by select once the key type is known.
+  * In every node it follows the child whose subtree holds the position, by the subtree counts, and moves right
+  * when the position lies past the node, which concurrent inserts that are not flushed yet can cause. The entries pending
+  * in leaves are flushed into the counts first.
+  * @param i	Position of the entry, 0 for the smallest
+  * @param out	Record id of the entry, returned in this if there is one
+  * @return	True if the index has more than i entries
+  */
+template <class T>
+bool BTreeIndex::selectTyped(size_t i, RecordId& out) {
+    flushCounts();
+    PageId pageNo;
+    int height;
+    {
+        std::lock_guard<std::mutex> guard(rootMutex);
+        pageNo = rootPageNum;
+        height = treeHeight;
+    }
+
+    while (height > 0) {
+        bool cached;
+        Page* page = readNonLeaf(pageNo, height, cached);
+        NonLeafNode<T>* node = (NonLeafNode<T>*) page;
+        PageId nextPageNo;
+        bool moveRight;
+        size_t skipped;
+        while (true) {
+            std::uint32_t version = bufMgr->pageVersion(page);
+            int numOccupied = std::min(std::max(node->numOccupied, 0), nodeOccupancy);
+            // skip the children that end at or before position i, the last child takes whatever is left
+            int childIndex = 0;
+            skipped = 0;
+            while (childIndex <= numOccupied && skipped + nodeCount(node, childIndex) <= i) {
+                skipped += nodeCount(node, childIndex++);
+            }
+            moveRight = childIndex > numOccupied && node->rightSibPageNo != Page::INVALID_NUMBER;
+            if (!moveRight && childIndex > numOccupied) {
+                childIndex = numOccupied;
+                skipped -= nodeCount(node, childIndex);
+            }
+            nextPageNo = moveRight ? node->rightSibPageNo : nodeChild(node, childIndex);
+            if (bufMgr->validatePage(page, version)) {
+                break;
+            }
+            std::this_thread::yield();  // let the writer finish
+        }
+        releaseNonLeaf(pageNo, cached);
+        i -= skipped;
+        pageNo = nextPageNo;
+        if (!moveRight) {
+            height--;
+        }
+    }
+
+    Page* page;
+    bufMgr->readPage(file, pageNo, page);
+    bufMgr->latchPage(page);
+    LeafNode<T>* node = (LeafNode<T>*) page;
+    size_t leafCount = ridCount(node->ridArray, 0, node->numOccupied);
+    while (i >= leafCount && node->rightSibPageNo != Page::INVALID_NUMBER) {
+        i -= leafCount;
+        PageId rightSibPageNo = node->rightSibPageNo;
+        bufMgr->unlatchPage(page);
+        bufMgr->unPinPage(file, pageNo, false);
+        pageNo = rightSibPageNo;
+        bufMgr->readPage(file, pageNo, page);
+        bufMgr->latchPage(page);
+        node = (LeafNode<T>*) page;
+        leafCount = ridCount(node->ridArray, 0, node->numOccupied);
+    }
+    bool found = i < leafCount;
+    // the position is in the entry whose record ids reach past it, inside its posting list if it has one
+    for (int k = 0; found; k++) {
+        const RecordId& rid = node->ridArray[k];
+        const size_t size = isPosting(rid) ? postingSize(rid) : 1;
+        if (i < size) {
+            out = isPosting(rid) ? postingRidAt(rid.page_number, (int) i) : rid;
+            break;
+        }
+        i -= size;
+    }
+    bufMgr->unlatchPage(page);
+    bufMgr->unPinPage(file, pageNo, false);
+    return found;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::startScan
+// -----------------------------------------------------------------------------
+
+void BTreeIndex::startScan(const void* lowValParm,
+				   const Operator lowOpParm,
+				   const void* highValParm,
+				   const Operator highOpParm,
+				   const ScanDirection directionParm)
+{
+	indexScan.startScan(lowValParm, lowOpParm, highValParm, highOpParm, directionParm);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::startPrefixScan
+// -----------------------------------------------------------------------------
+
+void BTreeIndex::startPrefixScan(const void* lowValParm,
+				   const Operator lowOpParm,
+				   const void* highValParm,
+				   const Operator highOpParm,
+				   const int numAttrs,
+				   const ScanDirection directionParm)
+{
+	indexScan.startPrefixScan(lowValParm, lowOpParm, highValParm, highOpParm, numAttrs, directionParm);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::startSkipScan
+// -----------------------------------------------------------------------------
+
+void BTreeIndex::startSkipScan(const void* lowValParm,
+				   const Operator lowOpParm,
+				   const void* highValParm,
+				   const Operator highOpParm,
+				   const ScanDirection directionParm)
+{
+	indexScan.startSkipScan(lowValParm, lowOpParm, highValParm, highOpParm, directionParm);
+}
+
+/**
+  * Helper method.
+  * Starts a scan of the cursor over typed bounds. Called by ScanCursor::startScan once the parameters are checked and the key type is known.
+  * @param cursor	Cursor to start the scan of
+  */
+template <class T>
+void BTreeIndex::startScanTyped(ScanCursor& cursor, const T& lowVal, const T& highVal)
+{
+	//check if the lower bound and higher bound are vaild
+	if (lowVal > highVal)
+		throw BadScanrangeException();  //if lowValue > highValue, throw the exception BadScanrangeException
+
+	//set up cursor variables
+	cursor.scanLowVal<T>() = lowVal;
+	cursor.scanHighVal<T>() = highVal;
+	cursor.scanExecuting = true;  //begin new scan
+	if (cursor.direction == BACKWARD) {
+		startScanBackward(cursor, lowVal, highVal);
+		return;
+	}
+
+	PageId pageNo; // store the lowest value in the boundry if founded
+	TreePath rootToLeafPath; // store the root to lead path (without the lead node)
+	searchEntry(lowVal, pageNo, rootToLeafPath);  // search and get a leaf page
+
+	cursor.currentPageNum = pageNo;
+	cursor.leavesScanned = 0;
+	cursor.readAheadParentNum = (rootToLeafPath.depth > 0) ? rootToLeafPath.pageNoArray[rootToLeafPath.depth - 1] : Page::INVALID_NUMBER;
+	cursor.readAheadSlot = -1;
+	Page* currentPageData;
+	bufMgr->readPage(file, cursor.currentPageNum, currentPageData);
+	bufMgr->latchPage(currentPageData);
+	LeafNode<T>* leafNode = (LeafNode<T>*) currentPageData;
+
+	cursor.nextEntry = -1; // an initial value for nextEntry for test
+	while (cursor.nextEntry == -1) {
+		// the start value of scan is the first value >= lowVal, or > lowVal if values equal to the lowVal are not in the range
+		int i = (cursor.lowOp == GTE) ? nodeLowerBound(leafNode->keyArray, leafNode->numOccupied, lowVal)
+		                              : nodeUpperBound(leafNode->keyArray, leafNode->numOccupied, lowVal);
+		if (i < leafNode->numOccupied) {
+			cursor.nextEntry = i;
+		}
+
+		// if no record in current page satisfies the lower boundry, the first one may still be in the right sibling,
+		// since the search stops at the leaf on the left of a separator key equal to lowVal
+		if (cursor.nextEntry == -1) {
+			PageId rightSibPageNo = leafNode->rightSibPageNo;
+			bufMgr->unlatchPage(currentPageData);
+			bufMgr -> unPinPage(file, cursor.currentPageNum, false);
+			if (rightSibPageNo == Page::INVALID_NUMBER) {
+				cursor.endScan();
+				throw NoSuchKeyFoundException();
+			}
+			cursor.currentPageNum = rightSibPageNo;
+			bufMgr->readPage(file, cursor.currentPageNum, currentPageData);
+			bufMgr->latchPage(currentPageData);
+			leafNode = (LeafNode<T>*) currentPageData;
+		}
+	}
+
+	//check if it satisfied the given upper boundry,
+	//since it is possible that the value is greater than the lower boundry
+	//but also greater than the upper boundry
+	if (leafNode->keyArray[cursor.nextEntry] > highVal ||
+		(leafNode->keyArray[cursor.nextEntry] == highVal && cursor.highOp == LT)) {
+		bufMgr->unlatchPage(currentPageData);
+		bufMgr->unPinPage(file, cursor.currentPageNum, false);
+		cursor.endScan();
+		throw NoSuchKeyFoundException();
+	}
+
+	saveScanPosition<T>(cursor, leafNode);
+	bufMgr->unlatchPage(currentPageData);
+	bufMgr->unPinPage(file, cursor.currentPageNum, false);  //unpin the current page
+}
+
+/**
+  * Helper method.
+  * Starts a BACKWARD scan of the cursor: finds the last entry that satisfies the scan criteria. Called by startScanTyped.
+  * @param cursor	Cursor to start the scan of
+  * @param lowVal	Low value of range
+  * @param highVal	High value of range
+  */
+template <class T>
+void BTreeIndex::startScanBackward(ScanCursor& cursor, const T& lowVal, const T& highVal)
+{
+	PageId pageNo;
+	TreePath rootToLeafPath;
+	searchEntry(highVal, pageNo, rootToLeafPath);
+
+	// the scan does not read ahead to the left
+	cursor.leavesScanned = 0;
+	cursor.readAheadParentNum = Page::INVALID_NUMBER;
+	cursor.readAheadSlot = -1;
+	Page* currentPageData;
+	bufMgr->readPage(file, pageNo, currentPageData);
+	bufMgr->latchPage(currentPageData);
+	LeafNode<T>* leafNode = (LeafNode<T>*) currentPageData;
+
+	// the search stops at the leftmost leaf that may hold highVal, entries equal to it may continue in the right siblings,
+	// and a split since the descent may have moved smaller ones there too
+	while (leafNode->rightSibPageNo != Page::INVALID_NUMBER &&
+	       (cursor.highOp == LTE ? !(highVal < leafNode->highKey) : highVal > leafNode->highKey)) {
+		PageId rightSibPageNo = leafNode->rightSibPageNo;
+		bufMgr->unlatchPage(currentPageData);
+		bufMgr->unPinPage(file, pageNo, false);
+		pageNo = rightSibPageNo;
+		bufMgr->readPage(file, pageNo, currentPageData);
+		bufMgr->latchPage(currentPageData);
+		leafNode = (LeafNode<T>*) currentPageData;
+	}
+
+	// the start value of the scan is the last value <= highVal, or < highVal if values equal to highVal are not in the range.
+	// If every value of the leaf is past it, it is the last value of a leaf on the left
+	int i = (cursor.highOp == LTE) ? nodeUpperBound(leafNode->keyArray, leafNode->numOccupied, highVal) - 1
+	                               : nodeLowerBound(leafNode->keyArray, leafNode->numOccupied, highVal) - 1;
+	while (i < 0) {
+		if (!moveLeft<T>(pageNo, currentPageData)) {
+			cursor.endScan();
+			throw NoSuchKeyFoundException();
+		}
+		leafNode = (LeafNode<T>*) currentPageData;
+		i = leafNode->numOccupied - 1;
+	}
+	cursor.currentPageNum = pageNo;
+
+	// the value may be below the lower boundry as well
+	if (leafNode->keyArray[i] < lowVal ||
+		(leafNode->keyArray[i] == lowVal && cursor.lowOp == GT)) {
+		bufMgr->unlatchPage(currentPageData);
+		bufMgr->unPinPage(file, cursor.currentPageNum, false);
+		cursor.endScan();
+		throw NoSuchKeyFoundException();
+	}
+
+	cursor.nextEntry = i;
+	saveScanPosition<T>(cursor, leafNode);
+	bufMgr->unlatchPage(currentPageData);
+	bufMgr->unPinPage(file, cursor.currentPageNum, false);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::scanNext
+// -----------------------------------------------------------------------------
+
+void BTreeIndex::scanNext(RecordId& outRid) {
+    indexScan.scanNext(outRid);
+}
+
+void BTreeIndex::scanNext(RecordId& outRid, void* payload) {
+    indexScan.scanNext(outRid, payload);
+}
+
+/**
+  * Helper method.
+  * Fetches the next record id of the scan of the cursor. Called by ScanCursor::scanNext once the key type is known.
+  * @param cursor	Cursor of the scan
+  * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
+  */
+template <class T>
+void BTreeIndex::scanNextTyped(ScanCursor& cursor, RecordId& outRid) {
+    // a single record id is a batch of one, which also steps through posting lists and the groups of a skip scan
+    if (skipScanBatchTyped<T>(cursor, &outRid, 1) == 0) {
+        throw IndexScanCompletedException();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::scanNextBatch
+// -----------------------------------------------------------------------------
+
+size_t BTreeIndex::scanNextBatch(RecordId* out, size_t max) {
+    return indexScan.scanNextBatch(out, max);
+}
+
+size_t BTreeIndex::scanNextBatch(RecordId* out, void* payloads, size_t max) {
+    return indexScan.scanNextBatch(out, payloads, max);
+}
+
+/**
+  * Helper method.
+  * Fetches the record ids of up to max next entries of the scan of the cursor. Called by ScanCursor::scanNextBatch once the key type is known.
+  * @param cursor	Cursor of the scan
+  * @param out	Array the record ids found are returned in
+  * @param max	Maximum number of record ids to return
+  * @param payloads	Array the included attributes of the entries found are returned in, payloadSize bytes each. NULL if they are not wanted
+  * @return	Number of record ids returned
+  */
+template <class T>
+size_t BTreeIndex::scanNextBatchTyped(ScanCursor& cursor, RecordId* out, size_t max, unsigned char* payloads) {
+    if (cursor.direction == BACKWARD) {
+        return scanPrevBatchTyped<T>(cursor, out, max, payloads);
+    }
+
+    // the scan is complete, nothing left to return
+    if (cursor.nextEntry == -1 || max == 0) {
+        return 0;
+    }
+
+    const T& highVal = cursor.scanHighVal<T>();
+    Page* currentPageData;
+    bufMgr->readPage(file, cursor.currentPageNum, currentPageData);  //read current page, it stays pinned and latched while we copy from it
+    bufMgr->latchPage(currentPageData);
+    relocateScan<T>(cursor, currentPageData);
+    LeafNode<T>* currentNode = (LeafNode<T>*) currentPageData;
+
+    // nextEntry always points to an entry that satisfies the scan criteria here, as in scanNext
+    size_t count = 0;
+    while (count < max) {
+        const RecordId& rid = currentNode->ridArray[cursor.nextEntry];
+        if (isPosting(rid)) {
+            // a full batch may stop inside the posting list, the next call goes on from there
+            const bool resume = cursor.postingPageNum != Page::INVALID_NUMBER;
+            if (!resume) {
+                cursor.postingPageNum = rid.page_number;
+            }
+            count += copyPosting(cursor.postingPageNum, cursor.postingLastRid, cursor.postingLastRidCopies, resume, false, out + count, max - count);
+            if (cursor.postingPageNum != Page::INVALID_NUMBER) {
+                break;
+            }
+        } else {
+            // the entries up to the next posting list, the end of the range, the leaf or the batch are unpacked in one go
+            const int first = cursor.nextEntry;
+            const int numLeft = currentNode->numOccupied - first;
+            const int inRange = (cursor.highOp == LTE) ? nodeUpperBound(currentNode->keyArray + first, numLeft, highVal)
+                                                       : nodeLowerBound(currentNode->keyArray + first, numLeft, highVal);
+            const int last = first + std::max(1, std::min(inRange, (int) std::min(max - count, (size_t) numLeft)));
+            int end = first + 1;
+            while (end < last && !isPosting(currentNode->ridArray[end])) {
+                end++;
+            }
+            unpackLeafRids(currentNode->ridArray + first, end - first, out + count);
+            if (payloads != NULL) {
+                copyPayloads(currentNode, first, end - first, payloads + count * payloadSize);
+            }
+            count += end - first;
+            cursor.nextEntry = end - 1;
+        }
+        cursor.nextEntry++;
+
+        // current page is used up, move on to the right sibling
+        if (cursor.nextEntry == currentNode->numOccupied) {
+            PageId rightSibPageNo = currentNode->rightSibPageNo;
+            if (rightSibPageNo == Page::INVALID_NUMBER) {
+                cursor.nextEntry = -1;
+                break;
+            }
+            bufMgr->unlatchPage(currentPageData);
+            bufMgr->unPinPage(file, cursor.currentPageNum, false);
+            cursor.currentPageNum = rightSibPageNo;
+            bufMgr->readPage(file, cursor.currentPageNum, currentPageData);
+            bufMgr->latchPage(currentPageData);
+            currentNode = (LeafNode<T>*) currentPageData;
+            readAhead(cursor, rightSibPageNo, currentNode);
+            cursor.nextEntry = 0;
+            if (currentNode->numOccupied == 0) {
+                cursor.nextEntry = -1;
+                break;
+            }
+        }
+
+        // stop at the first value that is not in the range
+        if (currentNode->keyArray[cursor.nextEntry] > highVal ||
+            (currentNode->keyArray[cursor.nextEntry] == highVal && cursor.highOp != LTE)) {
+            cursor.nextEntry = -1;
+            break;
+        }
+    }
+
+    if (cursor.nextEntry != -1) {
+        saveScanPosition<T>(cursor, currentNode);
+    }
+    bufMgr->unlatchPage(currentPageData);
+    bufMgr->unPinPage(file, cursor.currentPageNum, false);
+    return count;
+}
+
+/**
+  * Helper method.
+  * Fetches the record ids of up to max next entries of a BACKWARD scan of the cursor, in descending key order.
+  * Called by scanNextBatchTyped for BACKWARD scans, and so by scanNextTyped.
+  * @param cursor	Cursor of the scan
+  * @param out	Array the record ids found are returned in
+  * @param max	Maximum number of record ids to return
+  * @param payloads	Array the included attributes of the entries found are returned in, payloadSize bytes each. NULL if they are not wanted
+  * @return	Number of record ids returned
+  */
+template <class T>
+size_t BTreeIndex::scanPrevBatchTyped(ScanCursor& cursor, RecordId* out, size_t max, unsigned char* payloads) {
+    // the scan is complete, nothing left to return
+    if (cursor.nextEntry == -1 || max == 0) {
+        return 0;
+    }
+
+    const T& lowVal = cursor.scanLowVal<T>();
+    Page* currentPageData;
+    bufMgr->readPage(file, cursor.currentPageNum, currentPageData);
+    bufMgr->latchPage(currentPageData);
+    relocateScan<T>(cursor, currentPageData);
+    LeafNode<T>* currentNode = (LeafNode<T>*) currentPageData;
+
+    // nextEntry always points to an entry that satisfies the scan criteria here
+    size_t count = 0;
+    while (count < max) {
+        const RecordId& rid = currentNode->ridArray[cursor.nextEntry];
+        if (isPosting(rid)) {
+            // posting lists are copied from their end
+            const bool resume = cursor.postingPageNum != Page::INVALID_NUMBER;
+            if (!resume) {
+                cursor.postingPageNum = postingStart(rid.page_number, true);
+            }
+            count += copyPosting(cursor.postingPageNum, cursor.postingLastRid, cursor.postingLastRidCopies, resume, true, out + count, max - count);
+            if (cursor.postingPageNum != Page::INVALID_NUMBER) {
+                break;
+            }
+        } else {
+            if (payloads != NULL) {
+                copyPayloads(currentNode, cursor.nextEntry, 1, payloads + count * payloadSize);
+            }
+            out[count++] = rid;
+        }
+        cursor.nextEntry--;
+
+        // current page is used up, move on to the left sibling
+        if (cursor.nextEntry < 0) {
+            if (!moveLeft<T>(cursor.currentPageNum, currentPageData)) {
+                cursor.nextEntry = -1;
+                return count;  // the leftmost leaf was released by moveLeft
+            }
+            currentNode = (LeafNode<T>*) currentPageData;
+            cursor.nextEntry = currentNode->numOccupied - 1;
+            if (cursor.nextEntry < 0) {
+                break;
+            }
+        }
+
+        // stop at the first value that is not in the range
+        if (currentNode->keyArray[cursor.nextEntry] < lowVal ||
+            (currentNode->keyArray[cursor.nextEntry] == lowVal && cursor.lowOp != GTE)) {
+            cursor.nextEntry = -1;
+            break;
+        }
+    }
+
+    if (cursor.nextEntry != -1) {
+        saveScanPosition<T>(cursor, currentNode);
+    }
+    bufMgr->unlatchPage(currentPageData);
+    bufMgr->unPinPage(file, cursor.currentPageNum, false);
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::skipScanBatch
+// -----------------------------------------------------------------------------
+
+template <class T>
+size_t BTreeIndex::skipScanBatchTyped(ScanCursor& cursor, RecordId* out, size_t max, unsigned char* payloads) {
+    size_t count = scanNextBatchTyped<T>(cursor, out, max, payloads);
+    // the group the batch stopped in is used up, the batch goes on in the next one with an entry in range
+    while (count < max && cursor.nextEntry == -1 && cursor.skipWidth > 0 && nextSkipGroup(cursor, false)) {
+        count += scanNextBatchTyped<T>(cursor, out + count, max - count, payloads == NULL ? NULL : payloads + count * payloadSize);
+    }
+    return count;
+}
+
+bool BTreeIndex::nextSkipGroup(ScanCursor& cursor, const bool first) {
+    switch (attributeType) {
+        case COMPOSITE:
+            return nextSkipGroupTyped<CompositeKey>(cursor, first);
+        case COVERING:
+            return nextSkipGroupTyped<CoveringKey>(cursor, first);
+        default:
+            return false;
+    }
+}
+
+template <class T>
+bool BTreeIndex::nextSkipGroupTyped(ScanCursor& cursor, const bool first) {
+    const bool forward = (cursor.direction == FORWARD);
+    const int width = cursor.skipWidth;
+    T from, found, lowVal, highVal;
+    memset(&from, 0, sizeof(T));
+    memset(&lowVal, 0, sizeof(T));
+    memset(&highVal, 0, sizeof(T));
+
+    // the next group starts past every key with the first attribute of the group just scanned, that is past its value
+    // padded with 0xFF going forward and before it padded with 0x00 going backward. The first group is the one
+    // of the smallest or of the largest key
+    Operator op;
+    if (first) {
+        memset(keyAttrsOf(from).data, forward ? 0x00 : 0xFF, COMPOSITESIZE);
+        op = forward ? GTE : LTE;
+    } else {
+        keyAttrsOf(from) = keyAttrsOf(cursor.scanLowVal<T>());
+        memset(keyAttrsOf(from).data + width, forward ? 0xFF : 0x00, COMPOSITESIZE - width);
+        op = forward ? GT : LT;
+    }
+
+    while (seekKey(from, op, found)) {
+        // the range of the group is the range of the second attribute behind the first attribute of the key found
+        keyAttrsOf(lowVal) = cursor.skipLow;
+        keyAttrsOf(highVal) = cursor.skipHigh;
+        memcpy(keyAttrsOf(lowVal).data, keyAttrsOf(found).data, width);
+        memcpy(keyAttrsOf(highVal).data, keyAttrsOf(found).data, width);
+        try {
+            startScanTyped(cursor, lowVal, highVal);
+            return true;
+        } catch (const NoSuchKeyFoundException &e) {
+            // no entry of the group is in range, the search goes on past it
+            keyAttrsOf(from) = keyAttrsOf(found);
+            memset(keyAttrsOf(from).data + width, forward ? 0xFF : 0x00, COMPOSITESIZE - width);
+            op = forward ? GT : LT;
+        }
+    }
+
+    // startScanTyped ended the scan if the last group had no entry in range, it stays open and returns nothing until endScan
+    cursor.scanExecuting = true;
+    cursor.nextEntry = -1;
+    cursor.skipWidth = 0;
+    return false;
+}
+
+template <class T>
+bool BTreeIndex::seekKey(const T& key, const Operator op, T& found) {
+    PageId pageNo;
+    TreePath rootToLeafPath;
+    searchEntry(key, pageNo, rootToLeafPath);
+    Page* currentPageData;
+    bufMgr->readPage(file, pageNo, currentPageData);
+    bufMgr->latchPage(currentPageData);
+    LeafNode<T>* leafNode = (LeafNode<T>*) currentPageData;
+
+    int i;
+    if (op == GT || op == GTE) {
+        // as at the start of a scan, the key found may be in a right sibling of the leaf the search stops at
+        while ((i = (op == GTE) ? nodeLowerBound(leafNode->keyArray, leafNode->numOccupied, key)
+                                : nodeUpperBound(leafNode->keyArray, leafNode->numOccupied, key)) == leafNode->numOccupied) {
+            PageId rightSibPageNo = leafNode->rightSibPageNo;
+            bufMgr->unlatchPage(currentPageData);
+            bufMgr->unPinPage(file, pageNo, false);
+            if (rightSibPageNo == Page::INVALID_NUMBER) {
+                return false;
+            }
+            pageNo = rightSibPageNo;
+            bufMgr->readPage(file, pageNo, currentPageData);
+            bufMgr->latchPage(currentPageData);
+            leafNode = (LeafNode<T>*) currentPageData;
+        }
+    } else {
+        // as at the start of a BACKWARD scan, keys up to the one searched for may continue in the right siblings
+        while (leafNode->rightSibPageNo != Page::INVALID_NUMBER &&
+               (op == LTE ? !(key < leafNode->highKey) : key > leafNode->highKey)) {
+            PageId rightSibPageNo = leafNode->rightSibPageNo;
+            bufMgr->unlatchPage(currentPageData);
+            bufMgr->unPinPage(file, pageNo, false);
+            pageNo = rightSibPageNo;
+            bufMgr->readPage(file, pageNo, currentPageData);
+            bufMgr->latchPage(currentPageData);
+            leafNode = (LeafNode<T>*) currentPageData;
+        }
+        i = (op == LTE) ? nodeUpperBound(leafNode->keyArray, leafNode->numOccupied, key) - 1
+                        : nodeLowerBound(leafNode->keyArray, leafNode->numOccupied, key) - 1;
+        while (i < 0) {
+            if (!moveLeft<T>(pageNo, currentPageData)) {
+                return false;
             }
+            leafNode = (LeafNode<T>*) currentPageData;
+            i = leafNode->numOccupied - 1;
         }
-        i++;
     }
 
-    // At this point, keys and internal nodes have been shifted, except for the node at currInternalNode->pageNoArray[nodeOccupancy], 
-    // therefore, we need to manually move this last node to the last position in the currInternalNode after the insertion and splitting
-    currInternalNode->pageNoArray[currInternalNode->numOccupied] =  currInternalNode->pageNoArray[nodeOccupancy];
+    found = leafNode->keyArray[i];
+    bufMgr->unlatchPage(currentPageData);
+    bufMgr->unPinPage(file, pageNo, false);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::scanNextRecord
+// -----------------------------------------------------------------------------
+
+void BTreeIndex::scanNextRecord(void* record) {
+    indexScan.scanNextRecord(record);
+}
+
+size_t BTreeIndex::scanNextRecordBatch(void* records, size_t max) {
+    return indexScan.scanNextRecordBatch(records, max);
+}
+
+/**
+  * Helper method.
+  * Copies up to max next records of the scan of the cursor over a clustered index. Called by ScanCursor::scanNextRecordBatch
+  * once the key type is known. The scan moves through the leaves like scanNextBatchTyped and scanPrevBatchTyped do, but takes
+  * every entry of a leaf that is in the range at once: a FORWARD scan copies their records with a single copy, since they lie
+  * side by side in key order, and a BACKWARD scan copies them in reverse.
+  * @param cursor	Cursor of the scan
+  * @param out	Array the records found are returned in, recordSize bytes each
+  * @param max	Maximum number of records to return
+  * @return	Number of records returned
+  */
+template <class T>
+size_t BTreeIndex::scanRecordsTyped(ScanCursor& cursor, char* out, size_t max) {
+    // the scan is complete, nothing left to return
+    if (cursor.nextEntry == -1 || max == 0) {
+        return 0;
+    }
+
+    const bool backward = cursor.direction == BACKWARD;
+    const T& lowVal = cursor.scanLowVal<T>();
+    const T& highVal = cursor.scanHighVal<T>();
+    Page* currentPageData;
+    bufMgr->readPage(file, cursor.currentPageNum, currentPageData);
+    bufMgr->latchPage(currentPageData);
+    relocateScan<T>(cursor, currentPageData);
+    LeafNode<T>* currentNode = (LeafNode<T>*) currentPageData;
+
+    // nextEntry always points to an entry that satisfies the scan criteria here
+    size_t count = 0;
+    while (count < max) {
+        const int first = cursor.nextEntry;
+        if (backward) {
+            // the entries from the bound of the range up to first are in it
+            const int lowEnd = (cursor.lowOp == GTE) ? nodeLowerBound(currentNode->keyArray, first + 1, lowVal)
+                                                     : nodeUpperBound(currentNode->keyArray, first + 1, lowVal);
+            const int n = std::max(1, std::min(first + 1 - lowEnd, (int) std::min(max - count, (size_t) first + 1)));
+            for (int k = 0; k < n; k++) {
+                memcpy(out + (count + k) * recordSize, leafRecord(currentNode, first - k), recordSize);
+            }
+            count += n;
+            cursor.nextEntry = first - n;
+
+            // current page is used up, move on to the left sibling
+            if (cursor.nextEntry < 0) {
+                if (!moveLeft<T>(cursor.currentPageNum, currentPageData)) {
+                    cursor.nextEntry = -1;
+                    return count;  // the leftmost leaf was released by moveLeft
+                }
+                currentNode = (LeafNode<T>*) currentPageData;
+                cursor.nextEntry = currentNode->numOccupied - 1;
+                if (cursor.nextEntry < 0) {
+                    break;
+                }
+            }
 
-    // Here, we continue the check at line 496, 
-    // This is a last check to see if the key has been inserted, if not, it is because the key to be inserted is greater than all keys in currInternal node
-    if (!insertedFlag) {
-        currInternalNode->pageNoArray[currInternalNode->numOccupied] = key;
-        if (splitFromLeaf) {
-            currInternalNode->pageNoArray[currInternalNode->numOccupied+1] = newPageNo;
+            // stop at the first value that is not in the range
+            if (currentNode->keyArray[cursor.nextEntry] < lowVal ||
+                (currentNode->keyArray[cursor.nextEntry] == lowVal && cursor.lowOp != GTE)) {
+                cursor.nextEntry = -1;
+                break;
+            }
         } else {
-            // here, currInternalNode->pageNoArray[currInternalNode->numOccupied] is actually the right node
-            currInternalNode->pageNoArray[currInternalNode->numOccupied+1] = currInternalNode->pageNoArray[currInternalNode->numOccupied];
-            currInternalNode->pageNoArray[currInternalNode->numOccupied] = newPageNo;
+            // the entries from first up to the bound of the range are in it
+            const int numLeft = currentNode->numOccupied - first;
+            const int inRange = (cursor.highOp == LTE) ? nodeUpperBound(currentNode->keyArray + first, numLeft, highVal)
+                                                       : nodeLowerBound(currentNode->keyArray + first, numLeft, highVal);
+            const int n = std::max(1, std::min(inRange, (int) std::min(max - count, (size_t) numLeft)));
+            memcpy(out + count * recordSize, leafRecord(currentNode, first), (size_t) n * recordSize);
+            count += n;
+            cursor.nextEntry = first + n;
+
+            // current page is used up, move on to the right sibling
+            if (cursor.nextEntry == currentNode->numOccupied) {
+                PageId rightSibPageNo = currentNode->rightSibPageNo;
+                if (rightSibPageNo == Page::INVALID_NUMBER) {
+                    cursor.nextEntry = -1;
+                    break;
+                }
+                bufMgr->unlatchPage(currentPageData);
+                bufMgr->unPinPage(file, cursor.currentPageNum, false);
+                cursor.currentPageNum = rightSibPageNo;
+                bufMgr->readPage(file, cursor.currentPageNum, currentPageData);
+                bufMgr->latchPage(currentPageData);
+                currentNode = (LeafNode<T>*) currentPageData;
+                readAhead(cursor, rightSibPageNo, currentNode);
+                cursor.nextEntry = 0;
+                if (currentNode->numOccupied == 0) {
+                    cursor.nextEntry = -1;
+                    break;
+                }
+            }
+
+            // stop at the first value that is not in the range
+            if (currentNode->keyArray[cursor.nextEntry] > highVal ||
+                (currentNode->keyArray[cursor.nextEntry] == highVal && cursor.highOp != LTE)) {
+                cursor.nextEntry = -1;
+                break;
+            }
         }
-        currInternalNode->numOccupied++;
-        insertedFlag = true;
     }
 
-    bufMgr->unPinPage(file, pageNo, true);
-    bufMgr->unPinPage(file, newPageNoTemp, true);
+    if (cursor.nextEntry != -1) {
+        saveScanPosition<T>(cursor, currentNode);
+    }
+    bufMgr->unlatchPage(currentPageData);
+    bufMgr->unPinPage(file, cursor.currentPageNum, false);
+    return count;
+}
+
+/**
+  * Helper method.
+  * Moves from a leaf to the leaf on its left. The leaf is released before the left one is latched, since splitters
+  * latch leaves from left to right. The left link may lead further left than the neighbour if that neighbour was split
+  * meanwhile, so the move goes right from there to the leaf whose right link is the one it came from.
+  * @param pageNo	PageId of the leaf, replaced by the PageId of the leaf on its left
+  * @param page	The leaf, pinned and latched by the caller. Replaced by the leaf on its left, pinned and latched
+  * @return	False if the leaf is the leftmost one, then it is released and nothing is latched
+  */
+template <class T>
+bool BTreeIndex::moveLeft(PageId& pageNo, Page*& page) {
+    const PageId rightPageNo = pageNo;
+    PageId leftSibPageNo = ((LeafNode<T>*) page)->leftSibPageNo;
+    bufMgr->unlatchPage(page);
+    bufMgr->unPinPage(file, pageNo, false);
+    if (leftSibPageNo == Page::INVALID_NUMBER) {
+        return false;
+    }
+
+    pageNo = leftSibPageNo;
+    bufMgr->readPage(file, pageNo, page);
+    bufMgr->latchPage(page);
+    LeafNode<T>* node = (LeafNode<T>*) page;
+    while (node->rightSibPageNo != rightPageNo) {
+        PageId rightSibPageNo = node->rightSibPageNo;
+        bufMgr->unlatchPage(page);
+        bufMgr->unPinPage(file, pageNo, false);
+        pageNo = rightSibPageNo;
+        bufMgr->readPage(file, pageNo, page);
+        bufMgr->latchPage(page);
+        node = (LeafNode<T>*) page;
+    }
+    return true;
+}
+
+/**
+  * Helper method.
+  * Called when the scan of the cursor moves to a new leaf. Queues the next right siblings of the leaf to be prefetched into the
+  * buffer pool by the prefetch thread of the buffer manager, taking their page numbers from the parent of the leaf so that
+  * no sibling has to be read to find the next one. No page is read while the caller holds the latch of the leaf.
+  * @param cursor	Cursor of the scan
+  * @param leafPageNo	PageId of the leaf the scan moved to
+  * @param leafNode	The leaf the scan moved to, pinned by the caller
+  */
+template <class T>
+void BTreeIndex::readAhead(ScanCursor& cursor, const PageId leafPageNo, const LeafNode<T>* leafNode) {
+    cursor.leavesScanned++;
+    // nothing to read ahead when the root is a leaf
+    if (cursor.readAheadParentNum == Page::INVALID_NUMBER) {
+        return;
+    }
+
+    // the window doubles with every leaf, up to MAXREADAHEAD leaves and a quarter of the buffer pool
+    const int maxWindow = std::min(MAXREADAHEAD, std::max(1, (int) bufMgr->getNumBufs() / 4));
+    const int window = (cursor.leavesScanned > 5) ? maxWindow : std::min(maxWindow, 1 << (cursor.leavesScanned - 1));
+
+    // the parent is read optimistically, like in searchEntry: the siblings to prefetch are copied out of it and
+    // only used if no writer latched the parent meanwhile
+    bool cached;
+    Page* parentPage = readNonLeaf(cursor.readAheadParentNum, 1, cached);
+    NonLeafNode<T>* parentNode = (NonLeafNode<T>*) parentPage;
+    std::uint32_t version = bufMgr->pageVersion(parentPage);
+    int numOccupied = std::min(std::max(parentNode->numOccupied, 0), nodeOccupancy);
+
+    // the leaf is normally the child right after the previous one, otherwise look it up among the children
+    int slot = cursor.readAheadSlot + 1;
+    if (cursor.readAheadSlot < 0 || slot > numOccupied || nodeChild(parentNode, slot) != leafPageNo) {
+        slot = 0;
+        while (slot <= numOccupied && nodeChild(parentNode, slot) != leafPageNo) {
+            slot++;
+        }
+    }
+
+    // the scan moved past the last child of the parent, descend again to find the parent of the leaf
+    if (slot > numOccupied) {
+        releaseNonLeaf(cursor.readAheadParentNum, cached);
+        cursor.readAheadSlot = -1;
+        if (leafNode->numOccupied == 0) {
+            return;
+        }
+        PageId pageNo;
+        TreePath path;
+        searchEntry(leafNode->keyArray[0], pageNo, path);
+        cursor.readAheadParentNum = path.pageNoArray[path.depth - 1];
+        parentPage = readNonLeaf(cursor.readAheadParentNum, 1, cached);
+        parentNode = (NonLeafNode<T>*) parentPage;
+        version = bufMgr->pageVersion(parentPage);
+        numOccupied = std::min(std::max(parentNode->numOccupied, 0), nodeOccupancy);
+        slot = 0;
+        while (slot <= numOccupied && nodeChild(parentNode, slot) != leafPageNo) {
+            slot++;
+        }
+        // with duplicate keys the leaf may sit under a later parent, then just skip reading ahead this time
+        if (slot > numOccupied) {
+            releaseNonLeaf(cursor.readAheadParentNum, cached);
+            return;
+        }
+    }
 
-    // checks if there is only one node in this tree using our visitedNodes list, a non-empty visited nodes list means we are at least one level in depth of tree
-    if (visitedNodes.size() != 0) {
-        PageId parentPageNo = visitedNodes[visitedNodes.size() - 1];  // gets the parent internal node one level above
-        visitedNodes.erase(visitedNodes.begin() + visitedNodes.size() - 1);  // update the current visitedNodes list by erasing the parentPageNo from it since we moved up one level
-        insertEntryInternal(propagateUpKey, parentPageNo, newPageNoTemp, visitedNodes, false);  // need to insert in internal node, we pass in the parent node
+    // collect the next window siblings. The separator left of a sibling is at most its smallest key,
+    // so stop at the first sibling whose separator is past the scan range
+    const T& highVal = cursor.scanHighVal<T>();
+    const int last = std::min(slot + window, numOccupied);
+    PageId siblings[MAXREADAHEAD];
+    int numSiblings = 0;
+    for (int i = slot + 1; i <= last && nodeKey(parentNode, i - 1) <= highVal; i++) {
+        siblings[numSiblings++] = nodeChild(parentNode, i);
+    }
+    bool valid = bufMgr->validatePage(parentPage, version);
+    releaseNonLeaf(cursor.readAheadParentNum, cached);
+
+    // a concurrent insert changed the parent while it was read, skip reading ahead this time
+    if (!valid) {
+        cursor.readAheadSlot = -1;
+        return;
+    }
+    cursor.readAheadSlot = slot;
 
-    // else, we need to propagate up a key to be a new root
+    // queue the siblings for the prefetch thread, the scan goes on with the latched leaf while they are read
+    for (int i = 0; i < numSiblings; i++) {
+        bufMgr->prefetchPageAsync(file, siblings[i]);
+    }
+}
+
+/**
+  * Helper method.
+  * Saves the next entry of the scan for relocateScan. The entries equal to it that the scan returned before are on its
+  * left in a FORWARD scan and on its right in a BACKWARD one.
+  * @param cursor	Cursor of the scan
+  * @param node	The current leaf of the scan, latched by the caller
+  */
+template <class T>
+void BTreeIndex::saveScanPosition(ScanCursor& cursor, LeafNode<T>* node) {
+    const int entry = cursor.nextEntry;
+    cursor.scanNextKey<T>() = node->keyArray[entry];
+    if (recordSize > 0) {
+        cursor.nextRecord.assign(leafRecord(node, entry), leafRecord(node, entry) + recordSize);
     } else {
-        PageId rootId; // empty page to allocate or is already in buffer pool
-        Page* rootPage;
-        bufMgr->allocPage(file, rootId, rootPage); 
-        NonLeafNodeInt* rootNode = (NonLeafNodeInt*) rootPage;  // new root node
+        cursor.nextRid = node->ridArray[entry];
+    }
+    cursor.nextCopies = 0;
+    const int step = (cursor.direction == BACKWARD) ? 1 : -1;
+    for (int i = entry + step; i >= 0 && i < node->numOccupied && node->keyArray[i] == node->keyArray[entry]; i += step) {
+        if (isScanEntry<T>(cursor, node, i)) {
+            cursor.nextCopies++;
+        }
+    }
+}
+
+template <class T>
+bool BTreeIndex::isScanEntry(const ScanCursor& cursor, LeafNode<T>* node, const int i) const {
+    if (recordSize > 0) {
+        return memcmp(leafRecord(node, i), &cursor.nextRecord[0], recordSize) == 0;
+    }
+    // the link of a posting list changes with its count, and a key has one list in a leaf
+    const RecordId rid = node->ridArray[i];
+    if (isPosting(cursor.nextRid)) {
+        return isPosting(rid);
+    }
+    return rid == cursor.nextRid;
+}
 
-        rootNode->keyArray[0] = propagateUpKey;  // we insert key into this new internal node
-        rootNode->pageNoArray[0] = newPageNoTemp;
-        rootNode->pageNoArray[1] = pageNo;
-        rootNode->numOccupied++;
-        rootNode->level = 0;
+/**
+  * Helper method.
+  * Finds the next entry of the scan again after concurrent inserts may have moved it. Entries move right, within the leaf
+  * or into the new right sibling of a split, or into a posting list when runs of a key are packed. Entries inserted among
+  * the others of the key do not count, the scan only goes on after the ones equal to the next entry it returned before.
+  * The entries of a key in a leaf are in postingLess order, so the ones a posting list took from the leaf that the scan
+  * returned are before the next entry in the list.
+  * @param cursor	Cursor of the scan
+  * @param page	The current leaf of the scan, pinned and latched by the caller. Replaced by the leaf holding the next entry
+  */
+template <class T>
+void BTreeIndex::relocateScan(ScanCursor& cursor, Page*& page) {
+    const T& nextKey = cursor.scanNextKey<T>();
+    const bool backward = cursor.direction == BACKWARD;
+    LeafNode<T>* node = (LeafNode<T>*) page;
+    int skip = cursor.nextCopies;
+    int posting = -1;
+    while (true) {
+        // the entries of the key are searched from the side the scan came from, skipping the copies it returned
+        const int lo = nodeLowerBound(node->keyArray, node->numOccupied, nextKey);
+        const int hi = nodeUpperBound(node->keyArray, node->numOccupied, nextKey);
+        posting = -1;
+        for (int k = 0; k < hi - lo; k++) {
+            const int i = backward ? hi - 1 - k : lo + k;
+            if (isScanEntry<T>(cursor, node, i)) {
+                if (skip == 0) {
+                    cursor.nextEntry = i;
+                    return;
+                }
+                skip--;
+            }
+            if (recordSize == 0 && isPosting(node->ridArray[i])) {
+                posting = i;
+            }
+        }
 
-        bufMgr->unPinPage(file, rootId, true);  // unpin curr page for buffer manager
-        rootPageNum = rootId;  // update root for this B+ tree index
+        // the leaf was split and the next entry went to the right
+        if (node->rightSibPageNo == Page::INVALID_NUMBER || nextKey < node->highKey) {
+            break;
+        }
+        PageId rightSibPageNo = node->rightSibPageNo;
+        bufMgr->unlatchPage(page);
+        bufMgr->unPinPage(file, cursor.currentPageNum, false);
+        cursor.currentPageNum = rightSibPageNo;
+        bufMgr->readPage(file, cursor.currentPageNum, page);
+        bufMgr->latchPage(page);
+        node = (LeafNode<T>*) page;
+    }
 
-        Page * metaPage;  // initialize the meta page according to btree.h
-        bufMgr->readPage(file, headerPageNum, metaPage);
-        IndexMetaInfo* metadata = (IndexMetaInfo*) metaPage;
-        metadata->rootPageNo = rootId;
-        bufMgr->unPinPage(file, headerPageNum, true);  // remember to unpin
+    // the run of the key was packed into a posting list, the scan goes on in the list at the next entry
+    if (posting != -1) {
+        const PageId headPageNo = RecordId(node->ridArray[posting]).page_number;
+        cursor.nextEntry = posting;
+        cursor.postingPageNum = backward ? postingStart(headPageNo, true) : headPageNo;
+        cursor.postingLastRid = cursor.nextRid;
+        cursor.postingLastRidCopies = cursor.nextCopies;
+        return;
     }
+    // entries are never removed, so this is only reached if the copies of a record id were split over two leaves
+    cursor.nextEntry = backward ? nodeUpperBound(node->keyArray, node->numOccupied, nextKey) - 1
+                                : nodeLowerBound(node->keyArray, node->numOccupied, nextKey);
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::startScan
+// BTreeIndex::endScan
 // -----------------------------------------------------------------------------
+//
+void BTreeIndex::endScan() {
+	indexScan.endScan();
+}
 
-void BTreeIndex::startScan(const void* lowValParm,
-				   const Operator lowOpParm,
-				   const void* highValParm,
-				   const Operator highOpParm)
-{
-	if (scanExecuting) endScan();  //end last scan if needed 
-	scanExecuting = true;  //begin new scan
+// -----------------------------------------------------------------------------
+// ScanCursor::ScanCursor -- Constructor
+// -----------------------------------------------------------------------------
 
-	//check if the lower bound and higher bound are vaild
-	if (*((int*)lowValParm) > *((int*)highValParm))
-		throw BadScanrangeException();  //if lowValue > highValue, throw the exception BadScanrangeException
+ScanCursor::ScanCursor(BTreeIndex *index)
+	: index(index), scanExecuting(false), nextEntry(-1), currentPageNum(Page::INVALID_NUMBER),
+	  leavesScanned(0), readAheadParentNum(Page::INVALID_NUMBER), readAheadSlot(-1), nextCopies(0), direction(FORWARD),
+	  postingPageNum(Page::INVALID_NUMBER), skipWidth(0), postingLastRidCopies(0) {
+}
+
+// -----------------------------------------------------------------------------
+// ScanCursor::~ScanCursor -- destructor
+// -----------------------------------------------------------------------------
+
+ScanCursor::~ScanCursor() {
+	// no page is pinned between calls, so there is nothing to release
+	scanExecuting = false;
+}
+
+// -----------------------------------------------------------------------------
+// ScanCursor::startScan
+// -----------------------------------------------------------------------------
 
-	//set up class variables
-	lowValInt = *((int*) lowValParm);
-	highValInt = *((int*) highValParm);
+void ScanCursor::setScanParams(const Operator lowOpParm, const Operator highOpParm, const ScanDirection directionParm)
+{
+	if (scanExecuting) endScan();  //end last scan if needed
 
 	//if lowOperator not belong to GT or GTE, throw BadOpcodesException
 	if (lowOpParm != GT && lowOpParm != GTE)
@@ -620,148 +3920,236 @@ void BTreeIndex::startScan(const void* lowValParm,
 	//if highOperator not belong to LT or LTE, throw BadOpcodesException
 	if (highOpParm != LT && highOpParm != LTE)
 		throw BadOpcodesException();
-    
-	lowOp = lowOpParm;  //set up class variables
+
+	lowOp = lowOpParm;  //set up cursor variables
 	highOp = highOpParm;
-	PageId pageNo; // store the lowest value in the boundry if founded
-	std::vector<PageId> RootToLeafPath; // store the root to lead path (without the lead node)
-	searchEntry(*((int*) lowValParm), pageNo, rootPageNum, RootToLeafPath);  // search and get a leaf page
-
-	currentPageNum = pageNo;
-	bufMgr->readPage(file, currentPageNum, currentPageData);
-	LeafNodeInt* leafNode = (LeafNodeInt*) currentPageData;
-
-	int i = 0;
-	nextEntry = -1; // an initial value for nextEntry for test
-	// go through values starting from the head of the current page
-	while (i < leafNode->numOccupied) {
-		if (leafNode->keyArray[i] < lowValInt){
-			i++;	
-		} else {
-			//if a value equal to the lowValInt, it might not in the give range
-			if (lowOp != GTE && leafNode->keyArray[i] == lowValInt){
-				i++;
-				continue;
-			}
-			//in other cases, we know that current value is the start value of scan
-			else{
-				nextEntry = i;
-				break;
-			}
-		}
+	direction = directionParm;
+	postingPageNum = Page::INVALID_NUMBER;
+	skipWidth = 0;
+}
+
+void ScanCursor::startScan(const void* lowValParm,
+				   const Operator lowOpParm,
+				   const void* highValParm,
+				   const Operator highOpParm,
+				   const ScanDirection directionParm)
+{
+	setScanParams(lowOpParm, highOpParm, directionParm);
+
+	// dispatch once on the key type, the scan below works on typed keys
+	switch (index->attributeType) {
+		case INTEGER:
+			index->startScanTyped(*this, KeyTraits<int>::fromBytes(lowValParm), KeyTraits<int>::fromBytes(highValParm));
+			break;
+		case DOUBLE:
+			index->startScanTyped(*this, KeyTraits<DoubleKey>::fromBytes(lowValParm), KeyTraits<DoubleKey>::fromBytes(highValParm));
+			break;
+		case STRING:
+			index->startScanTyped(*this, KeyTraits<StringKey>::fromBytes(lowValParm), KeyTraits<StringKey>::fromBytes(highValParm));
+			break;
+		case COMPOSITE:
+			index->startScanTyped(*this, index->keyFromBytes<CompositeKey>(lowValParm), index->keyFromBytes<CompositeKey>(highValParm));
+			break;
+		case COVERING:
+			index->startScanTyped(*this, index->keyFromBytes<CoveringKey>(lowValParm), index->keyFromBytes<CoveringKey>(highValParm));
+			break;
 	}
+}
 
-	// if nextEntry == leafNode->numOccupied, that means all the records
-	// in current page are not satisfiled the given range
-	if (nextEntry == leafNode->numOccupied) {
-		bufMgr -> unPinPage(file, currentPageNum, false);
-		endScan();
-		throw NoSuchKeyFoundException();
+// -----------------------------------------------------------------------------
+// ScanCursor::startPrefixScan
+// -----------------------------------------------------------------------------
+
+void ScanCursor::startPrefixScan(const void* lowValParm,
+				   const Operator lowOpParm,
+				   const void* highValParm,
+				   const Operator highOpParm,
+				   const int numAttrs,
+				   const ScanDirection directionParm)
+{
+	if ((index->attributeType != COMPOSITE && index->attributeType != COVERING) || numAttrs < 1 || numAttrs > index->numKeyAttrs)
+		throw BadScanParamException();
+	setScanParams(lowOpParm, highOpParm, directionParm);
+
+	// the keys with a given prefix lie between the prefix padded with 0x00 and the prefix padded with 0xFF, so the low bound
+	// takes the first of them under GTE and steps past the last under GT, and the high bound the other way around
+	CompositeKey lowVal = index->encodeKey((const char*) lowValParm, numAttrs, lowOpParm == GTE ? 0x00 : 0xFF);
+	CompositeKey highVal = index->encodeKey((const char*) highValParm, numAttrs, highOpParm == LTE ? 0xFF : 0x00);
+	if (index->attributeType == COMPOSITE) {
+		index->startScanTyped(*this, lowVal, highVal);
+		return;
 	}
-	
-	//check if it satisfied the given upper boundry, 
-	//since it is possible that the value is greater than the lower boundry
-	//but also greater than the upper boundry 
-	if (leafNode->keyArray[nextEntry] > highValInt ||
-		(leafNode->keyArray[nextEntry] == highValInt && highOp == LT)) {
-		bufMgr->unPinPage(file, currentPageNum, false);
+	CoveringKey lowKey, highKey;
+	lowKey.key = lowVal;
+	highKey.key = highVal;
+	memset(lowKey.payload, 0, PAYLOADSIZE);
+	memset(highKey.payload, 0, PAYLOADSIZE);
+	index->startScanTyped(*this, lowKey, highKey);
+}
+
+// -----------------------------------------------------------------------------
+// ScanCursor::startSkipScan
+// -----------------------------------------------------------------------------
+
+void ScanCursor::startSkipScan(const void* lowValParm,
+				   const Operator lowOpParm,
+				   const void* highValParm,
+				   const Operator highOpParm,
+				   const ScanDirection directionParm)
+{
+	if ((index->attributeType != COMPOSITE && index->attributeType != COVERING) || index->numKeyAttrs < 2)
+		throw BadScanParamException();
+	setScanParams(lowOpParm, highOpParm, directionParm);
+
+	// the bounds of a group are those of a prefix scan on two attributes, behind the first attribute of the group
+	skipLow = index->encodeKey((const char*) lowValParm, 2, lowOpParm == GTE ? 0x00 : 0xFF);
+	skipHigh = index->encodeKey((const char*) highValParm, 2, highOpParm == LTE ? 0xFF : 0x00);
+	int width = keyAttrWidth(index->keyAttrs[0].attrType);
+	memset(skipLow.data, 0, width);
+	memset(skipHigh.data, 0, width);
+	if (skipLow > skipHigh)
+		throw BadScanrangeException();
+
+	skipWidth = width;
+	scanExecuting = true;
+	if (!index->nextSkipGroup(*this, true)) {
 		endScan();
 		throw NoSuchKeyFoundException();
 	}
+}
+
+// -----------------------------------------------------------------------------
+// ScanCursor::scanNext
+// -----------------------------------------------------------------------------
+
+void ScanCursor::scanNext(RecordId& outRid) {
+	//throw exception if there is no executing scan
+	if (!scanExecuting)
+		throw ScanNotInitializedException();
+	// the leaves of a clustered index hold no record ids
+	index->checkStorage(SECONDARY);
+
+	switch (index->attributeType) {
+		case INTEGER:
+			index->scanNextTyped<int>(*this, outRid);
+			break;
+		case DOUBLE:
+			index->scanNextTyped<DoubleKey>(*this, outRid);
+			break;
+		case STRING:
+			index->scanNextTyped<StringKey>(*this, outRid);
+			break;
+		case COMPOSITE:
+			index->scanNextTyped<CompositeKey>(*this, outRid);
+			break;
+		case COVERING:
+			index->scanNextTyped<CoveringKey>(*this, outRid);
+			break;
+	}
+}
 
-	bufMgr->unPinPage(file, currentPageNum, false);  //unpin the current page
+// -----------------------------------------------------------------------------
+// ScanCursor::scanNextBatch
+// -----------------------------------------------------------------------------
+
+size_t ScanCursor::scanNextBatch(RecordId* out, size_t max) {
+	//throw exception if there is no executing scan
+	if (!scanExecuting)
+		throw ScanNotInitializedException();
+	index->checkStorage(SECONDARY);
+
+	switch (index->attributeType) {
+		case INTEGER:
+			return index->scanNextBatchTyped<int>(*this, out, max);
+		case DOUBLE:
+			return index->scanNextBatchTyped<DoubleKey>(*this, out, max);
+		case STRING:
+			return index->scanNextBatchTyped<StringKey>(*this, out, max);
+		case COMPOSITE:
+			return index->skipScanBatchTyped<CompositeKey>(*this, out, max);
+		case COVERING:
+			return index->skipScanBatchTyped<CoveringKey>(*this, out, max);
+	}
+	return 0;
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::scanNext
+// ScanCursor::scanNext with included attributes
 // -----------------------------------------------------------------------------
 
-void BTreeIndex::scanNext(RecordId& outRid) {
-    //throw exception if there is no executing scan
-    if (!scanExecuting)
-        throw ScanNotInitializedException();
+void ScanCursor::scanNext(RecordId& outRid, void* payload) {
+	if (scanNextBatch(&outRid, payload, 1) == 0)
+		throw IndexScanCompletedException();
+}
 
-    bufMgr->readPage(file, currentPageNum, currentPageData);  //read current page
+// -----------------------------------------------------------------------------
+// ScanCursor::scanNextBatch with included attributes
+// -----------------------------------------------------------------------------
 
-    // check if we reached the last node within our range or if we reached an invalid node, the scan is complete in either case
-    if (nextEntry == -1) {
-        bufMgr -> unPinPage(file, currentPageNum, false);
-        throw IndexScanCompletedException();
-    }
+size_t ScanCursor::scanNextBatch(RecordId* out, void* payloads, size_t max) {
+	//throw exception if there is no executing scan
+	if (!scanExecuting)
+		throw ScanNotInitializedException();
+	// only the leaf entries of a covering index have included attributes
+	if (index->attributeType != COVERING)
+		throw BadScanParamException();
 
-    LeafNodeInt* currentNode = (LeafNodeInt*) currentPageData;  //get the current Node
+	return index->skipScanBatchTyped<CoveringKey>(*this, out, max, (unsigned char*) payloads);
+}
 
-    // use nextEntry to get the corresponding record id from the currentNode as the returned value
-    outRid = currentNode->ridArray[nextEntry];
+// -----------------------------------------------------------------------------
+// ScanCursor::scanNextRecord
+// -----------------------------------------------------------------------------
 
-    // In the current node, there might exist another valid value
-    if ((nextEntry +1) < currentNode->numOccupied) {
-        //in this case, the next scan is invaild
-        if ((currentNode->keyArray[nextEntry +1] == highValInt) &&
-            (highOp  != LTE)){
-            bufMgr->unPinPage(file, currentPageNum, false);
-            //for the next call of scanNext, it would just end the Scan
-            nextEntry = -1;
-            return;
-        } else if (currentNode->keyArray[nextEntry +1] <= highValInt) {
-            nextEntry += 1;
-            bufMgr->unPinPage(file, currentPageNum, false);
-            return;
-        } else {
-            bufMgr->unPinPage(file, currentPageNum, false);
-            //for the next call of scanNext, it would just end the Scan, since the next value is not in the range
-            nextEntry = -1;
-            return;
-        }
-    } else {
-        if (currentNode->rightSibPageNo == Page::INVALID_NUMBER) {
-            bufMgr->unPinPage(file, currentPageNum, false);
-            //for the next call of scanNext, it would just end the Scan, since the next value is not in the range
-            nextEntry = -1;
-            return;
-        } else {
-            bufMgr->unPinPage(file, currentPageNum, false);
-            //update to the next page
-            currentPageNum = currentNode->rightSibPageNo;
-            bufMgr->readPage(file, currentPageNum, currentPageData);
+void ScanCursor::scanNextRecord(void* record) {
+	if (scanNextRecordBatch(record, 1) == 0)
+		throw IndexScanCompletedException();
+}
 
-            //update the current node that we are currently go through
-            currentNode = (LeafNodeInt*) currentPageData;
+// -----------------------------------------------------------------------------
+// ScanCursor::scanNextRecordBatch
+// -----------------------------------------------------------------------------
 
-            if (currentNode->numOccupied == 0) {
-                nextEntry = -1;
-                bufMgr->unPinPage(file, currentPageNum, false);
-                return;
-            }
-            if ((currentNode->keyArray[0] == highValInt) &&
-                highOp  != LTE){
-                bufMgr->unPinPage(file, currentPageNum, false);
-                //for the next call of scanNext, it would just end the Scan
-                nextEntry = -1;
-                return;
-            } else if (currentNode->keyArray[0] < highValInt) {
-                nextEntry = 0;
-                bufMgr->unPinPage(file, currentPageNum, false);
-                return;
-            } else {
-                bufMgr->unPinPage(file, currentPageNum, false);
-                //for the next call of scanNext, it would just end the Scan, since the next value is not in the range
-                nextEntry = -1;
-                return;
-            }
-        }
-    }
+size_t ScanCursor::scanNextRecordBatch(void* records, size_t max) {
+	//throw exception if there is no executing scan
+	if (!scanExecuting)
+		throw ScanNotInitializedException();
+	// only the leaves of a clustered index hold records
+	index->checkStorage(CLUSTERED);
+
+	switch (index->attributeType) {
+		case INTEGER:
+			return index->scanRecordsTyped<int>(*this, (char*) records, max);
+		case DOUBLE:
+			return index->scanRecordsTyped<DoubleKey>(*this, (char*) records, max);
+		case STRING:
+			return index->scanRecordsTyped<StringKey>(*this, (char*) records, max);
+		case COMPOSITE:
+			return index->scanRecordsTyped<CompositeKey>(*this, (char*) records, max);
+		case COVERING:
+			return index->scanRecordsTyped<CoveringKey>(*this, (char*) records, max);
+	}
+	return 0;
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::endScan
+// ScanCursor::endScan
 // -----------------------------------------------------------------------------
-//
-void BTreeIndex::endScan() {
+
+void ScanCursor::endScan() {
 	//throw exception if there is no executing scan
 	if (!scanExecuting)
 		throw ScanNotInitializedException();
 	scanExecuting = false;
-	//no need to unpin pages since we already unpinned in scanNext and startScan
+	nextEntry = -1;
+	//no need to unpin pages since no page stays pinned between calls
+}
+
+// -----------------------------------------------------------------------------
+// ScanCursor::isScanExecuting
+// -----------------------------------------------------------------------------
+
+bool ScanCursor::isScanExecuting() const {
+	return scanExecuting;
 }
 }
@@ -11,13 +11,19 @@
 #include <string>
 #include "string.h"
 #include <sstream>
+#include <cstddef>
 #include <math.h>
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
 
 #include "types.h"
 #include "page.h"
 #include "file.h"
 #include "buffer.h"
+#include "node_search.h"
+#include "posting_list.h"
 
 namespace badgerdb
 {
@@ -29,7 +35,9 @@ enum Datatype
 {
 	INTEGER = 0,
 	DOUBLE = 1,
-	STRING = 2
+	STRING = 2,
+	COMPOSITE = 3,	/* Key of several attributes, of the types above, see KeyAttr */
+	COVERING = 4	/* Key of one or more attributes like COMPOSITE, with more attributes included in the leaf entries */
 };
 
 /**
@@ -43,21 +51,439 @@ enum Operator
 	GT		/* Greater Than */
 };
 
+/**
+ * @brief Scan directions. Passed to BTreeIndex::startScan() method.
+ */
+enum ScanDirection
+{
+	FORWARD,	/* From the low value up, in ascending key order */
+	BACKWARD	/* From the high value down, in descending key order */
+};
+
+/**
+ * @brief Split policies. Decide how many entries the left node keeps when an insert overflows a node.
+ */
+enum SplitPolicy
+{
+	EVENSPLIT,				/* Always split in the middle */
+	APPENDSPLIT,			/* Split in the middle, except when the insert appends past the last key of the rightmost node of its level:
+										   then the left node keeps the fill factor of the entries, 90/10 at 0.9 and 100/0 at 1 */
+	FILLFACTORSPLIT		/* The left node always keeps the fill factor of the entries, for keys that mostly increase but not strictly */
+};
+
+/**
+ * @brief Storage modes of a single attribute index. Passed to BTreeIndex constructor.
+ */
+enum StorageMode
+{
+	SECONDARY,	/* Leaves hold the record ids of the tuples, which stay in the heap file of the relation */
+	CLUSTERED		/* Leaves hold the tuples themselves in key order, so the index is the table */
+};
+
+/**
+ * @brief Size of String key. Only the first STRINGSIZE characters of a string attribute are indexed.
+ */
+const  int STRINGSIZE = 10;
+
+/**
+ * @brief Fixed width key for STRING attributes, stored in the order-preserving form of fromBytes: the zero padded
+ * characters read as two big-endian numbers, the first 8 characters and the last 2. Keys compare as those two
+ * integers, which order the way strncmp orders the strings, so no comparison reads the characters.
+ * Packed to STRINGSIZE bytes, the size of the characters.
+ */
+#pragma pack( push, 2 )
+struct StringKey{
+  /**
+   * First 8 characters of the key as a big-endian number.
+   */
+	std::uint64_t head;
+
+  /**
+   * Last 2 characters of the key as a big-endian number.
+   */
+	std::uint16_t tail;
+
+  /**
+   * Returns the key of the zero padded characters of a string.
+   */
+	static StringKey fromChars( const char* chars )
+	{
+		StringKey key;
+		key.head = loadBigEndian64( chars );
+		key.tail = (std::uint16_t) loadBigEndian16( chars + 8 );
+		return key;
+	}
+
+  /**
+   * Writes the STRINGSIZE zero padded characters of the key, the inverse of fromChars.
+   */
+	void toChars( char* chars ) const
+	{
+		for( int i = 0; i < 8; i++ )
+			chars[ i ] = (char) ( head >> ( 56 - 8 * i ) );
+		chars[ 8 ] = (char) ( tail >> 8 );
+		chars[ 9 ] = (char) tail;
+	}
+
+	bool operator<( const StringKey& rhs ) const { return head < rhs.head || ( head == rhs.head && tail < rhs.tail ); }
+	bool operator>( const StringKey& rhs ) const { return rhs < *this; }
+	bool operator<=( const StringKey& rhs ) const { return !( rhs < *this ); }
+	bool operator>=( const StringKey& rhs ) const { return !( *this < rhs ); }
+	bool operator==( const StringKey& rhs ) const { return head == rhs.head && tail == rhs.tail; }
+	bool operator!=( const StringKey& rhs ) const { return !( *this == rhs ); }
+};
+#pragma pack( pop )
+
+static_assert( STRINGSIZE == 10 && sizeof( StringKey ) == STRINGSIZE, "StringKey holds a key as 8 and 2 characters." );
+
+/**
+ * @brief Key for DOUBLE attributes, the double in the order-preserving form of normalizeDouble. Keys compare as
+ * 64 bit integers, so nodes are searched with the integer kernel and never compare doubles.
+ */
+struct DoubleKey{
+  /**
+   * Normalized bits of the double.
+   */
+	std::int64_t bits;
+
+	bool operator<( const DoubleKey& rhs ) const { return bits < rhs.bits; }
+	bool operator>( const DoubleKey& rhs ) const { return bits > rhs.bits; }
+	bool operator<=( const DoubleKey& rhs ) const { return bits <= rhs.bits; }
+	bool operator>=( const DoubleKey& rhs ) const { return bits >= rhs.bits; }
+	bool operator==( const DoubleKey& rhs ) const { return bits == rhs.bits; }
+	bool operator!=( const DoubleKey& rhs ) const { return bits != rhs.bits; }
+};
+
+/**
+ * @brief nodeLowerBound for DOUBLE keys, the 64 bit integer kernel on the normalized bits.
+ */
+inline int nodeLowerBound( const DoubleKey* keys, int n, const DoubleKey& key )
+{
+	return nodeLowerBound( &keys->bits, n, key.bits );
+}
+
+/**
+ * @brief nodeUpperBound for DOUBLE keys, see nodeLowerBound.
+ */
+inline int nodeUpperBound( const DoubleKey* keys, int n, const DoubleKey& key )
+{
+	return nodeUpperBound( &keys->bits, n, key.bits );
+}
+
+/**
+ * @brief Largest number of attributes in the key of a composite index.
+ */
+const int MAXKEYATTRS = 4;
+
+/**
+ * @brief Size of a composite key. The encoded attributes of the key of a composite index must fit in it.
+ */
+const int COMPOSITESIZE = 24;
+
+/**
+ * @brief An attribute of the key of a composite index.
+ */
+struct KeyAttr{
+  /**
+   * Offset of the attribute inside the record.
+   */
+	int attrByteOffset;
+
+  /**
+   * Type of the attribute, INTEGER, DOUBLE or STRING.
+   */
+	Datatype attrType;
+};
+
+/**
+ * @brief Returns the number of bytes encodeKeyAttr writes for an attribute of a type.
+ */
+inline int keyAttrWidth( const Datatype attrType )
+{
+	return attrType == INTEGER ? (int) sizeof( int ) : attrType == DOUBLE ? (int) sizeof( double ) : STRINGSIZE;
+}
+
+/**
+ * @brief Writes an attribute value in a binary form that orders like the value when compared byte by byte:
+ * an int or a normalized double with the sign bit flipped, in big-endian order, or a string zero padded to STRINGSIZE.
+ * @return Number of bytes written, keyAttrWidth( attrType ).
+ */
+inline int encodeKeyAttr( const Datatype attrType, const char* value, unsigned char* out )
+{
+	std::uint64_t bits;
+	int width = keyAttrWidth( attrType );
+	if( attrType == STRING )
+	{
+		strncpy( (char*) out, value, STRINGSIZE );
+		return width;
+	}
+	if( attrType == INTEGER )
+		bits = (std::uint32_t) *( (const int*) value ) ^ 0x80000000u;
+	else
+		bits = (std::uint64_t) normalizeDouble( *( (const double*) value ) ) ^ 0x8000000000000000ull;
+	for( int i = width - 1; i >= 0; i-- )
+	{
+		out[ i ] = (unsigned char) bits;
+		bits >>= 8;
+	}
+	return width;
+}
+
+/**
+ * @brief Key of a composite index: the key attributes one after the other as encodeKeyAttr writes them, zero padded.
+ * Keys compare byte by byte like memcmp, as three big-endian numbers, so they order by the first attribute,
+ * then by the second, and so on. Every key with the same first attributes lies in one range of the index.
+ */
+struct CompositeKey{
+  /**
+   * Encoded attributes of the key.
+   */
+	unsigned char data[ COMPOSITESIZE ];
+
+  /**
+   * Returns a negative number, zero or a positive number as the key is less than, equal to or greater than rhs.
+   */
+	int compare( const CompositeKey& rhs ) const
+	{
+		for( int i = 0; i < COMPOSITESIZE; i += 8 )
+		{
+			std::uint64_t word = loadBigEndian64( (const char*) data + i ), rhsWord = loadBigEndian64( (const char*) rhs.data + i );
+			if( word != rhsWord )
+				return word < rhsWord ? -1 : 1;
+		}
+		return 0;
+	}
+
+	bool operator<( const CompositeKey& rhs ) const { return compare( rhs ) < 0; }
+	bool operator>( const CompositeKey& rhs ) const { return compare( rhs ) > 0; }
+	bool operator<=( const CompositeKey& rhs ) const { return compare( rhs ) <= 0; }
+	bool operator>=( const CompositeKey& rhs ) const { return compare( rhs ) >= 0; }
+	bool operator==( const CompositeKey& rhs ) const { return memcmp( data, rhs.data, COMPOSITESIZE ) == 0; }
+	bool operator!=( const CompositeKey& rhs ) const { return memcmp( data, rhs.data, COMPOSITESIZE ) != 0; }
+};
+
+static_assert( COMPOSITESIZE % 8 == 0, "CompositeKey::compare reads a key 8 bytes at a time." );
+
+/**
+ * @brief Largest number of included attributes of a covering index.
+ */
+const int MAXINCLUDEATTRS = 4;
+
+/**
+ * @brief Number of bytes a covering index keeps for the included attributes of an entry.
+ */
+const int PAYLOADSIZE = 16;
+
+/**
+ * @brief Key of a covering index: a composite key and the included attributes of the entry. Only the composite key
+ * takes part in comparisons. The included bytes are kept as the record stores them: ints and doubles as they are and
+ * strings zero padded to STRINGSIZE, one after the other. Nodes store only the composite key, a leaf keeps the included
+ * bytes of its entries in a separate array, so separators in non-leaf nodes are no wider than those of a composite index.
+ * Converts to and from the composite key, which compares against it directly.
+ */
+struct CoveringKey{
+	CoveringKey() = default;
+
+  /**
+   * Key with the given key attributes and no included attributes, as a node stores it.
+   */
+	CoveringKey( const CompositeKey& k ) : key( k ) { memset( payload, 0, PAYLOADSIZE ); }
+
+	operator const CompositeKey&() const { return key; }
+
+  /**
+   * Key attributes of the entry.
+   */
+	CompositeKey key;
+
+  /**
+   * Included attributes of the entry, zero padded.
+   */
+	unsigned char payload[ PAYLOADSIZE ];
+
+	bool operator<( const CoveringKey& rhs ) const { return key < rhs.key; }
+	bool operator>( const CoveringKey& rhs ) const { return key > rhs.key; }
+	bool operator<=( const CoveringKey& rhs ) const { return key <= rhs.key; }
+	bool operator>=( const CoveringKey& rhs ) const { return key >= rhs.key; }
+	bool operator==( const CoveringKey& rhs ) const { return key == rhs.key; }
+	bool operator!=( const CoveringKey& rhs ) const { return key != rhs.key; }
+	bool operator<( const CompositeKey& rhs ) const { return key < rhs; }
+	bool operator>( const CompositeKey& rhs ) const { return key > rhs; }
+	bool operator<=( const CompositeKey& rhs ) const { return key <= rhs; }
+	bool operator>=( const CompositeKey& rhs ) const { return key >= rhs; }
+	bool operator==( const CompositeKey& rhs ) const { return key == rhs; }
+	bool operator!=( const CompositeKey& rhs ) const { return key != rhs; }
+};
+
+/**
+ * @brief nodeLowerBound for a COVERING key searched among the composite keys a node stores.
+ */
+inline int nodeLowerBound( const CompositeKey* keys, int n, const CoveringKey& key )
+{
+	return nodeLowerBound( keys, n, key.key );
+}
+
+/**
+ * @brief nodeUpperBound for a COVERING key, see nodeLowerBound.
+ */
+inline int nodeUpperBound( const CompositeKey* keys, int n, const CoveringKey& key )
+{
+	return nodeUpperBound( keys, n, key.key );
+}
+
+/**
+ * @brief Returns the key attributes of a composite or covering key.
+ */
+inline CompositeKey& keyAttrsOf( CompositeKey& key ) { return key; }
+inline CompositeKey& keyAttrsOf( CoveringKey& key ) { return key.key; }
+
+/**
+ * @brief Record id as leaves store it, packed into 6 bytes. RecordId pads its 6 bytes to 8, a leaf leaves the padding out,
+ * which raises the fanout of leaves by a fifth for INTEGER keys. The record ids are not compressed any further, every
+ * entry keeps its fixed slot. Converts to and from RecordId.
+ */
+struct LeafRid{
+  /**
+   * High and low half of the page number, apart so that the struct needs no padding.
+   */
+	std::uint16_t pageHigh;
+	std::uint16_t pageLow;
+
+  /**
+   * Number of slot within the page.
+   */
+	SlotId slotNumber;
+
+	LeafRid() {}
+	LeafRid( const RecordId& rid )
+		: pageHigh( (std::uint16_t) ( rid.page_number >> 16 ) ), pageLow( (std::uint16_t) rid.page_number ), slotNumber( rid.slot_number ) {}
+
+	operator RecordId() const
+	{
+		RecordId rid;
+		rid.page_number = ( (PageId) pageHigh << 16 ) | pageLow;
+		rid.slot_number = slotNumber;
+		rid.padding = 0;
+		return rid;
+	}
+};
+
+/**
+ * @brief Unpacks the record ids of n leaf entries into out.
+ */
+inline void unpackLeafRids( const LeafRid* in, int n, RecordId* out )
+{
+	for( int i = 0; i < n; i++ )
+		out[ i ] = in[ i ];
+}
+
+/**
+ * @brief Position of the first of n leaf entries with a key greater than key, or with key and a record id not less than rid.
+ * The entries of a key are kept in postingLess order, the order a posting list of the key would have them in.
+ * The keys are of the type the leaf stores, which for a covering index is the composite key part of key.
+ */
+template <class K, class T>
+inline int entryLowerBound( const K* keys, const LeafRid* rids, int n, const T& key, const RecordId& rid )
+{
+	int pos = nodeLowerBound( keys, n, key );
+	while( pos < n && keys[ pos ] == key && postingLess( rids[ pos ], rid ) )
+		pos++;
+	return pos;
+}
+
 
 /**
  * @brief Number of key slots in B+Tree leaf for INTEGER key.
  */
-//                                                  sibling ptr             key               rid
-const  int INTARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( RecordId ) );
+//                                                  numOccupied, pendingCount sibling ptrs            high key             key               rid
+const  int INTARRAYLEAFSIZE = ( Page::SIZE - 2 * sizeof( int ) - 2 * sizeof( PageId ) - sizeof( int ) ) / ( sizeof( int ) + sizeof( LeafRid ) );
+
+/**
+ * @brief Number of key slots in B+Tree leaf for DOUBLE key.
+ */
+//                                                     numOccupied, pendingCount sibling ptrs              high key                key               rid
+const  int DOUBLEARRAYLEAFSIZE = ( Page::SIZE - 2 * sizeof( int ) - 2 * sizeof( PageId ) - sizeof( DoubleKey ) ) / ( sizeof( DoubleKey ) + sizeof( LeafRid ) );
+
+/**
+ * @brief Number of key slots in B+Tree leaf for STRING key.
+ */
+//                                                     numOccupied, pendingCount sibling ptrs                high key                  key                   rid
+const  int STRINGARRAYLEAFSIZE = ( Page::SIZE - 2 * sizeof( int ) - 2 * sizeof( PageId ) - sizeof( StringKey ) ) / ( sizeof( StringKey ) + sizeof( LeafRid ) );
+
+/**
+ * @brief Number of key slots in B+Tree leaf for COMPOSITE key.
+ */
+//                                                        numOccupied, pendingCount sibling ptrs                 high key                     key                    rid
+const  int COMPOSITEARRAYLEAFSIZE = ( Page::SIZE - 2 * sizeof( int ) - 2 * sizeof( PageId ) - sizeof( CompositeKey ) ) / ( sizeof( CompositeKey ) + sizeof( LeafRid ) );
+
+/**
+ * @brief Number of key slots in B+Tree leaf for COVERING key.
+ */
+//                                                       numOccupied, pendingCount sibling ptrs                 high key                     key                    rid             payload
+const  int COVERINGARRAYLEAFSIZE = ( Page::SIZE - 2 * sizeof( int ) - 2 * sizeof( PageId ) - sizeof( CompositeKey ) ) / ( sizeof( CompositeKey ) + sizeof( LeafRid ) + PAYLOADSIZE );
 
 /**
  * @brief Number of key slots in B+Tree non-leaf for INTEGER key.
  */
-//                                                     level     extra pageNo                  key       pageNo
-const  int INTARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( PageId ) );
+//                                                     level       numOccupied     sibling ptr          high key        extra pageNo     extra count                  key       pageNo         count
+const  int INTARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( int ) - sizeof( PageId ) - sizeof( int ) - sizeof( PageId ) - sizeof( int ) ) / ( sizeof( int ) + sizeof( PageId ) + sizeof( int ) );
+
+/**
+ * @brief Number of key slots in B+Tree non-leaf for DOUBLE key.
+ */
+//                                                        level       numOccupied     sibling ptr           high key          extra pageNo     extra count                 key          pageNo         count
+const  int DOUBLEARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( int ) - sizeof( PageId ) - sizeof( DoubleKey ) - sizeof( PageId ) - sizeof( int ) ) / ( sizeof( DoubleKey ) + sizeof( PageId ) + sizeof( int ) );
+
+/**
+ * @brief Slot of a child in a STRING non-leaf node: the child, the number of entries in its subtree, and where the
+ * separator left of the child starts in the key bytes of the node. Packed so that a slot takes 10 bytes.
+ */
+#pragma pack( push, 2 )
+struct NodeSlot{
+	PageId pageNo;
+	int count;
+	std::uint16_t keyOffset;
+};
+#pragma pack( pop )
+
+/**
+ * @brief Number of bytes a STRING non-leaf node holds its slots and separators in.
+ */
+//                                                          level       numOccupied     sibling ptr             high key                   keyStart
+const  int STRINGNODEDATASIZE = Page::SIZE - sizeof( int ) - sizeof( int ) - sizeof( PageId ) - sizeof( StringKey ) - sizeof( std::uint16_t );
+
+/**
+ * @brief Largest number of keys in a B+Tree non-leaf for STRING key, reached when every separator is the empty string.
+ * Separators are stored without their zero padding, so the number of keys a node holds depends on their length.
+ */
+//                                                          extra slot                    slot         length byte
+const  int STRINGARRAYNONLEAFSIZE = ( STRINGNODEDATASIZE - sizeof( NodeSlot ) ) / ( sizeof( NodeSlot ) + 1 );
+
+/**
+ * @brief Number of key slots in B+Tree non-leaf for COMPOSITE key.
+ */
+//                                                           level       numOccupied     sibling ptr              high key                extra pageNo     extra count                    key               pageNo         count
+const  int COMPOSITEARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( int ) - sizeof( PageId ) - sizeof( CompositeKey ) - sizeof( PageId ) - sizeof( int ) ) / ( sizeof( CompositeKey ) + sizeof( PageId ) + sizeof( int ) );
+
+/**
+ * @brief Number of key slots in B+Tree non-leaf for COVERING key. Non-leaf nodes store the composite key alone.
+ */
+const  int COVERINGARRAYNONLEAFSIZE = COMPOSITEARRAYNONLEAFSIZE;
+
+/**
+ * @brief Default fraction of each leaf and non-leaf node that is filled when an index is bulk loaded.
+ * Leaving some room free lets later inserts land without splitting right away.
+ */
+const float DEFAULTFILLFACTOR = 0.9;
+
+/**
+ * @brief Default split policy. Keys that increase, like timestamps and sequence numbers, leave full nodes
+ * behind instead of half full ones, and other inserts split as before.
+ */
+const SplitPolicy DEFAULTSPLITPOLICY = APPENDSPLIT;
 
 /**
- * @brief Structure to store a key-rid pair. It is used to pass the pair to functions that 
+ * @brief Structure to store a key-rid pair. It is used to pass the pair to functions that
  * add to or make changes to the leaf node pages of the tree. Is templated for the key member.
  */
 template <class T>
@@ -73,7 +499,7 @@ public:
 };
 
 /**
- * @brief Structure to store a key page pair which is used to pass the key and page to functions that make 
+ * @brief Structure to store a key page pair which is used to pass the key and page to functions that make
  * any modifications to the non leaf pages of the tree.
 */
 template <class T>
@@ -90,8 +516,8 @@ public:
 
 /**
  * @brief Overloaded operator to compare the key values of two rid-key pairs
- * and if they are the same compares to see if the first pair has
- * a smaller rid.pageNo value.
+ * and if they are the same compares their rids in postingLess order, the order
+ * the entries of a key are kept in.
 */
 template <class T>
 bool operator<( const RIDKeyPair<T>& r1, const RIDKeyPair<T>& r2 )
@@ -99,272 +525,2238 @@ bool operator<( const RIDKeyPair<T>& r1, const RIDKeyPair<T>& r2 )
 	if( r1.key != r2.key )
 		return r1.key < r2.key;
 	else
-		return r1.rid.page_number < r2.rid.page_number;
+		return postingLess( r1.rid, r2.rid );
 }
 
 /**
- * @brief The meta page, which holds metadata for Index file, is always first page of the btree index file and is cast
- * to the following structure to store or retrieve information from it.
- * Contains the relation name for which the index is created, the byte offset
- * of the key value on which the index is made, the type of the key and the page no
- * of the root page. Root page starts as page 2 but since a split can occur
- * at the root the root page may get moved up and get a new page no.
+ * @brief Compile time description of a key type the B+ Tree can be built over: the Datatype it stands for,
+ * the fanout of leaf and non-leaf nodes, the type nodes store the key as, how a key is read from a record or a scan parameter,
+ * and the separator a leaf split puts between two leaves.
+ * Specialized for int, DoubleKey, StringKey, CompositeKey and CoveringKey.
 */
-struct IndexMetaInfo{
+template <class T>
+struct KeyTraits;
+
+template <>
+struct KeyTraits<int>{
+	static const Datatype TYPE = INTEGER;
+	static const int LEAFSIZE = INTARRAYLEAFSIZE;
+	static const int NONLEAFSIZE = INTARRAYNONLEAFSIZE;
+	typedef int NodeKey;
+
   /**
-   * Name of base relation.
+   * Reads a key from the attribute bytes of a record or from a scan parameter.
    */
-	char relationName[20];
+	static int fromBytes( const void* bytes ) { return *( (const int*) bytes ); }
 
   /**
-   * Offset of attribute, over which index is built, inside the record stored in pages.
+   * Returns the separator between a leaf ending with key left and its right sibling starting with key right.
    */
-	int attrByteOffset;
+	static int separator( const int& left, const int& right ) { return right; }
+};
+
+template <>
+struct KeyTraits<DoubleKey>{
+	static const Datatype TYPE = DOUBLE;
+	static const int LEAFSIZE = DOUBLEARRAYLEAFSIZE;
+	static const int NONLEAFSIZE = DOUBLEARRAYNONLEAFSIZE;
+	typedef DoubleKey NodeKey;
 
   /**
-   * Type of the attribute over which index is built.
+   * Reads a key from the attribute bytes of a record or from a scan parameter.
    */
-	Datatype attrType;
+	static DoubleKey fromBytes( const void* bytes )
+	{
+		DoubleKey key;
+		key.bits = normalizeDouble( *( (const double*) bytes ) );
+		return key;
+	}
 
   /**
-   * Page number of root page of the B+ Tree inside the file index file.
+   * Returns the separator between a leaf ending with key left and its right sibling starting with key right.
    */
-	PageId rootPageNo;
+	static DoubleKey separator( const DoubleKey& left, const DoubleKey& right ) { return right; }
 };
 
-/*
-Each node is a page, so once we read the page in we just cast the pointer to the page to this struct and use it to access the parts
-These structures basically are the format in which the information is stored in the pages for the index file depending on what kind of 
-node they are. The level memeber of each non leaf structure seen below is set to 1 if the nodes 
-at this level are just above the leaf nodes. Otherwise set to 0.
-*/
+template <>
+struct KeyTraits<StringKey>{
+	static const Datatype TYPE = STRING;
+	static const int LEAFSIZE = STRINGARRAYLEAFSIZE;
+	static const int NONLEAFSIZE = STRINGARRAYNONLEAFSIZE;
+	typedef StringKey NodeKey;
 
-/**
- * @brief Structure for all non-leaf nodes when the key is of INTEGER type.
-*/
-struct NonLeafNodeInt{
   /**
-   * Level of the node in the tree.
+   * Reads a key from the attribute bytes of a record or from a scan parameter. Only the first
+   * STRINGSIZE characters are kept, the rest of the key is zero padded.
    */
-	int level;
+	static StringKey fromBytes( const void* bytes )
+	{
+		char chars[ STRINGSIZE ] = {};
+		memcpy( chars, bytes, strnlen( (const char*) bytes, STRINGSIZE ) );
+		return StringKey::fromChars( chars );
+	}
 
   /**
-  * (Added) Number of filled slots in an internal node
-  */
-  int numOccupied;
+   * Returns the separator between a leaf ending with key left and its right sibling starting with key right:
+   * the shortest prefix of right that is greater than left, zero padded. Equal keys are separated by the key itself.
+   * Non-leaf nodes store separators without their padding, so a short separator leaves room for more children.
+   */
+	static StringKey separator( const StringKey& left, const StringKey& right )
+	{
+		char leftChars[ STRINGSIZE ], rightChars[ STRINGSIZE ];
+		left.toChars( leftChars );
+		right.toChars( rightChars );
+		int i = 0;
+		while( i < STRINGSIZE && leftChars[ i ] == rightChars[ i ] )
+			i++;
+		if( i < STRINGSIZE )
+			memset( rightChars + i + 1, 0, STRINGSIZE - i - 1 );
+		return StringKey::fromChars( rightChars );
+	}
+};
+
+/**
+ * Keys of a composite index are read with BTreeIndex::keyFromBytes, which knows the key attributes of the index.
+ */
+template <>
+struct KeyTraits<CompositeKey>{
+	static const Datatype TYPE = COMPOSITE;
+	static const int LEAFSIZE = COMPOSITEARRAYLEAFSIZE;
+	static const int NONLEAFSIZE = COMPOSITEARRAYNONLEAFSIZE;
+	typedef CompositeKey NodeKey;
 
   /**
-   * Stores keys.
+   * Returns the separator between a leaf ending with key left and its right sibling starting with key right.
+   */
+	static CompositeKey separator( const CompositeKey& left, const CompositeKey& right ) { return right; }
+};
+
+/**
+ * Keys of a covering index are read with BTreeIndex::keyFromBytes, like those of a composite index.
+ */
+template <>
+struct KeyTraits<CoveringKey>{
+	static const Datatype TYPE = COVERING;
+	static const int LEAFSIZE = COVERINGARRAYLEAFSIZE;
+	static const int NONLEAFSIZE = COVERINGARRAYNONLEAFSIZE;
+
+  /**
+   * Nodes store the key attributes only, a leaf keeps the included attributes in its payloadArray.
    */
-	int keyArray[ INTARRAYNONLEAFSIZE ];
+	typedef CompositeKey NodeKey;
 
   /**
-   * Stores page numbers of child pages which themselves are other non-leaf/leaf nodes in the tree.
+   * Returns the separator between a leaf ending with key left and its right sibling starting with key right.
    */
-	PageId pageNoArray[ INTARRAYNONLEAFSIZE + 1 ];
+	static CoveringKey separator( const CoveringKey& left, const CoveringKey& right ) { return right; }
 };
 
-
 /**
- * @brief Structure for all leaf nodes when the key is of INTEGER type.
+ * @brief Structure of a page of a sorted run written by the bulk loader when the key-rid pairs of the
+ * relation do not fit in the memory budget for sorting. In a clustered index every pair is followed by its record,
+ * so that the leaves are filled from the runs without reading the heap file again in key order.
 */
-struct LeafNodeInt{
+template <class T>
+struct SortRunPage{
   /**
-   * (Added) Number of filled key slots in a leaf node
-  */
-  int numOccupied;
+   * Number of entries stored in a page of a sorted run, each a key-rid pair and recordSize bytes of record.
+   */
+	//                                                 numOccupied
+	static int capacity( const int recordSize ) { return ( Page::SIZE - sizeof( int ) ) / ( sizeof( RIDKeyPair<T> ) + recordSize ); }
 
   /**
-   * Stores keys.
+   * Number of filled slots in the page.
    */
-	int keyArray[ INTARRAYLEAFSIZE ];
+	int numOccupied;
 
   /**
-   * Stores RecordIds.
+   * Stores the entries in sorted order, sizeof( RIDKeyPair<T> ) + recordSize bytes each. Entries are copied in and out
+   * since a record leaves the pair after it unaligned.
    */
-	RecordId ridArray[ INTARRAYLEAFSIZE ];
+	char entryData[ Page::SIZE - sizeof( int ) ];
 
   /**
-   * Page number of the leaf on the right side.
-	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
+   * Returns the key-rid pair of entry i.
    */
+	RIDKeyPair<T> pairAt( const int i, const int recordSize ) const
+	{
+		RIDKeyPair<T> pair;
+		memcpy( &pair, entryData + i * ( sizeof( RIDKeyPair<T> ) + recordSize ), sizeof( RIDKeyPair<T> ) );
+		return pair;
+	}
+
+  /**
+   * Returns the record of entry i, recordSize bytes.
+   */
+	const char* recordAt( const int i, const int recordSize ) const
+	{
+		return entryData + i * ( sizeof( RIDKeyPair<T> ) + recordSize ) + sizeof( RIDKeyPair<T> );
+	}
+
+  /**
+   * Sets entry i to the pair and its record, which may be NULL if recordSize is 0.
+   */
+	void setEntry( const int i, const int recordSize, const RIDKeyPair<T>& pair, const char* record )
+	{
+		char* entry = entryData + i * ( sizeof( RIDKeyPair<T> ) + recordSize );
+		memcpy( entry, &pair, sizeof( RIDKeyPair<T> ) );
+		if( recordSize > 0 )
+			memcpy( entry + sizeof( RIDKeyPair<T> ), record, recordSize );
+	}
+};
+
+/**
+ * @brief A sorted run of key-rid pairs spilled to the temporary sort file by the bulk loader.
+*/
+struct SortRun{
+  /**
+   * Page numbers of the pages of the run, in order.
+   */
+	std::vector<PageId> pageNos;
+
+  /**
+   * Total number of key-rid pairs in the run.
+   */
+	int numPairs;
+};
+
+/**
+ * @brief State kept while the bulk loader packs the leaf level. The leaf being filled stays pinned until its
+ * right sibling is allocated, so every leaf is written out only once.
+*/
+template <class T>
+struct BulkLoadState{
+  /**
+   * Total number of entries to be placed in leaves.
+   */
+	int numEntries;
+
+  /**
+   * Number of leaves the entries are spread over.
+   */
+	int numLeaves;
+
+  /**
+   * Number of leaves started so far.
+   */
+	int leavesStarted;
+
+  /**
+   * Number of entries the current leaf receives before the next leaf is started.
+   */
+	int leafTarget;
+
+  /**
+   * Page number of the leaf currently being filled.
+   */
+	PageId leafPageNo;
+
+  /**
+   * Leaf currently being filled, pinned in the buffer pool.
+   */
+	Page *leafPage;
+
+  /**
+   * Smallest key and page number of every finished leaf, used to build the non-leaf levels.
+   */
+	std::vector< PageKeyPair<T> > children;
+
+  /**
+   * Number of entries in the subtree of every child in children.
+   */
+	std::vector<int> childCounts;
+};
+
+/**
+ * @brief Maximum number of non-leaf levels in a B+ Tree. Every non-leaf level has fewer nodes than the level below it,
+ * and there are fewer than 2^32 pages in an index file, so no tree has more non-leaf levels than this.
+ */
+const int MAXTREEHEIGHT = 32;
+
+/**
+ * @brief Path from the root to a leaf, recorded by the descent that finds the leaf and walked back up when a split propagates.
+ * It is a fixed-size array kept on the stack, so a descent does no heap allocation.
+*/
+struct TreePath{
+  /**
+   * Page numbers of the non-leaf nodes visited, the root first.
+   */
+	PageId pageNoArray[ MAXTREEHEIGHT ];
+
+  /**
+   * Number of non-leaf nodes on the path. 0 if the root is a leaf.
+   */
+	int depth;
+};
+
+/**
+ * @brief The meta page, which holds metadata for Index file, is always first page of the btree index file and is cast
+ * to the following structure to store or retrieve information from it.
+ * Contains the relation name for which the index is created, the byte offset
+ * of the key value on which the index is made, the type of the key and the page no
+ * of the root page. Root page starts as page 2 but since a split can occur
+ * at the root the root page may get moved up and get a new page no.
+*/
+struct IndexMetaInfo{
+  /**
+   * Name of base relation.
+   */
+	char relationName[20];
+
+  /**
+   * Offset of attribute, over which index is built, inside the record stored in pages.
+   */
+	int attrByteOffset;
+
+  /**
+   * Type of the attribute over which index is built.
+   */
+	Datatype attrType;
+
+  /**
+   * Page number of root page of the B+ Tree inside the file index file.
+   */
+	PageId rootPageNo;
+
+  /**
+   * True while the root page is a leaf, i.e. the tree has a single node.
+   */
+	bool rootIsLeaf;
+
+  /**
+   * Number of non-leaf levels of the tree, 0 while the root page is a leaf.
+   */
+	int treeHeight;
+
+  /**
+   * Size of a record id in the leaves, sizeof( LeafRid ). Files whose leaves hold unpacked 8-byte record ids are refused.
+   */
+	int leafRidSize;
+
+  /**
+   * Number of key attributes, 1 unless attrType is COMPOSITE.
+   */
+	int numKeyAttrs;
+
+  /**
+   * Offset and type of every key attribute, in key order.
+   */
+	KeyAttr keyAttrs[ MAXKEYATTRS ];
+
+  /**
+   * Number of included attributes, 0 unless attrType is COVERING.
+   */
+	int numIncludeAttrs;
+
+  /**
+   * Offset and type of every included attribute, in the order they are kept in the leaf entries.
+   */
+	KeyAttr includeAttrs[ MAXINCLUDEATTRS ];
+
+  /**
+   * Size of the records in the leaves of a clustered index, 0 if the leaves hold record ids.
+   */
+	int recordSize;
+};
+
+/*
+Each node is a page, so once we read the page in we just cast the pointer to the page to this struct and use it to access the parts
+These structures basically are the format in which the information is stored in the pages for the index file depending on what kind of
+node they are. The level memeber of each non leaf structure seen below is set to 1 if the nodes
+at this level are just above the leaf nodes. Otherwise set to 0.
+The structures are templated over the key type, so every key type keeps fixed width keys and a fanout fixed at compile time,
+except the non-leaf nodes of STRING keys, which store their separators without the zero padding, see NonLeafNode<StringKey>.
+Code that works on any non-leaf node goes through nodeKey, nodeChild, nodeCount and the other node functions below.
+Every node, leaf or not, links to its right sibling on the same level and stores a high key, the separator its parent keeps
+between it and that sibling, so the tree is a Lehman-Yao B-link tree: a thread that reaches a node after a concurrent split moved
+the keys it looks for away follows the right link to the new node instead of descending again. A node covers keys up to and
+including its high key. The rightmost node of a level has no right sibling and no meaningful high key.
+*/
+
+/**
+ * @brief Structure for all non-leaf nodes, for a key of type T.
+*/
+template <class T>
+struct NonLeafNode{
+  /**
+   * Level of the node in the tree.
+   */
+	int level;
+
+  /**
+  * (Added) Number of filled slots in an internal node
+  */
+  int numOccupied;
+
+  /**
+   * Page number of the node on the right side on the same level, Page::INVALID_NUMBER for the rightmost node.
+   */
+	PageId rightSibPageNo;
+
+  /**
+   * Largest key the node covers, larger keys are found through rightSibPageNo. Only set if there is a right sibling.
+   */
+	typename KeyTraits<T>::NodeKey highKey;
+
+  /**
+   * Stores keys.
+   */
+	typename KeyTraits<T>::NodeKey keyArray[ KeyTraits<T>::NONLEAFSIZE ];
+
+  /**
+   * Stores page numbers of child pages which themselves are other non-leaf/leaf nodes in the tree.
+   */
+	PageId pageNoArray[ KeyTraits<T>::NONLEAFSIZE + 1 ];
+
+  /**
+   * Number of entries in the subtree of each child, countArray[i] for the child pageNoArray[i].
+   * Short of the pendingCount of the leaves below the child, exact once BTreeIndex::flushCounts has run and no insert is in progress below the node.
+   */
+	int countArray[ KeyTraits<T>::NONLEAFSIZE + 1 ];
+};
+
+/**
+ * @brief Structure for the non-leaf nodes of STRING keys, a slotted page. Separators chosen by KeyTraits<StringKey>::separator
+ * are mostly a few characters long, so a node keeps them without their zero padding, and holds more children the shorter they are.
+ * The slots of the children grow from the front of data, the separators are stacked from the end of data towards them.
+ * Slot i holds child i, the count of its subtree and the offset of key i - 1, the separator on its left; slot 0 has no key.
+ * A separator is stored as its length followed by its characters.
+*/
+template <>
+struct NonLeafNode<StringKey>{
+	int level;
+	int numOccupied;
 	PageId rightSibPageNo;
+	StringKey highKey;
+
+  /**
+   * Offset in data of the last separator stored, everything from there to the end of data is separators.
+   */
+	std::uint16_t keyStart;
+
+  /**
+   * Slots of the numOccupied + 1 children, free space, then the separators.
+   */
+	unsigned char data[ STRINGNODEDATASIZE ];
 };
 
 
 /**
- * @brief BTreeIndex class. It implements a B+ Tree index on a single attribute of a
- * relation. This index supports only one scan at a time.
+ * @brief Structure for all leaf nodes, for a key of type T.
 */
-class BTreeIndex {
+template <class T>
+struct LeafNode{
+  /**
+   * (Added) Number of filled key slots in a leaf node
+  */
+  int numOccupied;
 
- private:
+  /**
+   * Page number of the leaf on the right side.
+	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
+   */
+	PageId rightSibPageNo;
+
+  /**
+   * Page number of the leaf on the left side, Page::INVALID_NUMBER for the leftmost leaf. Used by backward scans.
+   * It may briefly point further left than the leaf whose right link is this leaf, while a split of that leaf is linked in.
+   */
+	PageId leftSibPageNo;
+
+  /**
+   * Number of entries inserted into the leaf that its parent does not count yet. An insert that does not split the leaf
+   * counts its entries here, under the latch of the leaf, and BTreeIndex::flushCounts adds them to the ancestors later.
+   */
+	int pendingCount;
+
+  /**
+   * Largest key the leaf covers, larger keys are found through rightSibPageNo. Only set if there is a right sibling.
+   */
+	typename KeyTraits<T>::NodeKey highKey;
+
+  /**
+   * Stores keys.
+   */
+	typename KeyTraits<T>::NodeKey keyArray[ KeyTraits<T>::LEAFSIZE ];
+
+  /**
+   * Stores RecordIds, packed into 6 bytes.
+   */
+	LeafRid ridArray[ KeyTraits<T>::LEAFSIZE ];
+};
+
+/**
+ * @brief Structure for the leaf nodes of a covering index. Laid out like any leaf, with the composite keys of the entries
+ * in keyArray, followed by the included attributes of every entry in payloadArray, parallel to ridArray.
+*/
+template <>
+struct LeafNode<CoveringKey>{
+	int numOccupied;
+	PageId rightSibPageNo;
+	PageId leftSibPageNo;
+	int pendingCount;
+	CompositeKey highKey;
+	CompositeKey keyArray[ COVERINGARRAYLEAFSIZE ];
+	LeafRid ridArray[ COVERINGARRAYLEAFSIZE ];
+
+  /**
+   * Stores the included attributes of the entries, zero padded.
+   */
+	unsigned char payloadArray[ COVERINGARRAYLEAFSIZE ][ PAYLOADSIZE ];
+};
+
+/**
+ * @brief Returns the key of entry i of a leaf, with the included attributes of the entry in a covering index.
+ */
+template <class T>
+inline T leafKey( const LeafNode<T>* node, int i )
+{
+	return node->keyArray[ i ];
+}
+
+inline CoveringKey leafKey( const LeafNode<CoveringKey>* node, int i )
+{
+	CoveringKey key;
+	key.key = node->keyArray[ i ];
+	memcpy( key.payload, node->payloadArray[ i ], PAYLOADSIZE );
+	return key;
+}
+
+/**
+ * @brief Sets the key of entry i of a leaf, and in a covering index the included attributes of the entry.
+ */
+template <class T>
+inline void setLeafKey( LeafNode<T>* node, int i, const T& key )
+{
+	node->keyArray[ i ] = key;
+}
+
+inline void setLeafKey( LeafNode<CoveringKey>* node, int i, const CoveringKey& key )
+{
+	node->keyArray[ i ] = key.key;
+	memcpy( node->payloadArray[ i ], key.payload, PAYLOADSIZE );
+}
+
+/**
+ * @brief Returns key i of a non-leaf node, the separator between child i and child i + 1.
+ */
+template <class T>
+inline typename KeyTraits<T>::NodeKey nodeKey( const NonLeafNode<T>* node, int i )
+{
+	return node->keyArray[ i ];
+}
+
+/**
+ * @brief Returns the page number of child i of a non-leaf node.
+ */
+template <class T>
+inline PageId nodeChild( const NonLeafNode<T>* node, int i )
+{
+	return node->pageNoArray[ i ];
+}
+
+/**
+ * @brief Returns the number of entries in the subtree of child i of a non-leaf node.
+ */
+template <class T>
+inline int nodeCount( const NonLeafNode<T>* node, int i )
+{
+	return node->countArray[ i ];
+}
+
+/**
+ * @brief Sets the number of entries in the subtree of child i of a non-leaf node.
+ */
+template <class T>
+inline void setNodeCount( NonLeafNode<T>* node, int i, int count )
+{
+	node->countArray[ i ] = count;
+}
+
+/**
+ * @brief Returns the number of keys among the first n keys of a non-leaf node that are less than key.
+ */
+template <class T, class K>
+inline int nodeLowerBound( const NonLeafNode<T>* node, int n, const K& key )
+{
+	return nodeLowerBound( node->keyArray, n, key );
+}
+
+/**
+ * @brief Returns the number of keys among the first n keys of a non-leaf node that are less than or equal to key.
+ */
+template <class T, class K>
+inline int nodeUpperBound( const NonLeafNode<T>* node, int n, const K& key )
+{
+	return nodeUpperBound( node->keyArray, n, key );
+}
+
+/**
+ * @brief Returns the array a search of a non-leaf node reads, for prefetching.
+ */
+template <class T>
+inline const void* nodeSearchArray( const NonLeafNode<T>* node )
+{
+	return node->keyArray;
+}
+
+/**
+ * @brief Returns the size of an element of nodeSearchArray.
+ */
+template <class T>
+inline int nodeSearchStride( const NonLeafNode<T>* node )
+{
+	return sizeof( typename KeyTraits<T>::NodeKey );
+}
+
+/**
+ * @brief Returns true if one more key, with the child on its right, fits in a non-leaf node.
+ */
+template <class T>
+inline bool nodeHasRoom( const NonLeafNode<T>* node, const typename KeyTraits<T>::NodeKey& key )
+{
+	return node->numOccupied < KeyTraits<T>::NONLEAFSIZE;
+}
+
+/**
+ * @brief Returns the fraction of a non-leaf node in use.
+ */
+template <class T>
+inline float nodeFill( const NonLeafNode<T>* node )
+{
+	return (float) ( node->numOccupied + 1 ) / ( KeyTraits<T>::NONLEAFSIZE + 1 );
+}
+
+/**
+ * @brief Empties a non-leaf node down to its first child.
+ */
+template <class T>
+inline void clearNode( NonLeafNode<T>* node, PageId pageNo, int count )
+{
+	node->numOccupied = 0;
+	node->pageNoArray[ 0 ] = pageNo;
+	node->countArray[ 0 ] = count;
+}
+
+/**
+ * @brief Inserts key i into a non-leaf node, with the child pageNo on its right, and moves the keys from i and the children
+ * after them up by one. The caller checks nodeHasRoom first.
+ */
+template <class T>
+inline void insertNodeKey( NonLeafNode<T>* node, int i, const typename KeyTraits<T>::NodeKey& key, PageId pageNo, int count )
+{
+	for( int j = node->numOccupied; j > i; j-- )
+	{
+		node->keyArray[ j ] = node->keyArray[ j - 1 ];
+		node->pageNoArray[ j + 1 ] = node->pageNoArray[ j ];
+		node->countArray[ j + 1 ] = node->countArray[ j ];
+	}
+	node->keyArray[ i ] = key;
+	node->pageNoArray[ i + 1 ] = pageNo;
+	node->countArray[ i + 1 ] = count;
+	node->numOccupied++;
+}
+
+/*
+The node functions of the slotted STRING non-leaf nodes. Nodes are read without latches and validated afterwards, so a read
+may see a slot or length that a writer is changing; such reads are kept inside data and thrown away by the validation.
+*/
+
+inline const NodeSlot* nodeSlots( const NonLeafNode<StringKey>* node ) { return (const NodeSlot*) node->data; }
+inline NodeSlot* nodeSlots( NonLeafNode<StringKey>* node ) { return (NodeSlot*) node->data; }
+
+/**
+ * @brief Returns the number of characters of a STRING separator without its zero padding.
+ */
+inline int separatorLength( const StringKey& key )
+{
+	char chars[ STRINGSIZE ];
+	key.toChars( chars );
+	int length = STRINGSIZE;
+	while( length > 0 && chars[ length - 1 ] == 0 )
+		length--;
+	return length;
+}
+
+inline StringKey nodeKey( const NonLeafNode<StringKey>* node, int i )
+{
+	const int offset = std::min( (int) nodeSlots( node )[ i + 1 ].keyOffset, STRINGNODEDATASIZE - 1 );
+	const int length = std::min( (int) node->data[ offset ], std::min( STRINGSIZE, STRINGNODEDATASIZE - 1 - offset ) );
+	char chars[ STRINGSIZE ] = {};
+	memcpy( chars, node->data + offset + 1, length );
+	return StringKey::fromChars( chars );
+}
+
+inline PageId nodeChild( const NonLeafNode<StringKey>* node, int i )
+{
+	return nodeSlots( node )[ i ].pageNo;
+}
+
+inline int nodeCount( const NonLeafNode<StringKey>* node, int i )
+{
+	return nodeSlots( node )[ i ].count;
+}
+
+inline void setNodeCount( NonLeafNode<StringKey>* node, int i, int count )
+{
+	nodeSlots( node )[ i ].count = count;
+}
+
+inline int nodeLowerBound( const NonLeafNode<StringKey>* node, int n, const StringKey& key )
+{
+	int lo = 0;
+	while( n > 0 )
+	{
+		const int half = n / 2;
+		if( nodeKey( node, lo + half ) < key )
+		{
+			lo += half + 1;
+			n -= half + 1;
+		}
+		else
+			n = half;
+	}
+	return lo;
+}
+
+inline int nodeUpperBound( const NonLeafNode<StringKey>* node, int n, const StringKey& key )
+{
+	int lo = 0;
+	while( n > 0 )
+	{
+		const int half = n / 2;
+		if( !( key < nodeKey( node, lo + half ) ) )
+		{
+			lo += half + 1;
+			n -= half + 1;
+		}
+		else
+			n = half;
+	}
+	return lo;
+}
+
+inline const void* nodeSearchArray( const NonLeafNode<StringKey>* node )
+{
+	return node->data;
+}
+
+inline int nodeSearchStride( const NonLeafNode<StringKey>* node )
+{
+	return sizeof( NodeSlot );
+}
+
+inline bool nodeHasRoom( const NonLeafNode<StringKey>* node, const StringKey& key )
+{
+	const int slotsEnd = ( node->numOccupied + 2 ) * (int) sizeof( NodeSlot );
+	return slotsEnd + 1 + separatorLength( key ) <= node->keyStart;
+}
+
+inline float nodeFill( const NonLeafNode<StringKey>* node )
+{
+	const int slotsEnd = ( node->numOccupied + 1 ) * (int) sizeof( NodeSlot );
+	return (float) ( slotsEnd + STRINGNODEDATASIZE - node->keyStart ) / STRINGNODEDATASIZE;
+}
+
+inline void clearNode( NonLeafNode<StringKey>* node, PageId pageNo, int count )
+{
+	node->numOccupied = 0;
+	node->keyStart = STRINGNODEDATASIZE;
+	nodeSlots( node )[ 0 ].pageNo = pageNo;
+	nodeSlots( node )[ 0 ].count = count;
+	nodeSlots( node )[ 0 ].keyOffset = 0;
+}
+
+inline void insertNodeKey( NonLeafNode<StringKey>* node, int i, const StringKey& key, PageId pageNo, int count )
+{
+	char chars[ STRINGSIZE ];
+	key.toChars( chars );
+	const int length = separatorLength( key );
+	node->keyStart -= 1 + length;
+	node->data[ node->keyStart ] = (unsigned char) length;
+	memcpy( node->data + node->keyStart + 1, chars, length );
+
+	NodeSlot* slots = nodeSlots( node );
+	memmove( slots + i + 2, slots + i + 1, ( node->numOccupied - i ) * sizeof( NodeSlot ) );
+	slots[ i + 1 ].pageNo = pageNo;
+	slots[ i + 1 ].count = count;
+	slots[ i + 1 ].keyOffset = node->keyStart;
+	node->numOccupied++;
+}
+
+/**
+ * @brief Structure for all non-leaf nodes when the key is of INTEGER type.
+*/
+typedef NonLeafNode<int> NonLeafNodeInt;
+
+/**
+ * @brief Structure for all non-leaf nodes when the key is of DOUBLE type.
+*/
+typedef NonLeafNode<DoubleKey> NonLeafNodeDouble;
+
+/**
+ * @brief Structure for all non-leaf nodes when the key is of STRING type.
+*/
+typedef NonLeafNode<StringKey> NonLeafNodeString;
+
+/**
+ * @brief Structure for all non-leaf nodes when the key is COMPOSITE.
+*/
+typedef NonLeafNode<CompositeKey> NonLeafNodeComposite;
+
+/**
+ * @brief Structure for all non-leaf nodes when the key is COVERING.
+*/
+typedef NonLeafNode<CoveringKey> NonLeafNodeCovering;
+
+/**
+ * @brief Structure for all leaf nodes when the key is of INTEGER type.
+*/
+typedef LeafNode<int> LeafNodeInt;
+
+/**
+ * @brief Structure for all leaf nodes when the key is of DOUBLE type.
+*/
+typedef LeafNode<DoubleKey> LeafNodeDouble;
+
+/**
+ * @brief Structure for all leaf nodes when the key is of STRING type.
+*/
+typedef LeafNode<StringKey> LeafNodeString;
+
+/**
+ * @brief Structure for all leaf nodes when the key is COMPOSITE.
+*/
+typedef LeafNode<CompositeKey> LeafNodeComposite;
+
+/**
+ * @brief Structure for all leaf nodes when the key is COVERING.
+*/
+typedef LeafNode<CoveringKey> LeafNodeCovering;
+
+static_assert( sizeof( NonLeafNodeInt ) <= Page::SIZE && sizeof( LeafNodeInt ) <= Page::SIZE,
+               "INTEGER B+ Tree nodes must fit in a page." );
+static_assert( sizeof( NonLeafNodeDouble ) <= Page::SIZE && sizeof( LeafNodeDouble ) <= Page::SIZE,
+               "DOUBLE B+ Tree nodes must fit in a page." );
+static_assert( sizeof( NonLeafNodeString ) <= Page::SIZE && sizeof( LeafNodeString ) <= Page::SIZE,
+               "STRING B+ Tree nodes must fit in a page." );
+static_assert( sizeof( NonLeafNodeComposite ) <= Page::SIZE && sizeof( LeafNodeComposite ) <= Page::SIZE,
+               "COMPOSITE B+ Tree nodes must fit in a page." );
+static_assert( sizeof( NonLeafNodeCovering ) <= Page::SIZE && sizeof( LeafNodeCovering ) <= Page::SIZE,
+               "COVERING B+ Tree nodes must fit in a page." );
+
+/*
+A leaf of a clustered index is a LeafNode whose ridArray is replaced by the records. The header and keyArray are where they are
+in any leaf, so descents, scan positioning and sibling links read it like any other leaf. Its records start right after the
+last key slot it has, and it has fewer key slots than a leaf of record ids: as many as fit in the page with a record each.
+*/
+
+/**
+ * @brief Largest record a clustered index keeps in its leaves, so a leaf still holds a few of them.
+ */
+const int MAXCLUSTEREDRECORDSIZE = 1024;
+
+/**
+ * @brief Number of entries a leaf of a clustered index holds, for a key of type T and records of recordSize bytes.
+ */
+template <class T>
+inline int clusteredLeafSize( const int recordSize )
+{
+	const int size = (int) ( ( Page::SIZE - offsetof( LeafNode<T>, keyArray ) ) / ( sizeof( typename KeyTraits<T>::NodeKey ) + recordSize ) );
+	return size < KeyTraits<T>::LEAFSIZE ? size : KeyTraits<T>::LEAFSIZE;
+}
+
+
+/**
+ * @brief Largest number of right siblings a scan reads ahead of the leaf it is on. The window starts at one leaf
+ * and doubles with every leaf the scan moves to, so short scans do not read leaves they will not use.
+ */
+const int MAXREADAHEAD = 32;
+
+/**
+ * @brief Number of descents lookupInterleaved keeps in flight. Each one waits for its next node to reach the CPU cache
+ * while the others step, so enough of them are needed to cover a cache miss.
+ */
+const int INTERLEAVEDPROBES = 16;
+
+/**
+ * @brief Largest number of leaves insertBatch splits one leaf into. Bounds the entries merged into a leaf at once,
+ * the rest of a longer run goes into the next leaf after the split.
+ */
+const int MAXBATCHSPLIT = 16;
+
+/**
+ * @brief Largest number of non-leaf nodes a BTreeIndex keeps in its upper level cache.
+ */
+const int MAXCACHEDNODES = 64;
+
+/**
+ * @brief Cache of the upper non-leaf nodes of a BTreeIndex. The frames of the cached nodes stay pinned in the buffer
+ * pool for the life of the index, so a descent reads them through a direct pointer, without the hash lookup and
+ * pin of readPage. Writers still update them in their frames, and readers validate their version like any node,
+ * so splits need no invalidation. Nodes are only ever added, lookups take no lock.
+*/
+class NodeCache {
+
+ private:
+
+  /**
+   * Number of slots of the open addressing table, a power of two twice the size of the cache.
+   */
+	static const int NUMSLOTS = 2 * MAXCACHEDNODES;
+
+  /**
+   * Page numbers of the cached nodes, INVALID_NUMBER for an empty slot. Published after the page pointer of the slot.
+   */
+	std::atomic<PageId> pageNoArray[ NUMSLOTS ];
+
+  /**
+   * Frames of the cached nodes.
+   */
+	Page* pageArray[ NUMSLOTS ];
+
+  /**
+   * Number of cached nodes.
+   */
+	std::atomic<int> numCached;
+
+  /**
+   * Serializes inserts.
+   */
+	std::mutex insertMutex;
+
+ public:
+
+  /**
+   * Most nodes the cache admits, at most MAXCACHEDNODES.
+   */
+	int capacity;
+
+  /**
+   * Constructor. Creates an empty cache that admits no nodes until capacity is set.
+   */
+	NodeCache();
+
+  /**
+   * Returns the frame of a cached node, NULL if the node is not cached.
+   */
+	Page* lookup(const PageId pageNo) const;
+
+  /**
+   * Adds a node pinned by the caller, its pin then belongs to the cache. Fails if the cache is full or the node is cached already.
+   * @param pageNo  PageId of the node
+   * @param page  Frame of the node
+   * @param limit  Most nodes the cache may hold after the insert, at most capacity
+   * @return  True if the node was added
+   */
+	bool insert(const PageId pageNo, Page* page, const int limit);
+
+  /**
+   * Page number of the node in a slot, INVALID_NUMBER if the slot is empty. Used to release the pins of the cache.
+   */
+	PageId slotPageNo(const int slot) const { return pageNoArray[slot].load(std::memory_order_acquire); }
+
+  /**
+   * Number of slots, see slotPageNo.
+   */
+	int numSlots() const { return NUMSLOTS; }
+
+  /**
+   * Number of cached nodes.
+   */
+	int size() const { return numCached.load(std::memory_order_relaxed); }
+};
+
+class BTreeIndex;
+
+/**
+ * @brief Cursor over a range of a BTreeIndex. Every cursor holds its own scan bounds and position, so many scans
+ * can be open over one index at the same time, e.g. for nested-loop joins and IN-lists, and interleave without
+ * descending the tree again. No page stays pinned between calls. The index must outlive its cursors, and inserting
+ * into the index while a cursor is open may make the cursor miss or repeat entries.
+*/
+class ScanCursor {
+
+	friend class BTreeIndex;
+
+ private:
+
+  /**
+   * Index the cursor scans.
+   */
+	BTreeIndex	*index;
+
+  /**
+   * True if an index scan has been started.
+   */
+	bool		scanExecuting;
+
+  /**
+   * Index of next entry to be scanned in current leaf being scanned.
+   */
+	int			nextEntry;
+
+  /**
+   * Page number of current page being scanned.
+   */
+	PageId	currentPageNum;
+
+  /**
+   * Number of leaves the scan has moved to after the first one, used to grow the read-ahead window.
+   */
+	int			leavesScanned;
+
+  /**
+   * Page number of the parent of the current leaf, whose children are the right siblings read ahead. INVALID_NUMBER if the root is a leaf.
+   */
+	PageId	readAheadParentNum;
+
+  /**
+   * Position of the current leaf among the children of readAheadParentNum, -1 if not known yet.
+   */
+	int			readAheadSlot;
+
+  /**
+   * Low INTEGER value for scan.
+   */
+	int			lowValInt;
+
+  /**
+   * Low DOUBLE value for scan.
+   */
+	DoubleKey	lowValDouble;
+
+  /**
+   * Low STRING value for scan.
+   */
+	StringKey	lowValString;
+
+  /**
+   * Low COMPOSITE value for scan.
+   */
+	CompositeKey	lowValComposite;
+
+  /**
+   * Low COVERING value for scan.
+   */
+	CoveringKey	lowValCovering;
+
+  /**
+   * High INTEGER value for scan.
+   */
+	int			highValInt;
+
+  /**
+   * High DOUBLE value for scan.
+   */
+	DoubleKey	highValDouble;
+
+  /**
+   * High STRING value for scan.
+   */
+	StringKey highValString;
+
+  /**
+   * High COMPOSITE value for scan.
+   */
+	CompositeKey	highValComposite;
+
+  /**
+   * High COVERING value for scan.
+   */
+	CoveringKey	highValCovering;
+
+  /**
+   * Key of the next entry to be scanned, as INTEGER. Finds the entry again if concurrent inserts moved it.
+   */
+	int			nextKeyInt;
+
+  /**
+   * Key of the next entry to be scanned, as DOUBLE.
+   */
+	DoubleKey	nextKeyDouble;
+
+  /**
+   * Key of the next entry to be scanned, as STRING.
+   */
+	StringKey	nextKeyString;
+
+  /**
+   * Key of the next entry to be scanned, as COMPOSITE.
+   */
+	CompositeKey	nextKeyComposite;
+
+  /**
+   * Key of the next entry to be scanned, as COVERING.
+   */
+	CoveringKey	nextKeyCovering;
+
+  /**
+   * Record id of the next entry to be scanned, or the link of its posting list. Tells the entry apart from the others
+   * of its key.
+   */
+	RecordId	nextRid;
+
+  /**
+   * Record of the next entry to be scanned, which tells it apart from the others of its key in a clustered index.
+   */
+	std::vector<char>	nextRecord;
+
+  /**
+   * Number of entries equal to the next one that the scan already returned from its leaf. A record id can be in the
+   * index more than once under one key.
+   */
+	int			nextCopies;
+
+  /**
+   * Low Operator. Can only be GT(>) or GTE(>=).
+   */
+	Operator	lowOp;
+
+  /**
+   * High Operator. Can only be LT(<) or LTE(<=).
+   */
+	Operator	highOp;
+
+  /**
+   * Direction of the scan. A BACKWARD scan starts at the high value and its next entry is the one on the left.
+   */
+	ScanDirection	direction;
+
+  /**
+   * Page of the posting list being copied from, when the next entry links to one and the scan stopped inside it.
+   * Page::INVALID_NUMBER otherwise.
+   */
+	PageId	postingPageNum;
+
+  /**
+   * Width of the first key attribute in a skip scan, whose groups of entries sharing it are scanned one after the other.
+   * 0 in any other scan.
+   */
+	int			skipWidth;
+
+  /**
+   * Low value of a group of a skip scan, with the first skipWidth bytes left zero for the value of the group.
+   */
+	CompositeKey	skipLow;
+
+  /**
+   * High value of a group of a skip scan, with the first skipWidth bytes left zero for the value of the group.
+   */
+	CompositeKey	skipHigh;
+
+  /**
+   * Last record id copied from the posting list on postingPageNum. The scan goes on right after it, wherever inserts
+   * since have moved it in the list.
+   */
+	RecordId	postingLastRid;
+
+  /**
+   * Number of copies of postingLastRid copied so far, the same record id can be in a posting list more than once.
+   */
+	int			postingLastRidCopies;
+
+  /**
+    * Helper method.
+    * Returns the low value of the scan for key type T, i.e. one of lowValInt, lowValDouble, lowValString, lowValComposite or lowValCovering.
+    */
+  template <class T>
+  T& scanLowVal();
+
+  /**
+    * Helper method.
+    * Returns the high value of the scan for key type T, i.e. one of highValInt, highValDouble, highValString, highValComposite or highValCovering.
+    */
+  template <class T>
+  T& scanHighVal();
+
+  /**
+    * Helper method.
+    * Returns the key of the next entry to be scanned for key type T, i.e. one of nextKeyInt, nextKeyDouble, nextKeyString, nextKeyComposite or nextKeyCovering.
+    */
+  template <class T>
+  T& scanNextKey();
+
+  /**
+    * Helper method.
+    * Ends the scan of the cursor, if any, checks the operators of a new one and sets them up.
+    * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+    */
+  void setScanParams(const Operator lowOpParm, const Operator highOpParm, const ScanDirection directionParm);
+
+ public:
+
+  /**
+   * ScanCursor Constructor. Creates a cursor over the index with no scan started.
+   * @param index	Index to scan
+   */
+	ScanCursor(BTreeIndex *index);
+
+  /**
+   * ScanCursor Destructor. Ends the scan of the cursor, if any.
+   */
+	~ScanCursor();
+
+  /**
+	 * Begin a filtered scan of the index with this cursor. If the cursor already has a scan executing, that is ended here.
+	 * Scans of other cursors are not affected. The parameters are the same as BTreeIndex::startScan.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE)
+   * @param direction	FORWARD to return the entries in ascending key order, BACKWARD for descending
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies the scan criteria.
+	**/
+	void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp, const ScanDirection direction = FORWARD);
+
+  /**
+	 * Begin a scan of a composite index with this cursor, bounded on the first attributes of the key only.
+	 * The parameters are the same as BTreeIndex::startPrefixScan.
+   * @throws  BadScanParamException If the index is not composite or covering, or numAttrs is not between 1 and the number of key attributes
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies the scan criteria.
+	**/
+	void startPrefixScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp, const int numAttrs,
+	                     const ScanDirection direction = FORWARD);
+
+  /**
+	 * Begin a scan of a composite index with this cursor, bounded on the second attribute of the key only.
+	 * The parameters are the same as BTreeIndex::startSkipScan.
+   * @throws  BadScanParamException If the index is not composite or covering, or its key has a single attribute
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies the scan criteria.
+	**/
+	void startSkipScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp,
+	                   const ScanDirection direction = FORWARD);
+
+  /**
+	 * Fetch the record id of the next index entry that matches the scan of this cursor.
+   * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadIndexInfoException If the index is clustered, its leaves hold no record ids.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	void scanNext(RecordId& outRid);
+
+  /**
+	 * Fetch the record id and the included attributes of the next index entry that matches the scan of this cursor, see BTreeIndex::scanNext.
+   * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
+   * @param payload	Included attributes of the entry, returned in at least BTreeIndex::getPayloadSize bytes
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadScanParamException If the index is not a covering index.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	void scanNext(RecordId& outRid, void* payload);
+
+  /**
+	 * Fetch the record ids of up to max next index entries that match the scan of this cursor, see BTreeIndex::scanNextBatch.
+   * @param out	Array of at least max RecordIds, the record ids found are returned in it in the order of the scan
+   * @param max	Maximum number of record ids to return
+   * @return	Number of record ids returned. 0 once no more records, satisfying the scan criteria, are left to be scanned.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadIndexInfoException If the index is clustered, its leaves hold no record ids.
+	**/
+	size_t scanNextBatch(RecordId* out, size_t max);
+
+  /**
+	 * Fetch the record ids and the included attributes of up to max next index entries that match the scan of this cursor,
+	 * see BTreeIndex::scanNextBatch.
+   * @param out	Array of at least max RecordIds, the record ids found are returned in it in the order of the scan
+   * @param payloads	Array of max times BTreeIndex::getPayloadSize bytes, the included attributes of out[i] are returned at payloads + i * getPayloadSize()
+   * @param max	Maximum number of record ids to return
+   * @return	Number of record ids returned. 0 once no more records, satisfying the scan criteria, are left to be scanned.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadScanParamException If the index is not a covering index.
+	**/
+	size_t scanNextBatch(RecordId* out, void* payloads, size_t max);
+
+  /**
+	 * Fetch the next record that matches the scan of this cursor over a clustered index, see BTreeIndex::scanNextRecord.
+   * @param record	The record, returned in BTreeIndex::getRecordSize bytes
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadIndexInfoException If the index is not clustered.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	void scanNextRecord(void* record);
+
+  /**
+	 * Fetch up to max next records that match the scan of this cursor over a clustered index, see BTreeIndex::scanNextRecordBatch.
+   * @param records	Array of max times BTreeIndex::getRecordSize bytes, the records found are returned in it in the order of the scan
+   * @param max	Maximum number of records to return
+   * @return	Number of records returned. 0 once no more records, satisfying the scan criteria, are left to be scanned.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadIndexInfoException If the index is not clustered.
+	**/
+	size_t scanNextRecordBatch(void* records, size_t max);
+
+  /**
+	 * Terminate the scan of this cursor.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	**/
+	void endScan();
+
+  /**
+   * Returns true if a scan has been started with this cursor and not ended.
+   */
+	bool isScanExecuting() const;
+};
+
+
+/**
+ * @brief BTreeIndex class. It implements a B+ Tree index on a single attribute of a
+ * relation, or on a composite key of several attributes. The index itself supports one scan at a time through startScan, more scans can be open at once with ScanCursor.
+ * insertEntry can be called from several threads at once; inserters latch at most two pages at a time and recover from
+ * concurrent splits through the right links of the B-link tree. Descents take no latches on non-leaf nodes,
+ * they validate each read against the version of the page instead.
+ * The tree code is templated over the key type (int, DoubleKey, StringKey or CompositeKey); the public methods take
+ * untyped keys and dispatch once on attributeType to the instantiation for the indexed attribute.
+ * A clustered index keeps the tuples themselves in its leaves instead of record ids, see the constructor that takes a StorageMode.
+*/
+class BTreeIndex {
+
+	friend class ScanCursor;
+
+ private:
+
+  /**
+   * File object for the index file.
+   */
+	File		*file;
+
+  /**
+   * Buffer Manager Instance.
+   */
+	BufMgr	*bufMgr;
+
+  /**
+   * Page number of meta page.
+   */
+	PageId	headerPageNum;
+
+  /**
+   * page number of root page of B+ tree inside index file.
+   */
+	PageId	rootPageNum;
+
+  /**
+   * Datatype of attribute over which index is built.
+   */
+	Datatype	attributeType;
+
+  /**
+   * Offset of attribute, over which index is built, inside records. The offset of the first key attribute of a composite index.
+   */
+	int 		attrByteOffset;
+
+  /**
+   * Number of key attributes, 1 unless attributeType is COMPOSITE.
+   */
+	int			numKeyAttrs;
+
+  /**
+   * Offset and type of every key attribute, in key order.
+   */
+	KeyAttr	keyAttrs[ MAXKEYATTRS ];
+
+  /**
+   * Number of included attributes, 0 unless attributeType is COVERING.
+   */
+	int			numIncludeAttrs;
+
+  /**
+   * Offset and type of every included attribute, in the order they are kept in the leaf entries.
+   */
+	KeyAttr	includeAttrs[ MAXINCLUDEATTRS ];
+
+  /**
+   * Number of bytes of the included attributes of an entry, 0 unless attributeType is COVERING.
+   */
+	int			payloadSize;
+
+  /**
+   * Size of the records a clustered index keeps in its leaves, 0 for an index whose leaves hold record ids.
+   */
+	int			recordSize;
+
+  /**
+   * Number of keys in leaf node, depending upon the type of key, and upon the record size for a clustered index.
+   */
+	int			leafOccupancy;
+
+  /**
+   * Number of keys in non-leaf node, depending upon the type of key.
+   */
+	int			nodeOccupancy;
+
+  /**
+   * Fraction of each node filled by the bulk loader, and kept in the left node by splits that the split policy packs.
+   */
+	float		fillFactor;
+
+  /**
+   * How nodes are split when an insert overflows them.
+   */
+	SplitPolicy	splitPolicy;
+
+  /**
+   * Upper non-leaf nodes pinned in the buffer pool, read by descents without going through the buffer manager.
+   */
+	NodeCache	nodeCache;
+
+	// MEMBERS SPECIFIC TO SCANNING
+
+  /**
+   * Cursor of the scan started with startScan. Other scans over the index use their own ScanCursor.
+   */
+	ScanCursor	indexScan;
+
+  // ADDED HELPERS BELOW
+  /**
+    * used to check whether there is only one node in tree, i.e., the root
+    */
+  bool onlyOneRoot;
+
+  /**
+    * Number of non-leaf levels of the tree, 0 while the root is a leaf. Lets a split find the parent of a non-leaf node
+    * by descending from the root without touching the levels below it.
+    */
+  int treeHeight;
+
+  /**
+    * Guards rootPageNum, onlyOneRoot and treeHeight against inserters that grow the tree concurrently.
+    */
+  std::mutex rootMutex;
+
+  /**
+    * Leaves whose pendingCount may not be 0, added by the insert that makes it nonzero. A leaf may be listed more than once.
+    */
+  std::vector<PageId> pendingLeaves;
+
+  /**
+    * Guards pendingLeaves.
+    */
+  std::mutex pendingMutex;
+
+  /**
+    * Helper method.
+    * Opens the index file, or creates it and builds the tree if it does not exist. Called by the constructors once
+    * the key attributes and the name of the index file are known.
+    * @param relationName  Name of the base relation
+    * @param indexName  Name of the index file
+    * @param bulkLoadMode  True to build a new index with the bulk loader
+    * @param fillFactor  Fraction of each node filled by the bulk loader
+    * @throws  BadIndexInfoException  If the index file exists but was built over other key attributes
+    */
+  void openIndex(const std::string & relationName, const std::string & indexName, const bool bulkLoadMode, const float fillFactor);
+
+  /**
+    * Helper method.
+    * Reads a typed key from a key parameter of a public method. For a composite index the parameter is a record
+    * holding the key attributes at their offsets.
+    * @param key  Pointer to integer/double/char string, or to a record for a composite index
+    */
+  template <class T>
+  T keyFromBytes(const void* key) const;
+
+  /**
+    * Helper method.
+    * Reads the typed key of a record of the base relation.
+    * @param record  The record
+    */
+  template <class T>
+  T keyFromRecord(const char* record) const;
+
+  /**
+    * Helper method.
+    * Encodes the first numAttrs key attributes of a record into a composite key. The bytes of the other key attributes
+    * are set to fill, 0x00 for the smallest key with those first attributes and 0xFF for the largest.
+    * @param record  Record holding the key attributes at their offsets
+    * @param numAttrs  Number of key attributes to encode
+    * @param fill  Byte the other key attributes are set to
+    */
+  CompositeKey encodeKey(const char* record, const int numAttrs, const unsigned char fill) const;
+
+  /**
+    * Helper method.
+    * Copies the included attributes of n leaf entries to out, payloadSize bytes each. Only a covering index has any,
+    * for the other key types there is nothing to copy.
+    * @param node  Leaf of the entries
+    * @param first  Position of the first entry
+    * @param n  Number of entries
+    * @param out  Array of n times payloadSize bytes
+    */
+  template <class T>
+  void copyPayloads(const LeafNode<T>* node, const int first, const int n, unsigned char* out) const {}
+
+  void copyPayloads(const LeafNode<CoveringKey>* node, const int first, const int n, unsigned char* out) const;
+
+  /**
+    * Helper method.
+    * Guards the methods of one storage mode: those that take or return record ids, which the leaves of a clustered index
+    * do not hold, and those that take or return the records only a clustered index holds.
+    * @param storageMode  Storage mode the method needs
+    * @throws  BadIndexInfoException  If the index is stored the other way
+    */
+  void checkStorage(const StorageMode storageMode) const;
+
+  /**
+    * Helper method.
+    * Returns the record of entry i of a leaf of a clustered index, stored after the leafOccupancy key slots of the leaf.
+    * @param node  The leaf
+    * @param i  Position of the entry
+    */
+  template <class T>
+  char* leafRecord(LeafNode<T>* node, const int i) const { return (char*) (node->keyArray + leafOccupancy) + i * recordSize; }
+
+  /**
+    * Helper method.
+    * Moves the keys and records of n entries of a leaf of a clustered index to a position in the same leaf or in another one.
+    * The two ranges may overlap.
+    * @param from  Leaf the entries are in
+    * @param first  Position of the first entry to move
+    * @param to  Leaf the entries move to
+    * @param dest  Position the first entry moves to
+    * @param n  Number of entries
+    */
+  template <class T>
+  void moveRecords(LeafNode<T>* from, const int first, LeafNode<T>* to, const int dest, const int n) const;
+
+  /**
+    * Helper method.
+    * @param node  A leaf
+    * @param first	Position of the first entry to count
+    * @param last	Position past the last entry to count
+    * @return	Number of tuples the entries stand for: one per entry of a clustered index, otherwise as ridCount counts them
+    */
+  template <class T>
+  int entryCount(const LeafNode<T>* node, const int first, const int last);
+
+  /**
+    * Helper method.
+    * Inserts a record into a clustered index. Called by insertRecord once the key type is known.
+    * @param record  The record, recordSize bytes
+    */
+  template <class T>
+  void insertRecordTyped(const char* record);
+
+  /**
+    * Helper method.
+    * Splits a full leaf of a clustered index to insert a record, like splitLeaf splits a leaf of record ids.
+    * @param key   Key of the record
+    * @param record  The record
+    * @param pageNo PageId of the leaf
+    * @param page  The leaf, pinned and latched by the caller. Released here.
+    * @param path  Path of non-leaf nodes visited from the root, used in splitting
+    */
+  template <class T>
+  void splitRecordLeaf(const T& key, const char* record, const PageId pageNo, Page* page, TreePath &path);
+
+  /**
+    * Helper method.
+    * Finds the first record with a key in a clustered index. Called by lookupRecord once the key type is known.
+    * @param key   Key to look up
+    * @param out	The record found, returned in recordSize bytes
+    * @return	True if there is a record with the key
+    */
+  template <class T>
+  bool lookupRecordTyped(const T& key, char* out);
+
+  /**
+    * Helper method.
+    * Creates the tree of a new index file over the tuples of the base relation, either with the bulk loader or by
+    * inserting the entry of every tuple one at a time.
+    * @param relationName  Name of the base relation
+    * @param indexName  Name of the index file
+    * @param bulkLoadMode  True to use the bulk loader
+    * @param fillFactor  Fraction of each node filled by the bulk loader
+    */
+  template <class T>
+  void buildIndex(const std::string & relationName, const std::string & indexName, const bool bulkLoadMode, const float fillFactor);
+
+  /**
+    * Helper method.
+    * Inserts a typed key into the tree. Called by insertEntry once the key type is known.
+    * @param key   Key to insert
+    * @param rid	Record ID of a record whose entry is getting inserted into the index.
+    */
+  template <class T>
+  void insertEntryTyped(const T& key, const RecordId rid);
+
+  /**
+    * Helper method.
+    * Inserts a batch of entries, merging the run of each leaf into it in one pass. Called by insertBatch once the key type is known.
+    * @param keys	Array of n pointers to the keys to insert
+    * @param rids	Array of n record ids, rids[i] is inserted with keys[i]
+    * @param n	Number of entries
+    */
+  template <class T>
+  void insertBatchTyped(const void* const* keys, const RecordId* rids, size_t n);
+
+  /**
+    * Helper method.
+    * Splits a leaf into as many leaves as its merged entries need, at most MAXBATCHSPLIT, spreading the entries evenly
+    * or packing them as the split policy decides. The new leaves go in one at a time, each like a split by splitLeaf.
+    * @param keys	Merged keys of the leaf, more than leafOccupancy of them
+    * @param rids	Merged record ids of the leaf
+    * @param pageNo	PageId of the leaf
+    * @param page	The leaf, pinned and latched by the caller. Released here.
+    * @param append	True if the entries were appended past the last key of the rightmost leaf
+    * @param path	Path of non-leaf nodes visited from the root
+    */
+  template <class T>
+  void splitLeafBatch(const std::vector<T>& keys, const std::vector<LeafRid>& rids, const PageId pageNo, Page* page, const bool append, TreePath &path);
+
+  /**
+    * Helper method.
+    * Returns how many of the entries of an overflowing node the left node keeps, as the split policy decides.
+    * @param numEntries  Number of entries, or keys of a non-leaf node, including the one being inserted
+    * @param evenCount  Number the left node keeps in an even split
+    * @param append  True if the insert goes past the last key of the rightmost node of its level
+    */
+  int splitPoint(const int numEntries, const int evenCount, const bool append) const;
+
+  /**
+    * Helper method.
+    * Returns how many entries each leaf of a batch split but the last keeps, as the split policy decides.
+    * @param append  True if the entries were appended past the last key of the rightmost leaf
+    */
+  int batchLeafCount(const bool append) const;
+
+  /**
+    * Helper method.
+    * Finds the record ids of the entries equal to a typed key. Called by lookup and lookupAll once the key type is known.
+    * @param key   Key to look up
+    * @param out	Array the record ids found are returned in
+    * @param max	Maximum number of record ids to return
+    * @return	Number of record ids returned
+    */
+  template <class T>
+  size_t lookupTyped(const T& key, RecordId* out, size_t max);
+
+  /**
+    * Helper method.
+    * Copies the record ids of up to max entries equal to a key, starting at the leaf a descent for the key found
+    * and following right siblings while the key continues there.
+    * @param key   Key to look up
+    * @param pageNo	PageId of the leaf found by the descent
+    * @param out	Array the record ids found are returned in
+    * @param max	Maximum number of record ids to return, at least 1
+    * @return	Number of record ids returned
+    */
+  template <class T>
+  size_t searchLeaf(const T& key, PageId pageNo, RecordId* out, size_t max);
+
+  /**
+    * Helper method.
+    * Looks up a batch of keys with up to INTERLEAVEDPROBES descents in flight. Called by lookupInterleaved once the key type is known.
+    * @param keys	Array of n pointers to the keys to look up
+    * @param n	Number of keys
+    * @param results	Array of n RecordIds, the record id found for keys[i] is returned in results[i]
+    * @param found	Array of n flags, found[i] is set to whether keys[i] is in the index
+    * @return	Number of keys found
+    */
+  template <class T>
+  size_t lookupInterleavedTyped(const void* const* keys, size_t n, RecordId* results, bool* found);
+
+  /**
+    * Helper method.
+    * Starts loading the parts of a non-leaf node a search reads into the CPU cache, if the node cache holds the node.
+    * @param pageNo	PageId of the node
+    * @return	The frame of the node, pinned by the cache, NULL if the node cache does not hold it
+    */
+  template <class T>
+  Page* prefetchNode(const PageId pageNo);
+
+  /**
+    * Helper method.
+    * Counts the entries in a range of typed keys. Called by countRange once the operators are checked and the key type is known.
+    * The count is the difference of the number of entries below the two bounds.
+    * @param lowVal	Low value of range
+    * @param lowOp		Low operator (GT/GTE)
+    * @param highVal	High value of range
+    * @param highOp	High operator (LT/LTE)
+    * @return	Number of entries in the range
+    */
+  template <class T>
+  size_t countRangeTyped(const T& lowVal, const Operator lowOp, const T& highVal, const Operator highOp);
+
+  /**
+    * Helper method.
+    * Counts the entries less than a key, or less than or equal to it. Descends like searchEntry, adding up the subtree counts
+    * of the children left of the one followed, and of every node it moves right past. Only the leaf at the end is read entry by entry.
+    * The count is exact if no insert runs concurrently, otherwise it may miss inserts that have not reached the root yet.
+    * @param key  Key to count below
+    * @param orEqual  True to count the entries equal to the key as well
+    * @return  Number of entries less than the key, or less than or equal to it
+    */
+  template <class T>
+  size_t countBelow(const T& key, const bool orEqual);
+
+  /**
+    * Helper method.
+    * Finds the entry at a position in key order. Called by select once the key type is known.
+    * In every node it follows the child whose subtree holds the position, by the subtree counts, and moves right
+    * when the position lies past the node, which concurrent inserts that have not reached the root yet can cause.
+    * @param i	Position of the entry, 0 for the smallest
+    * @param out	Record id of the entry, returned in this if there is one
+    * @return	True if the index has more than i entries
+    */
+  template <class T>
+  bool selectTyped(size_t i, RecordId& out);
+
+  /**
+    * Helper method.
+    * Looks up a batch of keys, sweeping them across the leaves in key order. Called by lookupBatch once the key type is known.
+    * @param keys	Array of n pointers to the keys to look up
+    * @param n	Number of keys
+    * @param results	Array of n RecordIds, the record id found for keys[i] is returned in results[i]
+    * @param found	Array of n flags, found[i] is set to whether keys[i] is in the index
+    * @return	Number of keys found
+    */
+  template <class T>
+  size_t lookupBatchTyped(const void* const* keys, size_t n, RecordId* results, bool* found);
+
+  /**
+    * Helper method.
+    * Returns true if a key is not beyond the high key of a non-leaf node, so that a descent from the node finds it.
+    * @param pageNo	PageId of the non-leaf node
+    * @param height	Height of the node above the leaves
+    * @param key	Key to check
+    */
+  template <class T>
+  bool nodeCoversKey(const PageId pageNo, const int height, const T& key);
+
+  /**
+    * Helper method.
+    * Searches for the leaf in B+ Tree where the wanted key value belongs, descending level by level from the root.
+    * In every node it follows the child left of the first key that is greater than or equal to the given key value,
+    * or moves right to the sibling if a concurrent split left the key beyond the high key of the node.
+    * Non-leaf nodes are read optimistically without their latch and read again if a writer overlapped the read.
+    * When there is only one root in the tree, it defaults to return the rootPageNum.
+    * @param key  Key to search for
+    * @param pageNo   PageId of the leaf found, returned to the caller method
+    * @param path   Path of non-leaf nodes visited from the root, used in splitting
+    * @param stopHeight  Height above the leaves to stop at, 0 to find the leaf. A split uses it to find the parent of a non-leaf node
+    */
+  template <class T>
+  void searchEntry(const T& key, PageId &pageNo, TreePath &path, const int stopHeight = 0);
+
+  /**
+    * Helper method.
+    * Descends from a non-leaf node to the node at stopHeight where the key belongs, like searchEntry does from the root.
+    * @param key  Key to search for
+    * @param pageNo   PageId of the node to start from, replaced by the PageId of the node found
+    * @param height   Height of the node to start from above the leaves
+    * @param path   Path to append the non-leaf nodes visited to
+    * @param stopHeight  Height above the leaves to stop at, 0 to find the leaf
+    */
+  template <class T>
+  void descend(const T& key, PageId &pageNo, int height, TreePath &path, const int stopHeight);
+
+  /**
+    * Helper method.
+    * Finds the page to go to next from a non-leaf node, reading the node optimistically: the child left of the first key
+    * that is greater than or equal to the given key value, or the right sibling if the key is beyond the high key of the node.
+    * @param page  The non-leaf node, pinned by the caller
+    * @param key  Key to search for
+    * @param nextPageNo  PageId of the child or right sibling to go to, returned to the caller
+    * @return  True if nextPageNo is the right sibling
+    */
+  template <class T>
+  bool searchNonLeaf(Page* page, const T& key, PageId &nextPageNo);
+
+  /**
+    * Helper method.
+    * Pins a non-leaf node for reading. A cached node is returned directly. Any other node is read with readPage,
+    * and kept pinned in the upper level cache while there is room: half of the cache is kept for the levels above
+    * the parents of the leaves, which are visited first.
+    * @param pageNo  PageId of the node
+    * @param height  Height of the node above the leaves
+    * @param cached  Set to true if the node is in the cache, then it must not be unpinned
+    * @return  The frame of the node
+    */
+  Page* readNonLeaf(const PageId pageNo, const int height, bool &cached);
+
+  /**
+    * Helper method.
+    * Releases a node read with readNonLeaf.
+    * @param pageNo  PageId of the node
+    * @param cached  The flag readNonLeaf returned
+    */
+  void releaseNonLeaf(const PageId pageNo, const bool cached);
+
+  /**
+    * Helper method.
+    * Inserts data entry key-rid pair into the leaf node specified by pageNo, or into a right sibling of it if the leaf
+    * was split since the descent. If the leaf node has enough space, we insert. Otherwise, we split by calling splitLeaf.
+    * @param key   Key to insert
+    * @param rid	Record ID of a record whose entry is getting inserted into the index.
+    * @param pageNo PageId of the leaf found by searchEntry
+    * @param path  Path of non-leaf nodes visited from the root, used in splitting
+    */
+  template <class T>
+  void insertEntryLeaf(const T& key, const RecordId rid, PageId pageNo, TreePath &path);
+
+  /**
+    * Helper method.
+    * Splits a leaf Page/node after an overflow in leaf node
+    * The left node keeps ceil((leafOccupancy+1)/2) entries and the new node on its right gets the rest.
+    * The new node is linked in, then the separator is inserted into the parent. The leaf stays latched until the parent is,
+    * so that no other inserter can split the new node before the parent knows it.
+    * @param key   Key to insert
+    * @param rid	Record ID of a record whose entry is getting inserted into the index.
+    * @param pageNo PageId of a Page/node, this is being passed in from caller method.
+    * @param page  The leaf, pinned and latched by the caller. Released here.
+    * @param path  Path of non-leaf nodes visited from the root, used in splitting
+    */
+  template <class T>
+  void splitLeaf(const T& key, const RecordId rid, const PageId pageNo, Page* page, TreePath &path);
+
+  /**
+    * Helper method.
+    * Points the left link of a leaf to the new leaf a split put on its left. Called by the splitter with the split leaf
+    * still latched, after its right link leads to the new leaf, so leaves are latched from left to right as everywhere else.
+    * @param pageNo PageId of the leaf, Page::INVALID_NUMBER if the split leaf was the rightmost one
+    * @param leftSibPageNo PageId of the new left sibling
+    */
+  template <class T>
+  void linkLeft(const PageId pageNo, const PageId leftSibPageNo);
+
+  /**
+    * Helper method.
+    * Moves the entries of every key that has POSTINGTHRESHOLD or more of them among keys[0, n) into a new posting list,
+    * and the entries of a key that already has a posting list there into that list. The entries left are compacted.
+    * @param keys	Sorted keys of the entries
+    * @param rids	Record ids of the entries
+    * @param n	Number of entries
+    * @return	Number of entries left
+    */
+  template <class T>
+  int packPostings(T* keys, LeafRid* rids, const int n);
+
+  /**
+    * Helper method.
+    * Writes a new posting list.
+    * @param rids	Record ids of the list, at least one, in postingLess order
+    * @return	PageId of the first page of the list
+    */
+  PageId createPosting(const std::vector<RecordId>& rids);
+
+  /**
+    * Helper method.
+    * Adds a record id to a posting list. Appends to the last page if the record id sorts after every one in the list,
+    * else decodes and rewrites the page it sorts into, splitting the page if it overflows.
+    * The caller holds the latch of the leaf linking to the list, and counts the record id in its entry with postingLinkAdd.
+    * @param headPageNo	PageId of the first page of the list
+    * @param rid	Record id to add
+    */
+  void addPosting(const PageId headPageNo, const RecordId rid);
+
+  /**
+    * Helper method.
+    * @param link	Record id of a leaf entry linking to a posting list
+    * @return	Number of record ids in the list. Taken from the entry, only lists longer than MAXPOSTINGCOUNT read the first page
+    */
+  int postingSize(const RecordId& link);
+
+  /**
+    * Helper method.
+    * @param headPageNo	PageId of the first page of a posting list
+    * @param backward	True for the page a BACKWARD copy starts at, the last one
+    * @return	PageId of the page a copy of the list starts at
+    */
+  PageId postingStart(const PageId headPageNo, const bool backward);
+
+  /**
+    * Helper method.
+    * @param headPageNo	PageId of the first page of a posting list
+    * @param i	Position in the list, less than postingSize
+    * @return	Record id at position i of the list
+    */
+  RecordId postingRidAt(const PageId headPageNo, int i);
+
+  /**
+    * Helper method.
+    * Copies up to max record ids of a posting list, in list order or reversed, from its start or after the record id
+    * a previous copy stopped at.
+    * @param pageNo	Page the copy starts at, set to the page it stopped on or Page::INVALID_NUMBER at the end of the list
+    * @param lastRid	Record id a previous copy stopped at, set to the last one copied
+    * @param lastRidCopies	Number of copies of lastRid returned so far, updated with the ones copied
+    * @param resume	True to go on after lastRid, false to copy from the start of the list
+    * @param backward	True to copy in reverse order
+    * @param out	Array the record ids are copied to
+    * @param max	Maximum number of record ids to copy
+    * @return	Number of record ids copied
+    */
+  size_t copyPosting(PageId& pageNo, RecordId& lastRid, int& lastRidCopies, const bool resume, const bool backward,
+                     RecordId* out, size_t max);
+
+  /**
+    * Helper method.
+    * @param rids	Record ids of leaf entries
+    * @param first	Position of the first entry to count
+    * @param last	Position past the last entry to count
+    * @return	Number of record ids the entries stand for, posting lists counted by the size kept in their entry
+    */
+  int ridCount(const LeafRid* rids, const int first, const int last);
+
+  /**
+    * Helper method.
+    * Latches the internal node specified by pageNo and finds the child childPageNo among its children.
+    * If a concurrent split moved the child to a right sibling of the node, moves right until it finds it.
+    * @param key   A key in the key range of the child, at or below its smallest key is enough
+    * @param pageNo PageId of the node to start at, replaced by the PageId of the node holding the child
+    * @param page  The node holding the child, returned pinned and latched
+    * @param childPageNo PageId of the child
+    * @return  Position of the child among the children of the node
+    */
+  template <class T>
+  int latchParent(const T& key, PageId &pageNo, Page* &page, const PageId childPageNo);
+
+  /**
+    * Helper method.
+    * Adds the entries a split or flushCounts put into a node to the subtree counts of its ancestors, from the parent up to the root.
+    * Each node stays latched until its parent is, as in a split. So when a node is latched, every split and flush below it has
+    * counted its entries in the parent, and a split can hand the exact counts of its two halves to the parent.
+    * @param key   A key in the key range of the node, used to find the parent again if the tree grew
+    * @param pageNo PageId of the node the entries went into
+    * @param page  The node, pinned and latched by the caller, its own entries or counts already updated. Released here.
+    * @param delta  Number of entries inserted below the node
+    * @param height  Height of the node above the leaves, 0 for a leaf
+    * @param path  Path of non-leaf nodes visited from the root
+    */
+  template <class T>
+  void countUp(const T& key, PageId pageNo, Page* page, const int delta, int height, TreePath &path);
+
+  /**
+    * Helper method.
+    * Counts the entries an insert put into a leaf without splitting it in the pendingCount of the leaf, so that the insert
+    * latches no node above the leaf. The first pending entries of the leaf list it in pendingLeaves.
+    * @param pageNo PageId of the leaf
+    * @param page  The leaf, pinned and latched by the caller, its entries already updated. Released here.
+    * @param delta  Number of entries inserted into the leaf
+    */
+  template <class T>
+  void countLater(const PageId pageNo, Page* page, const int delta);
 
   /**
-   * File object for the index file.
-   */
-	File		*file;
+    * Helper method.
+    * Adds the pendingCount of every leaf in pendingLeaves to the subtree counts of its ancestors with countUp, and clears it.
+    * Run before the subtree counts are read, and when the index is closed. The counts then take in every insert that finished before.
+    */
+  void flushCounts();
+
+  template <class T>
+  void flushCountsTyped();
 
   /**
-   * Buffer Manager Instance.
-   */
-	BufMgr	*bufMgr;
+    * Helper method.
+    * Inserts the key that was propagated up into the internal node specified by pageNo, right after the child leftPageNo that was split.
+    * If a concurrent split moved the child to a right sibling of the node, the insert moves right until it finds it.
+    * If the internal node has enough space, we insert. Otherwise, we split by calling splitInternal.
+    * The two halves get the entry counts the split passes up, and the entries the split added are counted in the ancestors.
+    * @param key   Key to insert, the separator before the subtree newPageNo, at most its smallest key
+    * @param pageNo PageId of a Page/node, this is being passed in from caller method.
+    * @param leftPageNo PageId of the child that was split
+    * @param leftPage  The child that was split, pinned and latched by the caller. Released once the node holding it is latched.
+    * @param leftCount  Number of entries in the subtree of leftPageNo after the split
+    * @param newPageNo PageId of a Page/node created after split. const because we prevent modifying it
+    * @param newCount  Number of entries in the subtree of newPageNo
+    * @param height  Height of the node pageNo above the leaves, 1 for the level right above them
+    * @param path  Path of non-leaf nodes visited from the root, used in splitting
+    */
+  template <class T>
+  void insertEntryInternal(const T& key, PageId pageNo, const PageId leftPageNo, Page* leftPage, const int leftCount, const PageId newPageNo, const int newCount, const int height, TreePath &path);
 
   /**
-   * Page number of meta page.
-   */
-	PageId	headerPageNum;
+    * Helper method.
+    * Splits an internal Page/node after an overflow in internal node
+    * Of the nodeOccupancy+1 keys, the left node keeps the first half, the middle key is pushed up and the new node gets the rest.
+    * @param key   Key to insert
+    * @param pageNo PageId of a Page/node, this is being passed in from caller method.
+    * @param page  The internal node, pinned and latched by the caller. Released here.
+    * @param childIndex  Position of the child that was split among the children of the node
+    * @param leftCount  Number of entries in the subtree of the child that was split
+    * @param newPageNo PageId of a Page/node created after split. const because we prevent modifying it
+    * @param newCount  Number of entries in the subtree of newPageNo
+    * @param height  Height of the node pageNo above the leaves
+    * @param path  Path of non-leaf nodes visited from the root, used in splitting
+    */
+  template <class T>
+  void splitInternal(const T& key, const PageId pageNo, Page* page, const int childIndex, const int leftCount, const PageId newPageNo, const int newCount, const int height, TreePath &path);
 
   /**
-   * page number of root page of B+ tree inside index file.
-   */
-	PageId	rootPageNum;
+    * Helper method.
+    * Inserts the separator of a split node into its parent, the last node on the path. If the path is used up, the split node
+    * is either still the root, and the tree grows by one level, or another inserter grew the tree meanwhile, and the parent
+    * is found by descending again from the new root. The split node stays latched until its parent is.
+    * @param key   Separator, at most the smallest key of the subtree newPageNo
+    * @param leftPageNo PageId of the node that was split
+    * @param leftPage  The node that was split, pinned and latched by the caller. Released here.
+    * @param leftCount  Number of entries in the subtree of leftPageNo after the split
+    * @param newPageNo PageId of the node created by the split
+    * @param newCount  Number of entries in the subtree of newPageNo
+    * @param height  Height of the split node above the leaves, 0 for a leaf
+    * @param path  Path of non-leaf nodes visited from the root
+    */
+  template <class T>
+  void insertParent(const T& key, const PageId leftPageNo, Page* leftPage, const int leftCount, const PageId newPageNo, const int newCount, const int height, TreePath &path);
 
   /**
-   * Datatype of attribute over which index is built.
-   */
-	Datatype	attributeType;
+    * Helper method.
+    * Grows the tree by one level after the root was split: allocates a new root holding the two halves and records it in the meta page.
+    * Called with rootMutex held.
+    * @param key   Separator of the two halves, at most the smallest key of the right half
+    * @param leftPageNo PageId of the old root, now the left half
+    * @param leftCount  Number of entries in the left half
+    * @param rightPageNo PageId of the right half
+    * @param rightCount  Number of entries in the right half
+    * @param height  Height of the old root above the leaves, 0 if it was a leaf
+    */
+  template <class T>
+  void growRoot(const T& key, const PageId leftPageNo, const int leftCount, const PageId rightPageNo, const int rightCount, const int height);
 
   /**
-   * Offset of attribute, over which index is built, inside records.
-   */
-	int 		attrByteOffset;
+    * Helper method.
+    * Builds the whole tree bottom-up from the tuples of the base relation instead of inserting them one at a time.
+    * The key-rid pairs are collected with FileScan and sorted. Pairs that do not fit in the sort budget (half of the
+    * buffer pool) are spilled as sorted runs to a temporary file through the buffer manager and merged afterwards.
+    * A clustered index collects the records with their pairs in the same scan, the heap file is read once.
+    * The sorted stream is packed into leaves, and the non-leaf levels are then packed from the leaves, so every page is written once.
+    * @param relationName  Name of the base relation
+    * @param indexName  Name of the index file, used to name the temporary sort file
+    * @param fillFactor  Fraction of each node that is filled
+    */
+  template <class T>
+  void bulkLoad(const std::string & relationName, const std::string & indexName, const float fillFactor);
 
   /**
-   * Number of keys in leaf node, depending upon the type of key.
-   */
-	int			leafOccupancy;
+    * Helper method.
+    * Sorts the pairs collected in memory, moving the records collected with them in a clustered index along.
+    * @param pairs  Pairs collected in memory
+    * @param records  Records of the pairs in the same order, recordSize bytes each. Empty for an index of record ids
+    */
+  template <class T>
+  void sortEntries(std::vector< RIDKeyPair<T> > &pairs, std::vector<char> &records);
 
   /**
-   * Number of keys in non-leaf node, depending upon the type of key.
-   */
-	int			nodeOccupancy;
+    * Helper method.
+    * Sorts the pairs collected in memory and writes them out as a new sorted run to the temporary sort file.
+    * @param sortFile  Temporary sort file
+    * @param pairs  Pairs collected in memory, cleared on return
+    * @param records  Records of the pairs in a clustered index, written into the run with them and cleared on return
+    * @param runs  List of runs written so far, the new run is appended to it
+    */
+  template <class T>
+  void writeSortRun(File *sortFile, std::vector< RIDKeyPair<T> > &pairs, std::vector<char> &records, std::vector<SortRun> &runs);
 
-	// MEMBERS SPECIFIC TO SCANNING
+  /**
+    * Helper method.
+    * Merges the sorted runs and feeds the merged stream to the leaf level. When there are more runs than can be merged
+    * at once with the buffer pool, groups of runs are first merged into longer runs until one pass is enough.
+    * @param sortFile  Temporary sort file
+    * @param runs  Runs to merge
+    * @param state  Bulk load state of the leaf level
+    */
+  template <class T>
+  void mergeSortRuns(File *sortFile, std::vector<SortRun> &runs, BulkLoadState<T> &state);
 
   /**
-   * True if an index scan has been started.
-   */
-	bool		scanExecuting;
+    * Helper method.
+    * Merges runs [first, first+count) of the list. The merged pairs are appended to outRun if it is given, otherwise to the leaf level.
+    * @param sortFile  Temporary sort file
+    * @param runs  Runs to merge
+    * @param first  Index of the first run to merge
+    * @param count  Number of runs to merge
+    * @param outRun  Run to write the merged pairs to, or NULL to send them to the leaf level
+    * @param state  Bulk load state of the leaf level
+    */
+  template <class T>
+  void mergeRunGroup(File *sortFile, std::vector<SortRun> &runs, const int first, const int count, SortRun *outRun, BulkLoadState<T> &state);
 
   /**
-   * Index of next entry to be scanned in current leaf being scanned.
-   */
-	int			nextEntry;
+    * Helper method.
+    * Appends a pair to the leaf level being bulk loaded. Entries are spread evenly over the leaves,
+    * and a new leaf is started once the current one has received its share.
+    * @param pair  Next pair in sorted order
+    * @param record  Record of the pair in a clustered index, recordSize bytes. NULL for an index of record ids
+    * @param state  Bulk load state of the leaf level
+    */
+  template <class T>
+  void bulkLoadAppend(const RIDKeyPair<T> &pair, const char *record, BulkLoadState<T> &state);
 
   /**
-   * Page number of current page being scanned.
-   */
-	PageId	currentPageNum;
+    * Helper method.
+    * Finishes the leaf level and packs the non-leaf levels on top of it, one level at a time, until a single root remains.
+    * @param state  Bulk load state of the leaf level
+    * @param fillFactor  Fraction of each non-leaf node that is filled
+    */
+  template <class T>
+  void bulkLoadFinish(BulkLoadState<T> &state, const float fillFactor);
 
   /**
-   * Current Page being scanned.
-   */
-	Page		*currentPageData;
+    * Helper method.
+    * Starts a scan of the cursor over typed bounds. Called by ScanCursor::startScan once the parameters are checked and the key type is known.
+    * @param cursor	Cursor to start the scan of
+    */
+  template <class T>
+  void startScanTyped(ScanCursor& cursor, const T& lowVal, const T& highVal);
 
   /**
-   * Low INTEGER value for scan.
-   */
-	int			lowValInt;
+    * Helper method.
+    * Starts a BACKWARD scan of the cursor: finds the last entry that satisfies the scan criteria. Called by startScanTyped.
+    * @param cursor	Cursor to start the scan of
+    * @param lowVal	Low value of range
+    * @param highVal	High value of range
+    */
+  template <class T>
+  void startScanBackward(ScanCursor& cursor, const T& lowVal, const T& highVal);
 
   /**
-   * Low DOUBLE value for scan.
-   */
-	double	lowValDouble;
+    * Helper method.
+    * Fetches the next record id of the scan of the cursor. Called by ScanCursor::scanNext once the key type is known.
+    * @param cursor	Cursor of the scan
+    * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
+    */
+  template <class T>
+  void scanNextTyped(ScanCursor& cursor, RecordId& outRid);
 
   /**
-   * Low STRING value for scan.
-   */
-	std::string	lowValString;
+    * Helper method.
+    * Fetches the record ids of up to max next entries of the scan of the cursor. Called by ScanCursor::scanNextBatch once the key type is known.
+    * @param cursor	Cursor of the scan
+    * @param out	Array the record ids found are returned in
+    * @param max	Maximum number of record ids to return
+    * @param payloads	Array the included attributes of the entries found are returned in, payloadSize bytes each. NULL if they are not wanted
+    * @return	Number of record ids returned
+    */
+  template <class T>
+  size_t scanNextBatchTyped(ScanCursor& cursor, RecordId* out, size_t max, unsigned char* payloads = NULL);
 
   /**
-   * High INTEGER value for scan.
-   */
-	int			highValInt;
+    * Helper method.
+    * Fetches the record ids of up to max next entries of the scan of the cursor like scanNextBatchTyped, going on in the next
+    * group of a skip scan whenever one is used up. Called by scanNextTyped and ScanCursor::scanNextBatch for composite and covering keys.
+    * @param cursor	Cursor of the scan
+    * @param out	Array the record ids found are returned in
+    * @param max	Maximum number of record ids to return
+    * @param payloads	Array the included attributes of the entries found are returned in, payloadSize bytes each. NULL if they are not wanted
+    * @return	Number of record ids returned
+    */
+  template <class T>
+  size_t skipScanBatchTyped(ScanCursor& cursor, RecordId* out, size_t max, unsigned char* payloads = NULL);
 
   /**
-   * High DOUBLE value for scan.
-   */
-	double	highValDouble;
+    * Helper method.
+    * Starts the scan of the cursor over the next group of a skip scan with an entry in the range of the second key attribute,
+    * in the direction of the scan. Dispatches on the key type to nextSkipGroupTyped.
+    * @param cursor	Cursor of the skip scan
+    * @param first	Whether the skip scan has no group yet, then the first group is searched from the end of the index the scan starts at
+    * @return	False once no group is left, then the scan returns no more entries
+    */
+  bool nextSkipGroup(ScanCursor& cursor, const bool first);
 
   /**
-   * High STRING value for scan.
-   */
-	std::string highValString;
+    * Helper method.
+    * Typed body of nextSkipGroup, for COMPOSITE and COVERING keys.
+    */
+  template <class T>
+  bool nextSkipGroupTyped(ScanCursor& cursor, const bool first);
 
   /**
-   * Low Operator. Can only be GT(>) or GTE(>=).
-   */
-	Operator	lowOp;
+    * Helper method.
+    * Finds the key nearest to a key in the direction of an operator: the first key > key or >= key for GT and GTE,
+    * the last key < key or <= key for LT and LTE.
+    * @param key	Key to search from
+    * @param op	GT, GTE, LT or LTE
+    * @param found	Key found, returned in this
+    * @return	False if the index has no such key
+    */
+  template <class T>
+  bool seekKey(const T& key, const Operator op, T& found);
 
   /**
-   * High Operator. Can only be LT(<) or LTE(<=).
-   */
-	Operator	highOp;
+    * Helper method.
+    * Copies up to max next records of the scan of the cursor over a clustered index, in either direction.
+    * Called by ScanCursor::scanNextRecordBatch once the key type is known.
+    * @param cursor	Cursor of the scan
+    * @param out	Array the records found are returned in, recordSize bytes each
+    * @param max	Maximum number of records to return
+    * @return	Number of records returned
+    */
+  template <class T>
+  size_t scanRecordsTyped(ScanCursor& cursor, char* out, size_t max);
 
-  // ADDED HELPERS BELOW
   /**
-    * used to check whether there is only one node in tree, i.e., the root
+    * Helper method.
+    * Called when the scan of the cursor moves to a new leaf. Queues the next right siblings of the leaf to be prefetched into the
+    * buffer pool by the prefetch thread of the buffer manager, taking their page numbers from the parent of the leaf so that
+    * no sibling has to be read to find the next one. No page is read while the caller holds the latch of the leaf.
+    * @param cursor	Cursor of the scan
+    * @param leafPageNo	PageId of the leaf the scan moved to
+    * @param leafNode	The leaf the scan moved to, pinned by the caller
     */
-  bool onlyOneRoot;
+  template <class T>
+  void readAhead(ScanCursor& cursor, const PageId leafPageNo, const LeafNode<T>* leafNode);
 
   /**
     * Helper method.
-    * Searches for the node in B+ Tree where the wanted key value belongs recursively, 
-    * loop through all keys in the node and stop once it finds a key that is strictly greater than the given key value.
-    * When there is only one root in the tree, it defaults to return the rootPageNum.
-    * @param key  Key to insert, according specification, assuming it is an int
-    * @param pageNo   PageId of a Page/node, this is being passed in from caller method
-    * @param rootPageNum  PageId of the Page/node we are operating on, rootPageNum is passed in to this method in the initial call to this method
-    * @param visitedNodes   List of Pages, stores all visited Pages/nodes, used in splitting
+    * Saves the next entry of the scan, the one at cursor.nextEntry, so that relocateScan can find it again: its key,
+    * its record id or record, and how many entries equal to it the scan returned from the leaf before.
+    * @param cursor	Cursor of the scan
+    * @param node	The current leaf of the scan, latched by the caller
     */
-  void searchEntry(int key, PageId &pageNo, PageId rootPageNum, std::vector<PageId> &visitedNodes);
+  template <class T>
+  void saveScanPosition(ScanCursor& cursor, LeafNode<T>* node);
 
   /**
     * Helper method.
-    * Inserts data entry key-rid pair into the leaf node specified by pageNo. 
-    * If the leaf node has enough space, we insert. Otherwise, we split by calling splitLeaf.
-    * @param key   Key to insert, according specification, assuming it is an int
-    * @param rid	Record ID of a record whose entry is getting inserted into the index.
-    * @param pageNo PageId of a Page/node, this is being passed in from caller method. const because we prevent modifying it
-    * @param visitedNodes  List of Pages, stores all visited Pages/nodes, used in splitting
+    * @param cursor	Cursor of the scan
+    * @param node	Leaf holding entry i
+    * @param i	Position of an entry in the leaf, with the key of the next entry of the scan
+    * @return	True if entry i is the next entry of the scan or one equal to it
     */
-  void insertEntryLeaf(int key, const RecordId rid, const PageId pageNo, std::vector<PageId> &visitedNodes);
+  template <class T>
+  bool isScanEntry(const ScanCursor& cursor, LeafNode<T>* node, const int i) const;
 
   /**
     * Helper method.
-    * Splits a leaf Page/node after an overflow in leaf node
-    * The size, or capacity, of the new node is calculated based on leafOccupancy using the formula ceil((leafOccupancy+1)/2.
-    * @param key   Key to insert, according specification, assuming it is an int
-    * @param rid	Record ID of a record whose entry is getting inserted into the index.
-    * @param pageNo PageId of a Page/node, this is being passed in from caller method.
-    * @param visitedNodes  List of Pages, stores all visited Pages/nodes, used in splitting
+    * Concurrent inserts may shift the entries of the current leaf of the scan, or move them to a new right sibling,
+    * between two calls of scanNext. Finds the next entry again among the entries of its key, moving right if needed.
+    * @param cursor	Cursor of the scan
+    * @param page	The current leaf of the scan, pinned and latched by the caller. Replaced by the leaf holding the next entry
     */
-  void splitLeaf(int key, const RecordId rid, PageId pageNo, std::vector<PageId> &visitedNodes);
+  template <class T>
+  void relocateScan(ScanCursor& cursor, Page*& page);
 
   /**
     * Helper method.
-    * Inserts the key that was propagated up into the internal node specified by pageNo. 
-    * If the internal node has enough space, we insert. Otherwise, we split by calling splitInternal.
-    * @param key   Key to insert, according specification, assuming it is an int
-    * @param pageNo PageId of a Page/node, this is being passed in from caller method.
-    * @param newPageNo PageId of a Page/node created after split. const because we prevent modifying it
-    * @param visitedNodes  List of Pages, stores all visited Pages/nodes, used in splitting
-    * @param splitFromLeaf  Boolean, whether the split happens at an internal node 1 level above leaf node or more levels above leaf node
+    * Fetches the record ids of up to max next entries of a BACKWARD scan of the cursor, in descending key order.
+    * Called by scanNextBatchTyped for BACKWARD scans, and so by scanNextTyped.
+    * @param cursor	Cursor of the scan
+    * @param out	Array the record ids found are returned in
+    * @param max	Maximum number of record ids to return
+    * @param payloads	Array the included attributes of the entries found are returned in, NULL if they are not wanted
+    * @return	Number of record ids returned
     */
-  void insertEntryInternal(int key, PageId pageNo, const PageId newPageNo, std::vector<PageId> visitedNodes, bool splitFromLeaf);
+  template <class T>
+  size_t scanPrevBatchTyped(ScanCursor& cursor, RecordId* out, size_t max, unsigned char* payloads);
 
   /**
     * Helper method.
-    * Splits an internal Page/node after an overflow in internal node
-    * The size, or capacity, of the new node is calculated based on nodeOccupancy using the formula ceil((nodeOccupancy+1)/2.
-    * @param key   Key to insert, according specification, assuming it is an int
-    * @param pageNo PageId of a Page/node, this is being passed in from caller method.
-    * @param newPageNo PageId of a Page/node created after split. const because we prevent modifying it
-    * @param visitedNodes  List of Pages, stores all visited Pages/nodes, used in splitting
-    * @param splitFromLeaf  Boolean, whether the split happens at an internal node 1 level above leaf node or more levels above leaf node
+    * Moves from a leaf to the leaf on its left. The leaf is released before the left one is latched, since splitters
+    * latch leaves from left to right. The left link may lead further left than the neighbour if that neighbour was split
+    * meanwhile, so the move goes right from there to the leaf whose right link is the one it came from.
+    * @param pageNo	PageId of the leaf, replaced by the PageId of the leaf on its left
+    * @param page	The leaf, pinned and latched by the caller. Replaced by the leaf on its left, pinned and latched
+    * @return	False if the leaf is the leftmost one, then it is released and nothing is latched
     */
-  void splitInternal(int key, PageId pageNo, const PageId newPageNo, std::vector<PageId> &visitedNodes, bool splitFromLeaf);
+  template <class T>
+  bool moveLeft(PageId& pageNo, Page*& page);
 
 public:
 
@@ -372,16 +2764,93 @@ public:
    * BTreeIndex Constructor.
 	 * Check to see if the corresponding index file exists. If so, open the file.
 	 * If not, create it and insert entries for every tuple in the base relation using FileScan class.
+	 * In bulk load mode the entries are sorted first and the tree is built bottom-up, otherwise they are inserted one by one.
    *
    * @param relationName        Name of file.
    * @param outIndexName        Return the name of index file.
    * @param bufMgrIn						Buffer Manager Instance
    * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
    * @param attrType						Datatype of attribute over which index is built
+   * @param bulkLoadMode				True to build a new index with the bulk loader, false to insert every tuple with insertEntry
+   * @param fillFactor					Fraction of each node filled by the bulk loader, and by splits the split policy packs, in (0, 1]
+   * @param splitPolicy					How nodes are split when inserts overflow them
    * @throws  BadIndexInfoException     If the index file already exists for the corresponding attribute, but values in metapage(relationName, attribute byte offset, attribute type etc.) do not match with values received through constructor parameters.
    */
 	BTreeIndex(const std::string & relationName, std::string & outIndexName,
-						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType);
+						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType,
+						const bool bulkLoadMode = true, const float fillFactor = DEFAULTFILLFACTOR,
+						const SplitPolicy splitPolicy = DEFAULTSPLITPOLICY);
+
+
+  /**
+   * BTreeIndex Constructor for a composite index, over a key of several attributes ordered by the first, then the second and so on.
+	 * Opens or builds the index file like the constructor above. The index file is named after the relation and the offsets of the key attributes.
+	 * The key parameters of the methods of a composite index point to a record holding the key attributes at their offsets.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param keyAttrs						Offset and type of the key attributes, in key order. 2 to MAXKEYATTRS of them, together at most COMPOSITESIZE bytes wide
+   * @param bulkLoadMode				True to build a new index with the bulk loader, false to insert every tuple with insertEntry
+   * @param fillFactor					Fraction of each node filled by the bulk loader, and by splits the split policy packs, in (0, 1]
+   * @param splitPolicy					How nodes are split when inserts overflow them
+   * @throws  BadIndexInfoException     If the key attributes do not make a valid composite key, or the index file already exists but its metapage does not match the parameters.
+   */
+	BTreeIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const std::vector<KeyAttr> & keyAttrs,
+						const bool bulkLoadMode = true, const float fillFactor = DEFAULTFILLFACTOR,
+						const SplitPolicy splitPolicy = DEFAULTSPLITPOLICY);
+
+
+  /**
+   * BTreeIndex Constructor for a covering index. The key is one or more attributes, ordered like the key of a composite index,
+	 * and every leaf entry also keeps the included attributes of its record, so scans that only need those attributes
+	 * get them with scanNext and scanNextBatch without reading the record. A key with duplicates is not packed into a posting list.
+	 * The index file is named after the relation, the offsets of the key attributes and those of the included attributes.
+	 * The key parameters of the methods of a covering index point to a record, as for a composite index.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param keyAttrs						Offset and type of the key attributes, in key order. 1 to MAXKEYATTRS of them, together at most COMPOSITESIZE bytes wide
+   * @param includeAttrs				Offset and type of the included attributes. 1 to MAXINCLUDEATTRS of them, together at most PAYLOADSIZE bytes wide
+   * @param bulkLoadMode				True to build a new index with the bulk loader, false to insert every tuple with insertEntry
+   * @param fillFactor					Fraction of each node filled by the bulk loader, and by splits the split policy packs, in (0, 1]
+   * @param splitPolicy					How nodes are split when inserts overflow them
+   * @throws  BadIndexInfoException     If the attributes do not make a valid covering index, or the index file already exists but its metapage does not match the parameters.
+   */
+	BTreeIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const std::vector<KeyAttr> & keyAttrs, const std::vector<KeyAttr> & includeAttrs,
+						const bool bulkLoadMode = true, const float fillFactor = DEFAULTFILLFACTOR,
+						const SplitPolicy splitPolicy = DEFAULTSPLITPOLICY);
+
+
+  /**
+   * BTreeIndex Constructor with a storage mode. A SECONDARY index is the index the first constructor bulk loads.
+	 * A CLUSTERED index keeps the tuples of the relation in its leaves, in key order, instead of their record ids, so a lookup or
+	 * a range scan reads the tuples from the leaves it finds them in, with no second read in the heap file.
+	 * A new clustered index is bulk built from the heap file of the relation: the key-rid pairs are sorted as for any index,
+	 * and each leaf copies the records of its entries from the heap file. The index then holds its own copy of the tuples,
+	 * inserted with insertRecord and read with lookupRecord, scanNextRecord and scanNextRecordBatch. countRange and rank work
+	 * as for other indexes, the methods that take or return record ids do not apply.
+	 * The file of a clustered index is named like the file of a secondary index on the attribute, with ".clustered" appended.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
+   * @param attrType						Datatype of attribute over which index is built, INTEGER, DOUBLE or STRING
+   * @param storageMode					SECONDARY or CLUSTERED
+   * @param recordSize					Size of the tuples of the relation, up to MAXCLUSTEREDRECORDSIZE. Only used by a clustered index
+   * @param fillFactor					Fraction of each node filled by the bulk loader, and by splits the split policy packs, in (0, 1]
+   * @param splitPolicy					How nodes are split when inserts overflow them
+   * @throws  BadIndexInfoException     If the tuples are too small to hold the key attribute or larger than MAXCLUSTEREDRECORDSIZE,
+   *                                    or the index file already exists but its metapage does not match the parameters.
+   */
+	BTreeIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType,
+						const StorageMode storageMode, const int recordSize, const float fillFactor = DEFAULTFILLFACTOR,
+						const SplitPolicy splitPolicy = DEFAULTSPLITPOLICY);
 
 
   /**
@@ -399,12 +2868,125 @@ public:
 	 * This splitting will require addition of new leaf page number entry into the parent non-leaf, which may in-turn get split.
 	 * This may continue all the way upto the root causing the root to get split. If root gets split, metapage needs to be changed accordingly.
 	 * Make sure to unpin pages as soon as you can.
+	 * Several threads may insert into the index at the same time.
    * @param key			Key to insert, pointer to integer/double/char string
    * @param rid			Record ID of a record whose entry is getting inserted into the index.
 	**/
 	void insertEntry(const void* key, const RecordId rid);
 
 
+  /**
+	 * Insert a batch of entries, for instance the rows of one ingest batch. The batch is sorted, then the entries
+	 * that fall into one leaf are merged into it in one pass, and a leaf they overflow is split into as many leaves
+	 * as needed at once. Can run concurrently with insertEntry and other batches.
+   * @param keys		Array of n pointers to the keys to insert, each pointing to integer/double/char string. Any order
+   * @param rids		Array of n record ids, rids[i] is inserted with keys[i]
+   * @param n				Number of entries
+	**/
+	void insertBatch(const void* const* keys, const RecordId* rids, size_t n);
+
+
+  /**
+	 * Insert a tuple into a clustered index. The key is read from the record at the offset of the key attribute,
+	 * and the record goes into the leaf of the key, which splits like the leaves of other indexes when it is full.
+	 * Several threads may insert into the index at the same time.
+   * @param record		The tuple, getRecordSize bytes
+   * @throws  BadIndexInfoException If the index is not clustered
+	**/
+	void insertRecord(const void* record);
+
+
+  /**
+	 * Look up a single key. Descends once from the root and binary searches the leaf, without setting up a scan.
+   * @param key			Key to look up, pointer to integer/double/char string
+   * @param out			Record ID of an entry with the key, returned in this if there is one
+   * @return	True if the key is in the index, false otherwise. A miss does not throw.
+	**/
+	bool lookup(const void* key, RecordId& out);
+
+
+  /**
+	 * Look up every entry of a key, for indexes with duplicate keys. Like lookup, but copies the record ids
+	 * of up to max entries with the key, following right siblings while the key continues there.
+   * @param key			Key to look up, pointer to integer/double/char string
+   * @param out			Array of at least max RecordIds, the record ids found are returned in it
+   * @param max			Maximum number of record ids to return
+   * @return	Number of record ids returned, 0 if the key is not in the index.
+	**/
+	size_t lookupAll(const void* key, RecordId* out, size_t max);
+
+
+  /**
+	 * Look up a batch of keys, for instance the probes of an index nested-loop join. The keys are sorted and swept
+	 * across the leaves in key order, so keys that fall into the same leaf share one descent, and keys in nearby
+	 * leaves only climb back up as far as the key range of a node requires.
+   * @param keys		Array of n pointers to the keys to look up, each pointing to integer/double/char string. Any order
+   * @param n				Number of keys
+   * @param results	Array of n RecordIds, the record id of an entry with keys[i] is returned in results[i] if there is one
+   * @param found		Array of n flags, found[i] is set to whether keys[i] is in the index
+   * @return	Number of keys found. Misses do not throw.
+	**/
+	size_t lookupBatch(const void* const* keys, size_t n, RecordId* results, bool* found);
+
+
+  /**
+	 * Look up a batch of keys that do not share descents, such as random probes. Up to INTERLEAVEDPROBES descents are
+	 * interleaved: each one reads a node, starts loading the next one it needs into the CPU cache and yields to the next descent,
+	 * so the CPU cache misses on the nodes of different descents overlap instead of being taken one after the other.
+	 * Nodes of the node cache are prefetched into the CPU cache. A descent that reaches a page that is not in the buffer pool
+	 * queues it for the prefetch thread of the buffer manager and waits while the other descents step, so disk reads overlap too.
+	 * Takes the same parameters as lookupBatch.
+   * @param keys		Array of n pointers to the keys to look up, each pointing to integer/double/char string. Any order
+   * @param n				Number of keys
+   * @param results	Array of n RecordIds, the record id of an entry with keys[i] is returned in results[i] if there is one
+   * @param found		Array of n flags, found[i] is set to whether keys[i] is in the index
+   * @return	Number of keys found. Misses do not throw.
+	**/
+	size_t lookupInterleaved(const void* const* keys, size_t n, RecordId* results, bool* found);
+
+
+  /**
+	 * Look up a single key of a clustered index and copy the first tuple with it, straight from its leaf.
+   * @param key			Key to look up, pointer to integer/double/char string
+   * @param record	The tuple, returned in getRecordSize bytes if there is one
+   * @return	True if the key is in the index, false otherwise. A miss does not throw.
+   * @throws  BadIndexInfoException If the index is not clustered
+	**/
+	bool lookupRecord(const void* key, void* record);
+
+
+  /**
+	 * Count the entries in a range without scanning it. Every non-leaf node stores the number of entries below each
+	 * of its children, so the count is summed up on the descents to the two bounds and only the two boundary leaves are read.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE)
+   * @return	Number of entries in the range, 0 if there are none. Exact if no insert runs concurrently.
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	**/
+	size_t countRange(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+
+  /**
+	 * Rank of a key: the number of entries less than it, which is the position in key order of the first entry not less than it.
+	 * Answered from the subtree counts like countRange, reading a single leaf.
+   * @param key			Key to rank, pointer to integer/double/char string. Does not need to be in the index
+   * @return	Number of entries less than the key
+	**/
+	size_t rank(const void* key);
+
+
+  /**
+	 * Select the entry at a position in key order, the inverse of rank. Descends by the subtree counts to the one leaf holding it.
+   * @param i				Position of the entry, 0 for the smallest
+   * @param out			Record ID of the entry, returned in this if there is one
+   * @return	True if the index has more than i entries, false otherwise
+	**/
+	bool select(size_t i, RecordId& out);
+
+
   /**
 	 * Begin a filtered scan of the index.  For instance, if the method is called
 	 * using ("a",GT,"d",LTE) then we should seek all entries with a value
@@ -412,15 +2994,60 @@ public:
 	 * If another scan is already executing, that needs to be ended here.
 	 * Set up all the variables for scan. Start from root to find out the leaf page that contains the first RecordID
 	 * that satisfies the scan parameters. Keep that page pinned in the buffer pool.
+	 * A BACKWARD scan starts from the last RecordID that satisfies the scan parameters instead and follows the left links
+	 * of the leaves, so a query for the largest N keys of a range only reads the leaves holding them.
    * @param lowVal	Low value of range, pointer to integer / double / char string
    * @param lowOp		Low operator (GT/GTE)
    * @param highVal	High value of range, pointer to integer / double / char string
    * @param highOp	High operator (LT/LTE)
+   * @param direction	FORWARD to return the entries in ascending key order, BACKWARD for descending
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies the scan criteria.
+	**/
+	void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp, const ScanDirection direction = FORWARD);
+
+
+  /**
+	 * Begin a scan of a composite index bounded on the first numAttrs attributes of the key only, e.g. on i of an index over (i, d).
+	 * The bounds are records like the other key parameters of a composite index, only their first numAttrs key attributes are read.
+	 * An entry is in the range if its first numAttrs key attributes are, so GTE and LTE take every entry with the bound values
+	 * and GT and LT take none of them. With equal bounds under GTE and LTE the scan returns the entries with that prefix.
+   * @param lowVal	Low value of range, pointer to a record
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to a record
+   * @param highOp	High operator (LT/LTE)
+   * @param numAttrs	Number of key attributes the bounds apply to, from 1 to the number of key attributes
+   * @param direction	FORWARD to return the entries in ascending key order, BACKWARD for descending
+   * @throws  BadScanParamException If the index is not composite or covering, or numAttrs is not between 1 and the number of key attributes
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies the scan criteria.
+	**/
+	void startPrefixScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp, const int numAttrs,
+	                     const ScanDirection direction = FORWARD);
+
+
+  /**
+	 * Begin a skip scan of a composite index bounded on the second attribute of the key only, e.g. on d of an index over (i, d).
+	 * The entries with the same first attribute lie together in the index, ordered by the second one, so the scan
+	 * finds each distinct value of the first attribute by seeking the tree past the previous one, and scans the range
+	 * of the second attribute inside it. It reads the leaves holding the matches and one path of the tree per distinct value,
+	 * which beats a FileScan of the relation when the first attribute has few distinct values.
+	 * The bounds are records like the other key parameters of a composite index, only their second key attribute is read.
+	 * The entries are returned in key order, by the first attribute and then by the second, with scanNext and scanNextBatch.
+   * @param lowVal	Low value of range, pointer to a record
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to a record
+   * @param highOp	High operator (LT/LTE)
+   * @param direction	FORWARD to return the entries in ascending key order, BACKWARD for descending
+   * @throws  BadScanParamException If the index is not composite or covering, or its key has a single attribute
    * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
    * @throws  BadScanrangeException If lowVal > highval
 	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies the scan criteria.
 	**/
-	void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+	void startSkipScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp,
+	                   const ScanDirection direction = FORWARD);
 
 
   /**
@@ -428,11 +3055,97 @@ public:
 	 * Return the next record from current page being scanned. If current page has been scanned to its entirety, move on to the right sibling of current page, if any exists, to start scanning that page. Make sure to unpin any pages that are no longer required.
    * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
 	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadIndexInfoException If the index is clustered, its leaves hold no record ids.
 	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
 	**/
 	void scanNext(RecordId& outRid);  // returned record id
 
 
+  /**
+	 * Fetch the record id and the included attributes of the next index entry that matches the scan of a covering index.
+	 * The included attributes come from the leaf, so an index-only scan reads no page of the relation.
+   * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
+   * @param payload	Included attributes of the entry, returned in getPayloadSize bytes: ints and doubles as the record
+   *                stores them and strings as their first STRINGSIZE characters, zero padded, one after the other
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadScanParamException If the index is not a covering index.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	void scanNext(RecordId& outRid, void* payload);
+
+
+  /**
+	 * Fetch the record ids of up to max next index entries that match the scan.
+	 * Copies every matching record id from the current page in one pass, keeping it pinned only for the duration of the call,
+	 * then moves on to the right sibling, or the left one in a BACKWARD scan, while there is room left in out. Can be mixed with calls to scanNext.
+   * @param out	Array of at least max RecordIds, the record ids found are returned in it in the order of the scan
+   * @param max	Maximum number of record ids to return
+   * @return	Number of record ids returned. 0 once no more records, satisfying the scan criteria, are left to be scanned.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadIndexInfoException If the index is clustered, its leaves hold no record ids.
+	**/
+	size_t scanNextBatch(RecordId* out, size_t max);
+
+
+  /**
+	 * Fetch the record ids and the included attributes of up to max next index entries that match the scan of a covering index,
+	 * like scanNextBatch and scanNext with a payload.
+   * @param out	Array of at least max RecordIds, the record ids found are returned in it in the order of the scan
+   * @param payloads	Array of max times getPayloadSize bytes, the included attributes of out[i] are returned at payloads + i * getPayloadSize()
+   * @param max	Maximum number of record ids to return
+   * @return	Number of record ids returned. 0 once no more records, satisfying the scan criteria, are left to be scanned.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadScanParamException If the index is not a covering index.
+	**/
+	size_t scanNextBatch(RecordId* out, void* payloads, size_t max);
+
+
+  /**
+	 * Fetch the next tuple that matches the scan of a clustered index, started with startScan in either direction.
+   * @param record	The tuple, returned in getRecordSize bytes
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadIndexInfoException If the index is not clustered.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	void scanNextRecord(void* record);
+
+
+  /**
+	 * Fetch up to max next tuples that match the scan of a clustered index. The records of a leaf lie side by side in key order,
+	 * so a FORWARD scan copies the run of a leaf that is in the range with a single copy. Can be mixed with calls to scanNextRecord.
+   * @param records	Array of max times getRecordSize bytes, the tuples found are returned in it in the order of the scan
+   * @param max	Maximum number of tuples to return
+   * @return	Number of tuples returned. 0 once no more records, satisfying the scan criteria, are left to be scanned.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadIndexInfoException If the index is not clustered.
+	**/
+	size_t scanNextRecordBatch(void* records, size_t max);
+
+
+  /**
+	 * Number of bytes of the included attributes scanNext and scanNextBatch return for an entry of a covering index, 0 for other indexes.
+	**/
+	int getPayloadSize() const { return payloadSize; }
+
+
+  /**
+	 * Size of the tuples a clustered index keeps in its leaves, 0 for an index of record ids.
+	**/
+	int getRecordSize() const { return recordSize; }
+
+
+  /**
+	 * Number of non-leaf levels of the tree, 0 while the root is a leaf.
+	**/
+	int getTreeHeight() const { return treeHeight; }
+
+
+  /**
+	 * Number of non-leaf nodes the index keeps pinned in its upper level cache.
+	**/
+	int getNumCachedNodes() const { return nodeCache.size(); }
+
+
   /**
 	 * Terminate the current scan. Unpin any pinned pages. Reset scan specific variables.
 	 * @throws ScanNotInitializedException If no scan has been initialized.
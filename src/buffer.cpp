@@ -7,12 +7,14 @@
 
 #include <memory>
 #include <iostream>
+#include <algorithm>
 #include "buffer.h"
 #include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/bad_buffer_exception.h"
 #include "exceptions/hash_not_found_exception.h"
+#include "exceptions/badgerdb_exception.h"
 
 namespace badgerdb { 
 
@@ -36,10 +38,22 @@ BufMgr::BufMgr(std::uint32_t bufs)
   hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
 
   clockHand = bufs - 1;
+
+  prefetchFile = NULL;
+  prefetchStop = false;
+  prefetchThread = std::thread(&BufMgr::prefetchLoop, this);
 }
 
 
 BufMgr::~BufMgr() {
+  // stop the prefetch thread before the frames go away
+  {
+    std::lock_guard<std::mutex> guard(prefetchMutex);
+    prefetchStop = true;
+  }
+  prefetchCond.notify_all();
+  prefetchThread.join();
+
   //Flush out all unwritten pages
   for (std::uint32_t i = 0; i < numBufs; i++) 
   {
@@ -59,7 +73,7 @@ void BufMgr::allocBuf(FrameId & frame)
 {
   // perform first part of clock algorithm to search for 
   // open buffer frame
-  // Assumes non-concurrent access to buffer manager
+  // Called with bufMutex held
   std::uint32_t numScanned = 0;
   bool found = 0;
 
@@ -120,6 +134,8 @@ void BufMgr::allocBuf(FrameId & frame)
 	
 void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
 {
+  std::lock_guard<std::mutex> guard(bufMutex);
+
   // check to see if it is already in the buffer pool
   // std::cout << "readPage called on file.page " << file << "." << pageNo << endl;
   FrameId frameNo = 0;
@@ -152,8 +168,141 @@ void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
 }
 
 
+const Page* BufMgr::prefetchPage(File* file, const PageId pageNo)
+{
+  std::lock_guard<std::mutex> guard(bufMutex);
+
+  // nothing to do if it is already in the buffer pool
+  FrameId frameNo = 0;
+	try
+	{
+  	hashTable->lookup(file, pageNo, frameNo);
+		return &bufPool[frameNo];
+  }
+  catch(const HashNotFoundException &e)
+  {
+  }
+
+  // alloc a new frame, a prefetch is only a hint so give up if every frame is pinned
+	try
+	{
+    allocBuf(frameNo);
+  }
+  catch(const BufferExceededException &e)
+  {
+		return NULL;
+  }
+
+  // read the page into the new frame
+  bufStats.diskreads++;
+  bufPool[frameNo] = file->readPage(pageNo);
+
+  // set up the entry properly, but leave the page unpinned
+  bufDescTable[frameNo].Set(file, pageNo);
+  bufDescTable[frameNo].pinCnt = 0;
+
+  // insert in the hash table
+  hashTable->insert(file, pageNo, frameNo);
+  return &bufPool[frameNo];
+}
+
+
+void BufMgr::prefetchPageAsync(File* file, const PageId pageNo)
+{
+  {
+    std::lock_guard<std::mutex> guard(prefetchMutex);
+    if (prefetchQueue.size() >= std::max<std::uint32_t>(1, numBufs / 4))
+    {
+      return;
+    }
+    prefetchQueue.push_back(std::make_pair(file, pageNo));
+  }
+  prefetchCond.notify_all();
+}
+
+
+bool BufMgr::isResident(File* file, const PageId pageNo)
+{
+  std::unique_lock<std::mutex> lock(bufMutex, std::try_to_lock);
+  if (!lock.owns_lock())
+  {
+    return false;
+  }
+
+  FrameId frameNo = 0;
+	try
+	{
+  	hashTable->lookup(file, pageNo, frameNo);
+		return true;
+  }
+  catch(const HashNotFoundException &e)
+  {
+		return false;
+  }
+}
+
+
+void BufMgr::prefetchLoop()
+{
+  std::unique_lock<std::mutex> lock(prefetchMutex);
+  while (true)
+  {
+    while (!prefetchStop && prefetchQueue.empty())
+    {
+      prefetchCond.wait(lock);
+    }
+    if (prefetchStop)
+    {
+      return;
+    }
+
+    std::pair<File*, PageId> request = prefetchQueue.front();
+    prefetchQueue.pop_front();
+    prefetchFile = request.first;
+    lock.unlock();
+
+    // the read runs under bufMutex like any other, but not under prefetchMutex so that more pages can be queued meanwhile
+    try
+    {
+      prefetchPage(request.first, request.second);
+    }
+    catch(const BadgerDbException &e)
+    {
+      // a prefetch is only a hint, e.g. the page may have been disposed of since it was queued
+    }
+
+    lock.lock();
+    prefetchFile = NULL;
+    prefetchCond.notify_all();
+  }
+}
+
+
+void BufMgr::cancelPrefetches(const File* file)
+{
+  std::unique_lock<std::mutex> lock(prefetchMutex);
+  for (std::deque<std::pair<File*, PageId> >::iterator it = prefetchQueue.begin(); it != prefetchQueue.end(); )
+  {
+    if (it->first == file)
+    {
+      it = prefetchQueue.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  while (prefetchFile == file)
+  {
+    prefetchCond.wait(lock);
+  }
+}
+
+
 void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty) 
 {
+  std::lock_guard<std::mutex> guard(bufMutex);
+
   // lookup in hashtable
   FrameId frameNo = 0;
   hashTable->lookup(file, pageNo, frameNo);
@@ -170,6 +319,8 @@ void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty)
 
 void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) 
 {
+  std::lock_guard<std::mutex> guard(bufMutex);
+
   FrameId frameNo;
 
   // alloc a new frame
@@ -189,6 +340,9 @@ void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page)
 
 void BufMgr::flushFile(const File* file) 
 {
+  cancelPrefetches(file);
+  std::lock_guard<std::mutex> guard(bufMutex);
+
   for (std::uint32_t i = 0; i < numBufs; i++)
 	{
   	BufDesc* tmpbuf = &(bufDescTable[i]);
@@ -214,6 +368,8 @@ void BufMgr::flushFile(const File* file)
 
 void BufMgr::disposePage(File* file, const PageId pageNo)
 {
+  std::lock_guard<std::mutex> guard(bufMutex);
+
 	//Deallocate from file altogether
   //See if it is in the buffer pool
   FrameId frameNo = 0;
@@ -10,6 +10,12 @@
 #include "file.h"
 #include "bufHashTbl.h"
 #include <iostream>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <utility>
 
 namespace badgerdb {
 
@@ -61,6 +67,18 @@ class BufDesc {
 	 */
   bool refbit;
 
+	/**
+   * Latch of the page in the frame, taken through BufMgr::latchPage by threads reading or changing the page.
+   * It belongs to the frame, so it is only meaningful while the page is pinned.
+	 */
+  std::mutex latch;
+
+	/**
+   * Version of the page in the frame. latchPage and unlatchPage each increment it, so it is odd while the latch is held
+   * and changes whenever the page may have changed. Readers validate against it instead of taking the latch.
+	 */
+  std::atomic<std::uint32_t> version;
+
 	/**
    * Initialize buffer frame for a new user
 	 */
@@ -111,6 +129,7 @@ class BufDesc {
    * Constructor of BufDesc class 
 	 */
   BufDesc()
+		: version(0)
 	{
   	Clear();
   }
@@ -186,6 +205,55 @@ class BufMgr
 	 */
   BufStats bufStats;
 
+	/**
+   * Serializes calls into the buffer manager, so that threads can pin and unpin pages concurrently.
+   * It covers the frame table, the hash table and the file I/O, but not the contents of the pages, see latchPage.
+	 */
+  std::mutex bufMutex;
+
+	/**
+   * Pages queued by prefetchPageAsync, read into the buffer pool by prefetchThread in the order they were queued.
+	 */
+  std::deque<std::pair<File*, PageId> > prefetchQueue;
+
+	/**
+   * File of the page prefetchThread is reading, NULL while it waits for work. cancelPrefetches waits for it to change.
+	 */
+  const File* prefetchFile;
+
+	/**
+   * Set by the destructor to stop prefetchThread.
+	 */
+  bool prefetchStop;
+
+	/**
+   * Protects prefetchQueue, prefetchFile and prefetchStop. Never held while bufMutex is taken.
+	 */
+  std::mutex prefetchMutex;
+
+	/**
+   * Signalled when pages are queued, when prefetchThread finishes a page and when it has to stop.
+	 */
+  std::condition_variable prefetchCond;
+
+	/**
+   * Background thread reading the queued pages with prefetchPage, so that the threads queueing them do not wait for the reads.
+	 */
+  std::thread prefetchThread;
+
+	/**
+   * Body of prefetchThread. Takes pages off prefetchQueue until the destructor sets prefetchStop.
+	 */
+  void prefetchLoop();
+
+	/**
+   * Drops the queued prefetches of the file and waits until prefetchThread is not reading a page of it,
+   * so that the file can be flushed and closed.
+	 *
+	 * @param file   	File object
+	 */
+  void cancelPrefetches(const File* file);
+
 	/**
    * Advance clock to next frame in the buffer pool
 	 */
@@ -229,6 +297,38 @@ class BufMgr
 	 */
   void readPage(File* file, const PageId PageNo, Page*& page);
 
+	/**
+	 * Reads the given page from the file into a frame without pinning it, so that a later readPage finds it in the buffer pool.
+	 * Does nothing if the page is already present, or if no frame can be freed for it.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @return  The frame holding the page, NULL if no frame could be freed. The page is not pinned, so the frame
+	 *          is only a hint, e.g. for a CPU prefetch of the page before it is read with readPage.
+	 */
+  const Page* prefetchPage(File* file, const PageId PageNo);
+
+	/**
+	 * Queues the given page to be read by prefetchPage on the background prefetch thread and returns at once.
+	 * If the caller reads the page with readPage before the prefetch gets to it, readPage reads it and the prefetch does nothing.
+	 * The queue holds at most a quarter of the buffer pool, further pages are dropped since a prefetch is only a hint.
+	 * flushFile drops the pages of the file that are still queued.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 */
+  void prefetchPageAsync(File* file, const PageId PageNo);
+
+	/**
+	 * Tells whether the given page is in the buffer pool, e.g. whether a page queued with prefetchPageAsync has been read.
+	 * Does not wait for the buffer manager: while another thread is in it, e.g. reading a page, the answer is false.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file
+	 * @return  True if the page is in the buffer pool
+	 */
+  bool isResident(File* file, const PageId PageNo);
+
 	/**
 	 * Unpin a page from memory since it is no longer required for it to remain in memory.
 	 *
@@ -250,7 +350,7 @@ class BufMgr
   void allocPage(File* file, PageId &PageNo, Page*& page); 
 
 	/**
-	 * Writes out all dirty pages of the file to disk.
+	 * Writes out all dirty pages of the file to disk. Pages of the file queued by prefetchPageAsync are dropped first.
 	 * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
 	 * Otherwise Error returned.
 	 *
@@ -270,6 +370,57 @@ class BufMgr
   void disposePage(File* file, const PageId PageNo);
 
 	/**
+	 * Takes the latch of the frame holding the page, waiting until no other thread holds it, and bumps the version of the page
+	 * so that optimistic readers see the page as changing. The page must be pinned by the caller and stay pinned until unlatchPage.
+	 *
+	 * @param page  	Page returned by readPage or allocPage
+	 */
+  void latchPage(Page* page)
+  {
+		BufDesc* desc = &bufDescTable[page - bufPool];
+		desc->latch.lock();
+		desc->version.store(desc->version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+  }
+
+	/**
+	 * Bumps the version of the page again and releases the latch taken with latchPage.
+	 *
+	 * @param page  	Page returned by readPage or allocPage
+	 */
+  void unlatchPage(Page* page)
+  {
+		BufDesc* desc = &bufDescTable[page - bufPool];
+		desc->version.store(desc->version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		desc->latch.unlock();
+  }
+
+	/**
+	 * Starts an optimistic read of a pinned page: returns the current version of the page, to be checked with validatePage
+	 * once the page has been read. An odd version means a writer holds the latch, and the read will not validate.
+	 * Reading this way writes nothing shared, unlike latchPage.
+	 *
+	 * @param page  	Page returned by readPage
+	 */
+  std::uint32_t pageVersion(Page* page) const
+  {
+		return bufDescTable[page - bufPool].version.load(std::memory_order_acquire);
+  }
+
+	/**
+	 * Ends an optimistic read started with pageVersion. Returns true if no writer latched the page since, so that what was
+	 * read from it is consistent. Otherwise the values read must be thrown away and the read started again.
+	 *
+	 * @param page  	Page returned by readPage
+	 * @param version	Version returned by pageVersion
+	 */
+  bool validatePage(Page* page, const std::uint32_t version) const
+  {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return (version & 1) == 0 && bufDescTable[page - bufPool].version.load(std::memory_order_relaxed) == version;
+  }
+
+	/**
    * Print member variable values. 
 	 */
   void  printSelf();
@@ -288,6 +439,14 @@ class BufMgr
   void clearBufStats() 
   {
 		bufStats.clear();
+  }
+
+	/**
+   * Get number of frames in the buffer pool
+	 */
+  std::uint32_t getNumBufs() const
+  {
+		return numBufs;
   }
 };
 
@@ -0,0 +1,149 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+// Benchmark of point lookups on a warm index. Builds an INTEGER index over a relation of random keys with a buffer pool
+// that holds all of it, then looks up random keys one at a time with lookup and in batches with lookupInterleaved,
+// and prints the time per lookup. Build and run with "make lookupbench".
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "btree.h"
+#include "page.h"
+#include "file.h"
+#include "buffer.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+const int relationSize = 500000;
+const int numProbes = 1 << 18;
+const int numRounds = 5;
+const int batchSize = 1024;
+
+const std::string relationName = "relLookupBench";
+
+struct RECORD {
+	int i;
+	double d;
+	char s[64];
+};
+
+/**
+ * Writes a relation whose int field takes every value of [0, relationSize) once, in random order.
+ */
+void createRelation()
+{
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+	PageFile file = PageFile::create(relationName);
+
+	std::vector<int> values(relationSize);
+	for(int k = 0; k < relationSize; k++)
+		values[k] = k;
+	for(int k = relationSize - 1; k > 0; k--)
+		std::swap(values[k], values[random() % (k + 1)]);
+
+	RECORD record;
+	memset(&record, 0, sizeof(RECORD));
+	PageId pageNo;
+	Page page = file.allocatePage(pageNo);
+	for(int k = 0; k < relationSize; k++)
+	{
+		record.i = values[k];
+		record.d = values[k];
+		sprintf(record.s, "%05d string record", values[k]);
+		std::string data(reinterpret_cast<char*>(&record), sizeof(RECORD));
+		while(1)
+		{
+			try
+			{
+				page.insertRecord(data);
+				break;
+			}
+			catch(const InsufficientSpaceException &e)
+			{
+				file.writePage(pageNo, page);
+				page = file.allocatePage(pageNo);
+			}
+		}
+	}
+	file.writePage(pageNo, page);
+}
+
+/**
+ * Returns the time per lookup in nanoseconds of numRounds passes over the probes, one key at a time or interleaved.
+ * Sets numFound to the keys found in the last pass.
+ */
+double timeLookups(BTreeIndex &index, const std::vector<int> &probes, bool interleaved, size_t &numFound)
+{
+	std::vector<const void*> keyPtrs(batchSize);
+	std::vector<RecordId> rids(batchSize);
+	bool found[batchSize];
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for(int round = 0; round < numRounds; round++)
+	{
+		numFound = 0;
+		for(int b = 0; b < numProbes; b += batchSize)
+		{
+			if(interleaved)
+			{
+				for(int p = 0; p < batchSize; p++)
+					keyPtrs[p] = &probes[b + p];
+				numFound += index.lookupInterleaved(&keyPtrs[0], batchSize, &rids[0], found);
+			}
+			else
+			{
+				for(int p = 0; p < batchSize; p++)
+					numFound += index.lookup(&probes[b + p], rids[p]) ? 1 : 0;
+			}
+		}
+	}
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / ((double) numRounds * numProbes);
+}
+
+int main()
+{
+	createRelation();
+	BufMgr * bufMgr = new BufMgr(8000);
+	std::string indexName;
+	int result = 0;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offsetof(RECORD,i), INTEGER);
+
+		// half of the probes hit
+		std::vector<int> probes(numProbes);
+		for(int p = 0; p < numProbes; p++)
+			probes[p] = (int) (random() % (2 * relationSize));
+
+		size_t foundOne, foundInterleaved;
+		timeLookups(index, probes, false, foundOne);  // warm the buffer pool and the node cache
+		double one = timeLookups(index, probes, false, foundOne);
+		double interleaved = timeLookups(index, probes, true, foundInterleaved);
+		if(foundOne != foundInterleaved)
+		{
+			std::cout << "lookup and lookupInterleaved disagree: " << foundOne << " and " << foundInterleaved << " keys found" << std::endl;
+			result = 1;
+		}
+		std::cout << "INTEGER index of " << relationSize << " keys, ns per lookup:" << std::endl;
+		std::cout << "  lookup:            " << one << std::endl;
+		std::cout << "  lookupInterleaved: " << interleaved << std::endl;
+	}
+	delete bufMgr;
+	File::remove(indexName);
+	File::remove(relationName);
+	return result;
+}
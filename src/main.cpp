@@ -6,6 +6,10 @@
  */
 
 #include <vector>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <fstream>
 #include "btree.h"
 #include "page.h"
 #include "filescan.h"
@@ -17,8 +21,10 @@
 #include "exceptions/no_such_key_found_exception.h"
 #include "exceptions/bad_scanrange_exception.h"
 #include "exceptions/bad_opcodes_exception.h"
+#include "exceptions/bad_scan_param_exception.h"
 #include "exceptions/scan_not_initialized_exception.h"
 #include "exceptions/end_of_file_exception.h"
+#include "exceptions/bad_index_info_exception.h"
 
 #define checkPassFail(a, b) 																				\
 {																																		\
@@ -66,8 +72,26 @@ BufMgr * bufMgr = new BufMgr(100);
 void createRelationForward(int relationSize = relationSize);
 void createRelationBackward(int relationSize = relationSize);
 void createRelationRandom(int relationSize = relationSize);
-void intTests(int isLarge);
+void createRelationGroups(int relationSize, int numGroups);
+void intTests(int isLarge, bool bulkLoadMode);
 int intScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int intScanBatch(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize);
+int intScanInterleaved(BTreeIndex *index, int lowVal1, int highVal1, int lowVal2, int highVal2);
+int intLookups(BTreeIndex *index, int lowVal, int highVal);
+int intLookupDuplicates(BTreeIndex *index, int key, int numDuplicates);
+int intPostings(BTreeIndex *index, int key, int numDuplicates);
+int intPostingInserts(BTreeIndex *index, int key, int batchSize, int insertsPerBatch);
+int intScanInserts(BTreeIndex *index, int key, int numDuplicates, int batchSize, int insertsPerBatch);
+int intLookupBatch(BTreeIndex *index, int lowVal, int highVal, int step, bool interleaved);
+int intCountRange(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int intScanBackward(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize, int limit);
+int intRanks(BTreeIndex *index, int lowVal, int highVal, int step);
+void doubleTests(int isLarge);
+int doubleScan(BTreeIndex *index, double lowVal, Operator lowOp, double highVal, Operator highOp, ScanDirection direction = FORWARD);
+int doubleCountRange(BTreeIndex *index, double lowVal, Operator lowOp, double highVal, Operator highOp);
+void stringTests();
+int stringScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int stringPrefixCounts(BTreeIndex *index, int lowVal, int highVal);
 void indexTests(int isLarge);
 void test1();
 void test2();
@@ -76,6 +100,43 @@ void test3();
 void test4();
 void test5();
 void test6();
+// bulk load test with a small buffer pool, so that the sort spills and merges in several passes
+void test7();
+// several threads inserting into one index at the same time
+void test8();
+// batches of entries inserted into one index from two threads
+void test9();
+// split policies for increasing keys
+void test10();
+int intIndexPages(SplitPolicy splitPolicy, float fillFactor);
+// composite keys and prefix scans
+void test11();
+int compositeScan(BTreeIndex *index, int lowI, double lowD, Operator lowOp, int highI, double highD, Operator highOp, int numAttrs, ScanDirection direction = FORWARD);
+// covering indexes and index-only scans
+void test12();
+int coveringScan(BTreeIndex *index, const RECORD &lowVal, const RECORD &highVal, int numAttrs, const std::vector<KeyAttr> &includeAttrs, size_t batchSize, ScanDirection direction = FORWARD);
+// clustered indexes holding the tuples in their leaves
+void test13();
+int clusteredScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize, ScanDirection direction = FORWARD);
+int clusteredLookups(BTreeIndex *index, int lowVal, int highVal);
+// skip scans of composite indexes bounded on the second key attribute
+void test14();
+int skipScan(BTreeIndex *index, double lowD, Operator lowOp, double highD, Operator highOp, size_t batchSize, ScanDirection direction = FORWARD);
+// read-ahead of long scans on a small buffer pool, and closing files with prefetches queued
+void test15();
+// internal splits and root growth under the upper level node cache, with room for all parents of leaves and without
+void test16();
+// throughput of inserters running next to a reader, against a single inserter
+void test17();
+double timedInserts(BTreeIndex *index, const std::vector< std::pair<double, RecordId> > *entries, int numInserters, int *found);
+// string keys whose separators are shorter than the keys, in increasing and in random order
+void test18();
+void separatorKey(int k, char *key);
+int compositeLookups(BTreeIndex *index, const std::vector< std::pair<RECORD, RecordId> > &entries, int first, int last);
+void insertEntries(BTreeIndex *index, const std::vector< std::pair<double, RecordId> > *entries, int first, int step);
+void insertEntryBatches(BTreeIndex *index, const std::vector< std::pair<double, RecordId> > *entries, int first, int step, int batchSize);
+bool entryKeyLess(const std::pair<double, RecordId> &a, const std::pair<double, RecordId> &b);
+void lookupEntries(BTreeIndex *index, const std::vector< std::pair<double, RecordId> > *entries, int first, int step, int *found);
 void errorTests();
 void deleteRelation();
 
@@ -144,6 +205,18 @@ int main(int argc, char **argv)
 	test4();
 	test5();
 	test6();
+	test7();
+	test8();
+	test9();
+	test10();
+	test11();
+	test12();
+	test13();
+	test14();
+	test15();
+	test16();
+	test17();
+	test18();
 	errorTests();
 
 	delete bufMgr;
@@ -220,6 +293,37 @@ void test6()
 	deleteRelation();
 }
 
+// additional test for bulk loading a random-order relation with a small buffer pool
+void test7()
+{
+	// Create a relation with tuples valued 0 to 50000 in random order and bulk load an index on it
+	// with only 10 buffer frames, so the sort spills runs and needs more than one merge pass
+	std::cout << "--------------------" << std::endl;
+	std::cout << "bulkLoadSmallBufferPool" << std::endl;
+	createRelationRandom(50000);
+
+	BufMgr * savedBufMgr = bufMgr;
+	bufMgr = new BufMgr(10);
+	{
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		checkPassFail(intScan(&index,25,GT,40,LT), 14)
+		checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+		checkPassFail(intScan(&index,0,GTE,50000,LT), 50000)
+		checkPassFail(intScan(&index,49000,GT,60000,LT), 999)
+	}
+	deleteRelation();
+	delete bufMgr;
+	bufMgr = savedBufMgr;
+
+	try
+	{
+		File::remove(intIndexName);
+	}
+  catch(const FileNotFoundException &e)
+  {
+  }
+}
+
 // -----------------------------------------------------------------------------
 // createRelationForward
 // -----------------------------------------------------------------------------
@@ -382,74 +486,330 @@ void createRelationRandom(int relationSize) // add an input to the tester functi
 }
 
 // -----------------------------------------------------------------------------
-// indexTests
+// createRelationGroups
 // -----------------------------------------------------------------------------
-
-void indexTests(int isLarge)
+void createRelationGroups(int relationSize, int numGroups) // tuple k gets i = k % numGroups and d = k, so each value of i repeats
 {
-  intTests(isLarge);
 	try
 	{
-		File::remove(intIndexName);
+		File::remove(relationName);
 	}
-  catch(const FileNotFoundException &e)
-  {
+	catch(const FileNotFoundException &e)
+	{
+	}
+  file1 = new PageFile(relationName, true);
+
+  memset(record1.s, ' ', sizeof(record1.s));
+	PageId new_page_number;
+  Page new_page = file1->allocatePage(new_page_number);
+
+  for(int k = 0; k < relationSize; k++ )
+	{
+    sprintf(record1.s, "%05d string record", k);
+    record1.i = k % numGroups;
+    record1.d = (double)k;
+    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
+
+		while(1)
+		{
+			try
+			{
+    		new_page.insertRecord(new_data);
+				break;
+			}
+			catch(const InsufficientSpaceException &e)
+			{
+				file1->writePage(new_page_number, new_page);
+  			new_page = file1->allocatePage(new_page_number);
+			}
+		}
   }
+
+	file1->writePage(new_page_number, new_page);
 }
 
-// -----------------------------------------------------------------------------
-// intTests
-// -----------------------------------------------------------------------------
+// additional test for concurrent inserters
+void test8()
+{
+	// Create a relation with tuples valued 0 to 300000 and insert the entries of its double field from four threads
+	// into an index over an empty relation. Enough entries for the splits to reach the level above the leaves' parents.
+	// Half of the entries go in first, then three inserters add the rest while a reader looks up entries of the first half
+	std::cout << "--------------------" << std::endl;
+	std::cout << "concurrentInserters" << std::endl;
+	createRelationForward(300000);
+
+	std::vector< std::pair<double, RecordId> > entries;
+	{
+		FileScan fscan(relationName, bufMgr);
+		try
+		{
+			RecordId scanRid;
+			while(1)
+			{
+				fscan.scanNext(scanRid);
+				std::string recordStr = fscan.getRecord();
+				entries.push_back(std::make_pair(reinterpret_cast<const RECORD*>(recordStr.c_str())->d, scanRid));
+			}
+		}
+		catch(const EndOfFileException &e)
+		{
+		}
+	}
+
+	const std::string emptyRelationName = "relB";
+	std::string emptyIndexName;
+	try
+	{
+		File::remove(emptyRelationName);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+	{
+		PageFile emptyFile = PageFile::create(emptyRelationName);
+	}
+
+	{
+		BTreeIndex index(emptyRelationName, emptyIndexName, bufMgr, offsetof(tuple,d), DOUBLE, false);
+		insertEntries(&index, &entries, 0, 2);
+
+		const int numInserters = 3;
+		const int lookupStep = 2 * 97;
+		int found = 0;
+		std::vector<std::thread> threads;
+		for(int t = 0; t < numInserters; t++)
+			threads.push_back(std::thread(insertEntries, &index, &entries, 2 * t + 1, 2 * numInserters));
+		threads.push_back(std::thread(lookupEntries, &index, &entries, 0, lookupStep, &found));
+		for(size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+
+		checkPassFail(found, (int) ((entries.size() + lookupStep - 1) / lookupStep))
+
+		// the subtree counts of every node are exact once the inserters are done
+		checkPassFail(doubleCountRange(&index,0,GTE,300000,LT), 300000)
+		checkPassFail(doubleCountRange(&index,159000,GTE,160000,LT), 1000)
+		// the left links of the leaves, set by splits that ran concurrently
+		checkPassFail(doubleScan(&index,0,GTE,300000,LT,BACKWARD), 300000)
+
+		checkPassFail(doubleScan(&index,25,GT,40,LT), 14)
+		checkPassFail(doubleScan(&index,0,GTE,300000,LT), 300000)
+		checkPassFail(doubleScan(&index,159000,GTE,160000,LT), 1000)
+		checkPassFail(doubleScan(&index,299990.5,GT,400000,LT), 9)
+	}
+
+	try
+	{
+		File::remove(emptyIndexName);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+
+	// the same entries with negated keys, the first one -0.0, which the index keeps equal to 0
+	{
+		std::vector< std::pair<double, RecordId> > negatedEntries(entries.begin(), entries.begin() + 20000);
+		for(size_t i = 0; i < negatedEntries.size(); i++)
+			negatedEntries[i].first = -negatedEntries[i].first;
+
+		BTreeIndex index(emptyRelationName, emptyIndexName, bufMgr, offsetof(tuple,d), DOUBLE, false);
+		insertEntries(&index, &negatedEntries, 0, 1);
+		checkPassFail(doubleCountRange(&index,-20000,GT,0,LTE), 20000)
+		checkPassFail(doubleCountRange(&index,-25,GTE,-10,LT), 15)
+		checkPassFail(doubleCountRange(&index,-0.5,GT,0,LTE), 1)
+		checkPassFail(doubleCountRange(&index,-1e9,GT,-19999,LTE), 1)
+	}
 
-void intTests(int isLarge)
+	try
+	{
+		File::remove(emptyIndexName);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+	File::remove(emptyRelationName);
+	deleteRelation();
+}
+
+void test9()
 {
-  std::cout << "Create a B+ Tree index on the integer field" << std::endl;
-  BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+	// Create a relation with tuples valued 0 to 100000 in random order and insert the entries of its double field
+	// in batches of 10000 from two threads into an index over an empty relation. The first batch goes into an empty
+	// root leaf and splits it into a full level of leaves at once
+	std::cout << "--------------------" << std::endl;
+	std::cout << "batchInserters" << std::endl;
+	createRelationRandom(100000);
 
-	// run some tests
-	checkPassFail(intScan(&index,25,GT,40,LT), 14)
-	checkPassFail(intScan(&index,20,GTE,35,LTE), 16)
-	checkPassFail(intScan(&index,-3,GT,3,LT), 3)
-	checkPassFail(intScan(&index,996,GT,1001,LT), 4)
-	checkPassFail(intScan(&index,0,GT,1,LT), 0)
-	checkPassFail(intScan(&index,300,GT,400,LT), 99)
-	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
-        // add some extra tests to test edge cases
-        checkPassFail(intScan(&index,0,GTE,5000,LT), 5000)
-        checkPassFail(intScan(&index,-100,GTE,0,LTE), 1)
-        // test out of bound cases for relation of size 5000
-        if (isLarge == 0){
-            checkPassFail(intScan(&index,0,GTE,5000,LTE), 5000)
-            checkPassFail(intScan(&index,4999,GTE,6000,LT), 1)
-            checkPassFail(intScan(&index,4000,GT,7000,LT), 999)
-        }
-        // extra tests for large relations
-        if (isLarge == 1){
-            checkPassFail(intScan(&index,30000,GTE,40000,LTE), 10001)
-	    checkPassFail(intScan(&index,12345,GTE,12346,LT), 1)
-	    checkPassFail(intScan(&index,25000,GTE,26000,LT), 1000)
-	    checkPassFail(intScan(&index,209000,GTE,210000,LT), 1000)
-	    checkPassFail(intScan(&index,159000,GTE,160000,LT), 1000)
-            checkPassFail(intScan(&index,290000,GTE,300000,LT), 10000)
-        }
+	std::vector< std::pair<double, RecordId> > entries;
+	{
+		FileScan fscan(relationName, bufMgr);
+		try
+		{
+			RecordId scanRid;
+			while(1)
+			{
+				fscan.scanNext(scanRid);
+				std::string recordStr = fscan.getRecord();
+				entries.push_back(std::make_pair(reinterpret_cast<const RECORD*>(recordStr.c_str())->d, scanRid));
+			}
+		}
+		catch(const EndOfFileException &e)
+		{
+		}
+	}
+
+	const std::string emptyRelationName = "relB";
+	std::string emptyIndexName;
+	try
+	{
+		File::remove(emptyRelationName);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+	{
+		PageFile emptyFile = PageFile::create(emptyRelationName);
+	}
+
+	{
+		BTreeIndex index(emptyRelationName, emptyIndexName, bufMgr, offsetof(tuple,d), DOUBLE, false);
+		insertEntryBatches(&index, &entries, 0, 10, 10000);
+		std::thread inserter(insertEntryBatches, &index, &entries, 1, 2, 10000);
+		insertEntryBatches(&index, &entries, 2, 2, 10000);
+		inserter.join();
+
+		checkPassFail(doubleScan(&index,25,GT,40,LT), 14)
+		checkPassFail(doubleScan(&index,0,GTE,100000,LT), 100000)
+		checkPassFail(doubleScan(&index,59000,GTE,60000,LT), 1000)
+		checkPassFail(doubleScan(&index,99990.5,GT,200000,LT), 9)
+		checkPassFail(doubleCountRange(&index,0,GTE,100000,LT), 100000)
+		checkPassFail(doubleCountRange(&index,99990.5,GT,200000,LT), 9)
+		checkPassFail(doubleScan(&index,0,GTE,100000,LT,BACKWARD), 100000)
+	}
+
+	try
+	{
+		File::remove(emptyIndexName);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+
+	// the same entries in key order, appended in batches that each split the rightmost leaf into MAXBATCHSPLIT full leaves,
+	// with only 8 buffer frames: a batch split pins and latches one new leaf at a time
+	std::sort(entries.begin(), entries.end(), entryKeyLess);
+	BufMgr * savedBufMgr = bufMgr;
+	bufMgr = new BufMgr(8);
+	{
+		BTreeIndex index(emptyRelationName, emptyIndexName, bufMgr, offsetof(tuple,d), DOUBLE, false, 1.0, APPENDSPLIT);
+		insertEntryBatches(&index, &entries, 0, 1, 5000);
+		checkPassFail(doubleScan(&index,0,GTE,100000,LT), 100000)
+		checkPassFail(doubleCountRange(&index,59000,GTE,60000,LT), 1000)
+		checkPassFail(doubleScan(&index,0,GTE,100000,LT,BACKWARD), 100000)
+	}
+	delete bufMgr;
+	bufMgr = savedBufMgr;
+
+	try
+	{
+		File::remove(emptyIndexName);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+	File::remove(emptyRelationName);
+	deleteRelation();
 }
 
-int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+void test10()
+{
+	// Create a relation with tuples valued 0 to 50000 in key order and insert its entries one at a time,
+	// so every insert appends to the rightmost leaf. Splits that keep the left node full leave far fewer pages
+	std::cout << "--------------------" << std::endl;
+	std::cout << "appendSplits" << std::endl;
+	createRelationForward(50000);
+
+	int evenPages = intIndexPages(EVENSPLIT, DEFAULTFILLFACTOR);
+	int appendPages = intIndexPages(APPENDSPLIT, DEFAULTFILLFACTOR);
+	int fullPages = intIndexPages(APPENDSPLIT, 1.0);
+	std::cout << "Index pages: " << evenPages << " even, " << appendPages << " 90/10, " << fullPages << " 100/0" << std::endl;
+	checkPassFail((appendPages * 10 < evenPages * 6), true)
+	checkPassFail((fullPages <= appendPages), true)
+	checkPassFail(intIndexPages(FILLFACTORSPLIT, DEFAULTFILLFACTOR), appendPages)
+
+	deleteRelation();
+}
+
+void test11()
+{
+	// Create a relation whose int field takes 10 values, each in 500 tuples with increasing double fields, and index it
+	// on (i, d), with the bulk loader and by inserts. Prefix scans bound i only, scans on the whole key find a range of d in one group
+	std::cout << "--------------------" << std::endl;
+	std::cout << "compositeKeys" << std::endl;
+	createRelationGroups(relationSize, 10);
+
+	std::vector<KeyAttr> keyAttrs(2);
+	keyAttrs[0].attrByteOffset = offsetof(tuple,i);
+	keyAttrs[0].attrType = INTEGER;
+	keyAttrs[1].attrByteOffset = offsetof(tuple,d);
+	keyAttrs[1].attrType = DOUBLE;
+	std::string compositeIndexName;
+
+	for(int bulkLoadMode = 1; bulkLoadMode >= 0; bulkLoadMode--)
+	{
+		{
+			BTreeIndex index(relationName, compositeIndexName, bufMgr, keyAttrs, bulkLoadMode);
+			checkPassFail(compositeScan(&index,3,0,GTE,3,0,LTE,1), 500)
+			checkPassFail(compositeScan(&index,3,0,GT,6,0,LT,1), 1000)
+			checkPassFail(compositeScan(&index,-5,0,GTE,100,0,LTE,1), 5000)
+			checkPassFail(compositeScan(&index,3,1003,GTE,3,2003,LT,2), 100)
+			checkPassFail(compositeScan(&index,3,1003,GT,3,2003,LTE,2), 100)
+			checkPassFail(compositeScan(&index,3,-1,GT,4,-1,LT,2), 500)
+			checkPassFail(compositeScan(&index,9,0,GTE,9,0,LTE,1,BACKWARD), 500)
+
+			RECORD key;
+			key.i = 7;
+			key.d = 4997;
+			RecordId found;
+			checkPassFail(index.lookup(&key, found), true)
+			key.d = 4998;
+			checkPassFail(index.lookup(&key, found), false)
+		}
+
+		// the index file is opened again with the key attributes it was built over
+		{
+			BTreeIndex index(relationName, compositeIndexName, bufMgr, keyAttrs, bulkLoadMode);
+			checkPassFail(compositeScan(&index,0,0,GTE,1,0,LTE,1), 1000)
+		}
+		File::remove(compositeIndexName);
+	}
+
+	deleteRelation();
+}
+
+int compositeScan(BTreeIndex * index, int lowI, double lowD, Operator lowOp, int highI, double highD, Operator highOp, int numAttrs, ScanDirection direction)
 {
   RecordId scanRid;
 	Page *curPage;
 
-  std::cout << "Scan for ";
+  std::cout << (direction == BACKWARD ? "Backward prefix scan for " : "Prefix scan for ");
   if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
-  std::cout << lowVal << "," << highVal;
+  std::cout << lowI << ":" << lowD << "," << highI << ":" << highD;
   if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
-  std::cout << std::endl;
+  std::cout << " on " << numAttrs << " attributes" << std::endl;
+
+	RECORD lowVal, highVal;
+	lowVal.i = lowI;
+	lowVal.d = lowD;
+	highVal.i = highI;
+	highVal.d = highD;
 
   int numResults = 0;
-	
+  int prevI = 0;
+  double prevD = 0;
+
 	try
 	{
-  	index->startScan(&lowVal, lowOp, &highVal, highOp);
+  	index->startPrefixScan(&lowVal, lowOp, &highVal, highOp, numAttrs, direction);
 	}
 	catch(const NoSuchKeyFoundException &e)
 	{
@@ -466,15 +826,16 @@ int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operato
 			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
 			bufMgr->unPinPage(file1, scanRid.page_number, false);
 
-			if( numResults < 5 )
-			{
-				std::cout << "at:" << scanRid.page_number << "," << scanRid.slot_number;
-				std::cout << " -->:" << myRec.i << ":" << myRec.d << ":" << myRec.s << ":" <<std::endl;
-			}
-			else if( numResults == 5 )
+			// the keys are distinct, ordered by i and then by d
+			bool after = myRec.i != prevI ? myRec.i > prevI : myRec.d > prevD;
+			if( numResults > 0 && (direction == BACKWARD ? after : !after) )
 			{
-				std::cout << "..." << std::endl;
+				std::cout << "Out of order: " << myRec.i << ":" << myRec.d << " after " << prevI << ":" << prevD << std::endl;
+				index->endScan();
+				return -1;
 			}
+			prevI = myRec.i;
+			prevD = myRec.d;
 		}
 		catch(const IndexScanCompletedException &e)
 		{
@@ -484,56 +845,1647 @@ int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operato
 		numResults++;
 	}
 
-  if( numResults >= 5 )
-  {
-    std::cout << "Number of results: " << numResults << std::endl;
-  }
+  std::cout << "Number of results: " << numResults << std::endl;
   index->endScan();
   std::cout << std::endl;
 
 	return numResults;
 }
 
-// -----------------------------------------------------------------------------
-// errorTests
-// -----------------------------------------------------------------------------
-
-void errorTests()
+void test12()
 {
+	// Index the relation of test11 on d, including i and s, and on i alone, including d. Every value of i has 500 entries,
+	// which must keep their own included attributes instead of going into a posting list. The included attributes
+	// returned by the scans are compared with the records
+	std::cout << "--------------------" << std::endl;
+	std::cout << "coveringIndexes" << std::endl;
+	createRelationGroups(relationSize, 10);
+
+	std::vector<KeyAttr> dKey(1), iKey(1), iAndS(2), dOnly(1);
+	dKey[0].attrByteOffset = offsetof(tuple,d);
+	dKey[0].attrType = DOUBLE;
+	iKey[0].attrByteOffset = offsetof(tuple,i);
+	iKey[0].attrType = INTEGER;
+	iAndS[0] = iKey[0];
+	iAndS[1].attrByteOffset = offsetof(tuple,s);
+	iAndS[1].attrType = STRING;
+	dOnly[0] = dKey[0];
+	std::string coveringIndexName;
+
+	RECORD lowVal, highVal;
+	for(int bulkLoadMode = 1; bulkLoadMode >= 0; bulkLoadMode--)
 	{
-		std::cout << "Error handling tests" << std::endl;
-		std::cout << "--------------------" << std::endl;
-		// Given error test
-
-		try
 		{
-			File::remove(relationName);
+			BTreeIndex index(relationName, coveringIndexName, bufMgr, dKey, iAndS, bulkLoadMode);
+			checkPassFail(index.getPayloadSize(), 14)
+			lowVal.d = 1000;
+			highVal.d = 1999;
+			checkPassFail(coveringScan(&index,lowVal,highVal,1,iAndS,64), 1000)
+			checkPassFail(coveringScan(&index,lowVal,highVal,1,iAndS,1,BACKWARD), 1000)
 		}
-		catch(const FileNotFoundException &e)
+		File::remove(coveringIndexName);
+
 		{
+			BTreeIndex index(relationName, coveringIndexName, bufMgr, iKey, dOnly, bulkLoadMode);
+			lowVal.i = 3;
+			highVal.i = 3;
+			checkPassFail(coveringScan(&index,lowVal,highVal,1,dOnly,100), 500)
+			lowVal.i = 0;
+			highVal.i = 9;
+			checkPassFail(coveringScan(&index,lowVal,highVal,1,dOnly,1000), 5000)
+			lowVal.i = 3;
+			highVal.i = 3;
+			checkPassFail((int) index.countRange(&lowVal, GTE, &highVal, LTE), 500)
 		}
+		File::remove(coveringIndexName);
+	}
 
-		file1 = new PageFile(relationName, true);
-		
-		// initialize all of record1.s to keep purify happy
-		memset(record1.s, ' ', sizeof(record1.s));
-		PageId new_page_number;
-		Page new_page = file1->allocatePage(new_page_number);
+	deleteRelation();
+}
 
-		// Insert a bunch of tuples into the relation.
-		for(int i = 0; i <10; i++ ) 
-		{
-		  sprintf(record1.s, "%05d string record", i);
-		  record1.i = i;
-		  record1.d = (double)i;
-		  std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
+int coveringScan(BTreeIndex * index, const RECORD &lowVal, const RECORD &highVal, int numAttrs, const std::vector<KeyAttr> &includeAttrs, size_t batchSize, ScanDirection direction)
+{
+	std::cout << (direction == BACKWARD ? "Backward index-only scan" : "Index-only scan") << " in batches of " << batchSize << std::endl;
 
-			while(1)
-			{
-				try
-				{
-		  		new_page.insertRecord(new_data);
-					break;
+	const int payloadSize = index->getPayloadSize();
+	std::vector<RecordId> rids(batchSize);
+	std::vector<unsigned char> payloads(batchSize * payloadSize);
+	std::vector<unsigned char> expected(payloadSize);
+	Page *curPage;
+	int numResults = 0;
+
+	try
+	{
+		index->startPrefixScan(&lowVal, GTE, &highVal, LTE, numAttrs, direction);
+	}
+	catch(const NoSuchKeyFoundException &e)
+	{
+		std::cout << "No Key Found satisfying the scan criteria." << std::endl;
+		return 0;
+	}
+
+	size_t n;
+	while((n = index->scanNextBatch(&rids[0], &payloads[0], batchSize)) > 0)
+	{
+		// the included attributes must be those of the record, laid out one after the other
+		for(size_t r = 0; r < n; r++)
+		{
+			bufMgr->readPage(file1, rids[r].page_number, curPage);
+			std::string recordStr = curPage->getRecord(rids[r]);
+			bufMgr->unPinPage(file1, rids[r].page_number, false);
+
+			int width = 0;
+			for(size_t a = 0; a < includeAttrs.size(); a++)
+			{
+				const char *value = recordStr.c_str() + includeAttrs[a].attrByteOffset;
+				int attrWidth = includeAttrs[a].attrType == INTEGER ? (int) sizeof(int) : includeAttrs[a].attrType == DOUBLE ? (int) sizeof(double) : STRINGSIZE;
+				if(includeAttrs[a].attrType == STRING)
+					strncpy((char *) &expected[width], value, attrWidth);
+				else
+					memcpy(&expected[width], value, attrWidth);
+				width += attrWidth;
+			}
+			if(memcmp(&expected[0], &payloads[r * payloadSize], payloadSize) != 0)
+			{
+				std::cout << "Included attributes do not match record " << rids[r].page_number << "," << rids[r].slot_number << std::endl;
+				index->endScan();
+				return -1;
+			}
+		}
+		numResults += n;
+	}
+
+	std::cout << "Number of results: " << numResults << std::endl;
+	index->endScan();
+	std::cout << std::endl;
+
+	return numResults;
+}
+
+void test13()
+{
+	// Keep the relation in a clustered index on i: the tuples are bulk built into the leaves from the heap file, then
+	// 3000 more are inserted through the index, which splits leaves full of records. Scans and lookups check every tuple
+	// they return against the values its key was created with
+	std::cout << "--------------------" << std::endl;
+	std::cout << "clusteredTables" << std::endl;
+	createRelationRandom(relationSize);
+	std::string clusteredIndexName;
+
+	{
+		BTreeIndex index(relationName, clusteredIndexName, bufMgr, offsetof(tuple,i), INTEGER, CLUSTERED, sizeof(RECORD));
+		checkPassFail(index.getRecordSize(), (int) sizeof(RECORD))
+		checkPassFail(clusteredScan(&index,25,GT,40,LT,7), 14)
+		checkPassFail(clusteredScan(&index,0,GTE,relationSize - 1,LTE,100), relationSize)
+		checkPassFail(clusteredScan(&index,1000,GTE,1999,LTE,1), 1000)
+		checkPassFail(clusteredScan(&index,1000,GTE,1999,LTE,33,BACKWARD), 1000)
+		checkPassFail(clusteredLookups(&index,0,relationSize + 10), relationSize)
+		checkPassFail(intCountRange(&index,3000,GTE,3999,LTE), 1000)
+
+		// keys in scrambled order land all over the key range above the bulk built tuples
+		for(int k = 0; k < 3000; k++)
+		{
+			RECORD record;
+			memset(&record, 0, sizeof(RECORD));
+			record.i = relationSize + (k * 7919) % 3000;
+			record.d = record.i;
+			sprintf(record.s, "%05d string record", record.i);
+			index.insertRecord(&record);
+		}
+		checkPassFail(clusteredScan(&index,0,GTE,relationSize + 2999,LTE,500), relationSize + 3000)
+		checkPassFail(clusteredScan(&index,relationSize - 100,GT,relationSize + 100,LT,64,BACKWARD), 199)
+		checkPassFail(clusteredLookups(&index,relationSize - 50,relationSize + 3050), 3050)
+		checkPassFail(intCountRange(&index,0,GTE,relationSize + 2999,LTE), relationSize + 3000)
+	}
+
+	// the index file holds the tuples, reopening it needs no heap file scan
+	{
+		BTreeIndex index(relationName, clusteredIndexName, bufMgr, offsetof(tuple,i), INTEGER, CLUSTERED, sizeof(RECORD));
+		checkPassFail(clusteredScan(&index,relationSize,GTE,relationSize + 2999,LTE,1000), 3000)
+	}
+	File::remove(clusteredIndexName);
+
+	// on a pool too small for the relation, the bulk build reads the heap file once instead of a page for every tuple in key order
+	{
+		BufMgr * savedBufMgr = bufMgr;
+		bufMgr = new BufMgr(20);
+		{
+			BTreeIndex index(relationName, clusteredIndexName, bufMgr, offsetof(tuple,i), INTEGER, CLUSTERED, sizeof(RECORD));
+			checkPassFail((bufMgr->getBufStats().diskreads < relationSize / 4), true)
+			checkPassFail(clusteredScan(&index,0,GTE,relationSize - 1,LTE,100), relationSize)
+		}
+		File::remove(clusteredIndexName);
+		delete bufMgr;
+		bufMgr = savedBufMgr;
+	}
+
+	deleteRelation();
+}
+
+int clusteredScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize, ScanDirection direction)
+{
+	std::cout << (direction == BACKWARD ? "Backward clustered scan" : "Clustered scan") << " in batches of " << batchSize << std::endl;
+
+	std::vector<RECORD> records(batchSize);
+	char expected[64];
+	int numResults = 0;
+	int prevKey = 0;
+
+	try
+	{
+		index->startScan(&lowVal, lowOp, &highVal, highOp, direction);
+	}
+	catch(const NoSuchKeyFoundException &e)
+	{
+		std::cout << "No Key Found satisfying the scan criteria." << std::endl;
+		return 0;
+	}
+
+	size_t n;
+	while((n = index->scanNextRecordBatch(&records[0], batchSize)) > 0)
+	{
+		// every key of the relation is unique, so the keys must strictly increase, or decrease backward, and each tuple be whole
+		for(size_t r = 0; r < n; r++)
+		{
+			const RECORD &record = records[r];
+			sprintf(expected, "%05d string record", record.i);
+			bool ordered = numResults + (int) r == 0 || (direction == BACKWARD ? record.i < prevKey : record.i > prevKey);
+			if(!ordered || record.d != (double) record.i || strcmp(record.s, expected) != 0)
+			{
+				std::cout << "Record out of order or damaged at key " << record.i << std::endl;
+				index->endScan();
+				return -1;
+			}
+			prevKey = record.i;
+		}
+		numResults += n;
+	}
+
+	std::cout << "Number of results: " << numResults << std::endl;
+	index->endScan();
+	std::cout << std::endl;
+
+	return numResults;
+}
+
+// looks up every key in [lowVal, highVal) in a clustered index and returns the number found with the right tuple
+int clusteredLookups(BTreeIndex * index, int lowVal, int highVal)
+{
+	RECORD record;
+	char expected[64];
+	int numFound = 0;
+	for(int key = lowVal; key < highVal; key++)
+	{
+		if(!index->lookupRecord(&key, &record))
+			continue;
+		sprintf(expected, "%05d string record", key);
+		if(record.i == key && record.d == (double) key && strcmp(record.s, expected) == 0)
+			numFound++;
+	}
+	std::cout << "Clustered lookups found: " << numFound << std::endl;
+	return numFound;
+}
+
+void test14()
+{
+	// Index the relation of test11 on (i, d) and scan ranges of d alone. Each of the 10 values of i is a group of the
+	// skip scan, a range of d only hits some of the groups, the others are skipped over. The records returned must be
+	// in key order and in the range of d
+	std::cout << "--------------------" << std::endl;
+	std::cout << "skipScans" << std::endl;
+	createRelationGroups(relationSize, 10);
+
+	std::vector<KeyAttr> keyAttrs(2);
+	keyAttrs[0].attrByteOffset = offsetof(tuple,i);
+	keyAttrs[0].attrType = INTEGER;
+	keyAttrs[1].attrByteOffset = offsetof(tuple,d);
+	keyAttrs[1].attrType = DOUBLE;
+	std::vector<KeyAttr> sOnly(1);
+	sOnly[0].attrByteOffset = offsetof(tuple,s);
+	sOnly[0].attrType = STRING;
+	std::string skipIndexName;
+
+	for(int bulkLoadMode = 1; bulkLoadMode >= 0; bulkLoadMode--)
+	{
+		{
+			BTreeIndex index(relationName, skipIndexName, bufMgr, keyAttrs, bulkLoadMode);
+			checkPassFail(skipScan(&index,1000,GTE,1999,LTE,100), 1000)
+			checkPassFail(skipScan(&index,1000,GT,1010,LT,1), 9)
+			checkPassFail(skipScan(&index,1003,GTE,1003,LTE,8), 1)
+			checkPassFail(skipScan(&index,-1,GT,relationSize,LT,333), relationSize)
+			checkPassFail(skipScan(&index,2500,GTE,2549,LTE,7,BACKWARD), 50)
+			checkPassFail(skipScan(&index,relationSize,GTE,relationSize + 10,LTE,10), 0)
+		}
+		File::remove(skipIndexName);
+
+		// a covering index takes the same scans, a single entry at a time
+		{
+			BTreeIndex index(relationName, skipIndexName, bufMgr, keyAttrs, sOnly, bulkLoadMode);
+			checkPassFail(skipScan(&index,4000,GTE,4099,LT,1), 99)
+			checkPassFail(skipScan(&index,0,GTE,9,LTE,1,BACKWARD), 10)
+		}
+		File::remove(skipIndexName);
+	}
+
+	deleteRelation();
+}
+
+int skipScan(BTreeIndex * index, double lowD, Operator lowOp, double highD, Operator highOp, size_t batchSize, ScanDirection direction)
+{
+	Page *curPage;
+
+	std::cout << (direction == BACKWARD ? "Backward skip scan for " : "Skip scan for ");
+	if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
+	std::cout << lowD << "," << highD;
+	if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
+	std::cout << " in batches of " << batchSize << std::endl;
+
+	RECORD lowVal, highVal;
+	lowVal.i = 0;
+	lowVal.d = lowD;
+	highVal.i = 0;
+	highVal.d = highD;
+
+	std::vector<RecordId> rids(batchSize);
+	int numResults = 0;
+	int prevI = 0;
+	double prevD = 0;
+
+	try
+	{
+		index->startSkipScan(&lowVal, lowOp, &highVal, highOp, direction);
+	}
+	catch(const NoSuchKeyFoundException &e)
+	{
+		std::cout << "No Key Found satisfying the scan criteria." << std::endl;
+		return 0;
+	}
+
+	size_t n;
+	while((n = index->scanNextBatch(&rids[0], batchSize)) > 0)
+	{
+		for(size_t r = 0; r < n; r++)
+		{
+			bufMgr->readPage(file1, rids[r].page_number, curPage);
+			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(rids[r]).data()));
+			bufMgr->unPinPage(file1, rids[r].page_number, false);
+
+			// the keys are distinct, ordered by i and then by d, and d must be in the range of the scan
+			bool after = myRec.i != prevI ? myRec.i > prevI : myRec.d > prevD;
+			bool inRange = (lowOp == GTE ? myRec.d >= lowD : myRec.d > lowD) && (highOp == LTE ? myRec.d <= highD : myRec.d < highD);
+			if( !inRange || (numResults + r > 0 && (direction == BACKWARD ? after : !after)) )
+			{
+				std::cout << "Out of order or out of range: " << myRec.i << ":" << myRec.d << " after " << prevI << ":" << prevD << std::endl;
+				index->endScan();
+				return -1;
+			}
+			prevI = myRec.i;
+			prevD = myRec.d;
+		}
+		numResults += n;
+	}
+
+	std::cout << "Number of results: " << numResults << std::endl;
+	index->endScan();
+	std::cout << std::endl;
+
+	return numResults;
+}
+
+// builds the integer index by inserting every entry with the split policy, checks it and returns the number of pages of the index file
+int intIndexPages(SplitPolicy splitPolicy, float fillFactor)
+{
+	{
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, false, fillFactor, splitPolicy);
+		if (intScan(&index,0,GTE,50000,LT) != 50000 || intScan(&index,25,GT,40,LT) != 14)
+			return -1;
+	}
+
+	// the nodes overwrite the page headers the file iterator follows, so count the pages from the size of the file
+	std::ifstream indexFile(intIndexName.c_str(), std::ios::binary | std::ios::ate);
+	int numPages = (int) (indexFile.tellg() / Page::SIZE);
+	indexFile.close();
+	File::remove(intIndexName);
+	return numPages;
+}
+
+// inserts every step-th entry, starting at first, into the index
+void insertEntries(BTreeIndex *index, const std::vector< std::pair<double, RecordId> > *entries, int first, int step)
+{
+	for(size_t i = first; i < entries->size(); i += step)
+		index->insertEntry(&(*entries)[i].first, (*entries)[i].second);
+}
+
+// orders entries by key alone, record ids do not compare
+bool entryKeyLess(const std::pair<double, RecordId> &a, const std::pair<double, RecordId> &b)
+{
+	return a.first < b.first;
+}
+
+// inserts every step-th batch of batchSize entries, starting at batch first, into the index
+void insertEntryBatches(BTreeIndex *index, const std::vector< std::pair<double, RecordId> > *entries, int first, int step, int batchSize)
+{
+	std::vector<const void*> keys;
+	std::vector<RecordId> rids;
+	for(size_t b = first * batchSize; b < entries->size(); b += step * batchSize)
+	{
+		keys.clear();
+		rids.clear();
+		for(size_t i = b; i < b + batchSize && i < entries->size(); i++)
+		{
+			keys.push_back(&(*entries)[i].first);
+			rids.push_back((*entries)[i].second);
+		}
+		index->insertBatch(&keys[0], &rids[0], keys.size());
+	}
+}
+
+void lookupEntries(BTreeIndex *index, const std::vector< std::pair<double, RecordId> > *entries, int first, int step, int *found)
+{
+	ScanCursor cursor(index);
+	RecordId scanRid;
+	for(size_t i = first; i < entries->size(); i += step)
+	{
+		cursor.startScan(&(*entries)[i].first, GTE, &(*entries)[i].first, LTE);
+		cursor.scanNext(scanRid);
+		if(scanRid == (*entries)[i].second)
+			(*found)++;
+		cursor.endScan();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// indexTests
+// -----------------------------------------------------------------------------
+
+void indexTests(int isLarge)
+{
+  // build the index with the bulk loader, then again by inserting one entry at a time
+  intTests(isLarge, true);
+	try
+	{
+		File::remove(intIndexName);
+	}
+  catch(const FileNotFoundException &e)
+  {
+  }
+
+  intTests(isLarge, false);
+
+  // open the index file left behind by the previous index instead of building a new one
+  {
+    std::cout << "Open the existing B+ Tree index on the integer field" << std::endl;
+    BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+    checkPassFail(intScan(&index,25,GT,40,LT), 14)
+    checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+  }
+	try
+	{
+		File::remove(intIndexName);
+	}
+  catch(const FileNotFoundException &e)
+  {
+  }
+
+  doubleTests(isLarge);
+	try
+	{
+		File::remove(doubleIndexName);
+	}
+  catch(const FileNotFoundException &e)
+  {
+  }
+
+  // string keys are the first STRINGSIZE characters of "%05d string record", which only sort like the integers below 100000
+  if (isLarge == 0) {
+    stringTests();
+    try
+    {
+      File::remove(stringIndexName);
+    }
+    catch(const FileNotFoundException &e)
+    {
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// intTests
+// -----------------------------------------------------------------------------
+
+void intTests(int isLarge, bool bulkLoadMode)
+{
+  std::cout << "Create a B+ Tree index on the integer field";
+  std::cout << (bulkLoadMode ? " with the bulk loader" : " by inserting entries") << std::endl;
+  BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, bulkLoadMode);
+
+	// run some tests
+	checkPassFail(intScan(&index,25,GT,40,LT), 14)
+	checkPassFail(intScan(&index,20,GTE,35,LTE), 16)
+	checkPassFail(intScan(&index,-3,GT,3,LT), 3)
+	checkPassFail(intScan(&index,996,GT,1001,LT), 4)
+	checkPassFail(intScan(&index,0,GT,1,LT), 0)
+	checkPassFail(intScan(&index,300,GT,400,LT), 99)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+        // add some extra tests to test edge cases
+        checkPassFail(intScan(&index,0,GTE,5000,LT), 5000)
+        checkPassFail(intScan(&index,-100,GTE,0,LTE), 1)
+        // batched scans, with batches that end inside and at the end of leaves
+        checkPassFail(intScanBatch(&index,25,GT,40,LT,4), 14)
+        checkPassFail(intScanBatch(&index,20,GTE,35,LTE,16), 16)
+        checkPassFail(intScanBatch(&index,0,GTE,5000,LT,1), 5000)
+        checkPassFail(intScanBatch(&index,0,GTE,5000,LT,1000), 5000)
+        checkPassFail(intScanBatch(&index,0,GT,1,LT,10), 0)
+        // two cursors interleaved with each other and with scans of the index
+        checkPassFail(intScanInterleaved(&index,25,40,3000,4000), 1015)
+        checkPassFail(intScanInterleaved(&index,0,5000,0,5000), 10000)
+        // backward scans, one entry at a time and in batches, and the largest 10 keys of a range
+        checkPassFail(intScanBackward(&index,25,GT,40,LT,1,100), 14)
+        checkPassFail(intScanBackward(&index,20,GTE,35,LTE,4,100), 16)
+        checkPassFail(intScanBackward(&index,0,GT,1,LT,1,100), 0)
+        checkPassFail(intScanBackward(&index,-100,GTE,0,LTE,1,100), 1)
+        checkPassFail(intScanBackward(&index,0,GTE,5000,LT,1000,10000), 5000)
+        checkPassFail(intScanBackward(&index,3000,GTE,4000,LT,1,10), 10)
+        // point lookups, with misses below the smallest key
+        checkPassFail(intLookups(&index,-10,10), 10)
+        // batched lookups in random order, every third key from below the smallest one
+        checkPassFail(intLookupBatch(&index,-100,5000,3,false), 1666)
+        checkPassFail(intLookupBatch(&index,-100,5000,3,true), 1666)
+        // range counts from the subtree counts, which must agree with the scans
+        checkPassFail(intCountRange(&index,25,GT,40,LT), 14)
+        checkPassFail(intCountRange(&index,20,GTE,35,LTE), 16)
+        checkPassFail(intCountRange(&index,0,GT,1,LT), 0)
+        checkPassFail(intCountRange(&index,-100,GTE,0,LTE), 1)
+        checkPassFail(intCountRange(&index,3000,GTE,4000,LT), 1000)
+        // rank and select of every 7th key, from below the smallest one
+        checkPassFail(intRanks(&index,-70,5000,7), 725)
+        // test out of bound cases for relation of size 5000
+        if (isLarge == 0){
+            checkPassFail(intScan(&index,0,GTE,5000,LTE), 5000)
+            checkPassFail(intScan(&index,4999,GTE,6000,LT), 1)
+            checkPassFail(intScan(&index,4000,GT,7000,LT), 999)
+            checkPassFail(intLookups(&index,4990,5010), 10)
+            checkPassFail(intLookupBatch(&index,4000,6000,1,false), 1000)
+            checkPassFail(intLookupBatch(&index,4000,6000,1,true), 1000)
+            checkPassFail(intCountRange(&index,4000,GT,7000,LT), 999)
+            checkPassFail(intScanBackward(&index,4000,GT,7000,LT,64,10000), 999)
+        }
+        // extra tests for large relations
+        if (isLarge == 1){
+            checkPassFail(intScan(&index,30000,GTE,40000,LTE), 10001)
+	    checkPassFail(intScan(&index,12345,GTE,12346,LT), 1)
+	    checkPassFail(intScan(&index,25000,GTE,26000,LT), 1000)
+	    checkPassFail(intScan(&index,209000,GTE,210000,LT), 1000)
+	    checkPassFail(intScan(&index,159000,GTE,160000,LT), 1000)
+            checkPassFail(intScan(&index,290000,GTE,300000,LT), 10000)
+            checkPassFail(intLookups(&index,299990,300010), 10)
+            checkPassFail(intLookupBatch(&index,0,300100,1,false), 300000)
+            checkPassFail(intLookupBatch(&index,0,300100,1,true), 300000)
+            checkPassFail(intCountRange(&index,30000,GTE,40000,LTE), 10001)
+            checkPassFail(intCountRange(&index,0,GTE,300000,LT), 300000)
+            checkPassFail(intScanBackward(&index,0,GTE,300000,LT,1000,300000), 300000)
+            checkPassFail(intRanks(&index,0,300000,97), 3093)
+        }
+        // more entries than fit in a leaf for one key, last since it changes the index
+        checkPassFail(intLookupDuplicates(&index,2500,1000), 1001)
+        checkPassFail(intCountRange(&index,2500,GTE,2500,LTE), 1001)
+        checkPassFail(intCountRange(&index,2499,GT,2501,LT), 1001)
+        checkPassFail(intPostings(&index,2500,5000), 6001)
+        // a posting list longer than its leaf entry counts
+        checkPassFail(intPostings(&index,2501,35000), 35001)
+        checkPassFail(intCountRange(&index,2500,GTE,2501,LTE), 41002)
+        // inserts into the middle of the posting list between batches of a scan of it
+        checkPassFail(intPostingInserts(&index,2501,100,20), 35001)
+        // inserts among the entries of a key between batches of a scan of them, until they are packed into a posting list
+        checkPassFail(intScanInserts(&index,2502,12,2,5), 13)
+}
+
+int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+  RecordId scanRid;
+	Page *curPage;
+
+  std::cout << "Scan for ";
+  if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
+  std::cout << lowVal << "," << highVal;
+  if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
+  std::cout << std::endl;
+
+  int numResults = 0;
+	
+	try
+	{
+  	index->startScan(&lowVal, lowOp, &highVal, highOp);
+	}
+	catch(const NoSuchKeyFoundException &e)
+	{
+    std::cout << "No Key Found satisfying the scan criteria." << std::endl;
+		return 0;
+	}
+
+	while(1)
+	{
+		try
+		{
+			index->scanNext(scanRid);
+			bufMgr->readPage(file1, scanRid.page_number, curPage);
+			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+			bufMgr->unPinPage(file1, scanRid.page_number, false);
+
+			if( numResults < 5 )
+			{
+				std::cout << "at:" << scanRid.page_number << "," << scanRid.slot_number;
+				std::cout << " -->:" << myRec.i << ":" << myRec.d << ":" << myRec.s << ":" <<std::endl;
+			}
+			else if( numResults == 5 )
+			{
+				std::cout << "..." << std::endl;
+			}
+		}
+		catch(const IndexScanCompletedException &e)
+		{
+			break;
+		}
+
+		numResults++;
+	}
+
+  if( numResults >= 5 )
+  {
+    std::cout << "Number of results: " << numResults << std::endl;
+  }
+  index->endScan();
+  std::cout << std::endl;
+
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// intScanBatch
+// -----------------------------------------------------------------------------
+
+int intScanBatch(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize)
+{
+  std::cout << "Batched scan of " << batchSize << " for ";
+  if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
+  std::cout << lowVal << "," << highVal;
+  if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
+  std::cout << std::endl;
+
+	try
+	{
+  	index->startScan(&lowVal, lowOp, &highVal, highOp);
+	}
+	catch(const NoSuchKeyFoundException &e)
+	{
+    std::cout << "No Key Found satisfying the scan criteria." << std::endl;
+		return 0;
+	}
+
+  // check the keys come back in order, one batch after the other
+  std::vector<RecordId> batch(batchSize);
+  int numResults = 0;
+  int lastKey = lowVal;
+  Page *curPage;
+  size_t found;
+  while((found = index->scanNextBatch(&batch[0], batchSize)) > 0)
+  {
+    for(size_t j = 0; j < found; j++)
+    {
+      bufMgr->readPage(file1, batch[j].page_number, curPage);
+      RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(batch[j]).data()));
+      bufMgr->unPinPage(file1, batch[j].page_number, false);
+      if( myRec.i < lastKey )
+      {
+        std::cout << "Batched scan returned " << myRec.i << " after " << lastKey << std::endl;
+        return -1;
+      }
+      lastKey = myRec.i;
+    }
+    numResults += found;
+  }
+
+  std::cout << "Number of results: " << numResults << std::endl;
+  index->endScan();
+  std::cout << std::endl;
+
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// intLookups
+// -----------------------------------------------------------------------------
+
+int intLookups(BTreeIndex * index, int lowVal, int highVal)
+{
+  std::cout << "Lookups for [" << lowVal << "," << highVal << ")" << std::endl;
+
+  int numResults = 0;
+  Page *curPage;
+  RecordId lookupRid;
+  for(int key = lowVal; key < highVal; key++)
+  {
+    if( !index->lookup(&key, lookupRid) )
+      continue;
+    bufMgr->readPage(file1, lookupRid.page_number, curPage);
+    RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(lookupRid).data()));
+    bufMgr->unPinPage(file1, lookupRid.page_number, false);
+    if( myRec.i != key )
+    {
+      std::cout << "Lookup of " << key << " returned " << myRec.i << std::endl;
+      return -1;
+    }
+    numResults++;
+  }
+  std::cout << "Number of results: " << numResults << std::endl;
+  return numResults;
+}
+
+int intLookupDuplicates(BTreeIndex * index, int key, int numDuplicates)
+{
+  std::cout << "Lookup of " << key << " after inserting " << numDuplicates << " more entries for it" << std::endl;
+
+  RecordId lookupRid;
+  if( !index->lookup(&key, lookupRid) )
+    return -1;
+  for(int i = 0; i < numDuplicates; i++)
+    index->insertEntry(&key, lookupRid);
+
+  std::vector<RecordId> rids(2 * numDuplicates);
+  size_t numResults = index->lookupAll(&key, &rids[0], rids.size());
+  for(size_t i = 0; i < numResults; i++)
+  {
+    if( !(rids[i] == lookupRid) )
+      return -1;
+  }
+  std::cout << "Number of results: " << numResults << std::endl;
+  return (int) numResults;
+}
+
+int intPostings(BTreeIndex * index, int key, int numDuplicates)
+{
+  std::cout << "Scans of " << key << " after inserting " << numDuplicates << " entries with distinct record ids for it" << std::endl;
+
+  // record ids of no real record, in random order. Half are inserted one at a time and half as a batch
+  std::vector<RecordId> newRids(numDuplicates);
+  for(int i = 0; i < numDuplicates; i++)
+  {
+    newRids[i].page_number = 100000 + i / 50;
+    newRids[i].slot_number = i % 50;
+    newRids[i].padding = 0;
+  }
+  for(size_t i = newRids.size(); i > 1; i--)
+    std::swap(newRids[i - 1], newRids[random() % i]);
+  const int half = numDuplicates / 2;
+  for(int i = 0; i < half; i++)
+    index->insertEntry(&key, newRids[i]);
+  std::vector<const void*> keyPtrs(numDuplicates - half, &key);
+  index->insertBatch(&keyPtrs[0], &newRids[half], numDuplicates - half);
+  std::sort(newRids.begin(), newRids.end(), postingLess);
+
+  // a lookup, a forward and a backward scan each return every entry of the key, the new record ids once each
+  const size_t total = index->countRange(&key, GTE, &key, LTE);
+  std::vector<RecordId> rids(total + 1);
+  if( index->lookupAll(&key, &rids[0], rids.size()) != total )
+    return -1;
+  for(int d = 0; d < 2; d++)
+  {
+    index->startScan(&key, GTE, &key, LTE, d == 0 ? FORWARD : BACKWARD);
+    size_t numResults = 0;
+    size_t n;
+    while( numResults < rids.size() && (n = index->scanNextBatch(&rids[numResults], std::min((size_t) 7, rids.size() - numResults))) > 0 )
+      numResults += n;
+    index->endScan();
+    if( numResults != total )
+      return -1;
+    rids.resize(numResults);
+    std::sort(rids.begin(), rids.end(), postingLess);
+    for(int i = 0; i < numDuplicates; i++)
+    {
+      std::pair<std::vector<RecordId>::iterator, std::vector<RecordId>::iterator> found =
+        std::equal_range(rids.begin(), rids.end(), newRids[i], postingLess);
+      if( found.second - found.first != 1 )
+        return -1;
+    }
+    rids.resize(total + 1);
+  }
+  std::cout << "Number of results: " << total << std::endl;
+  return (int) total;
+}
+
+int intPostingInserts(BTreeIndex * index, int key, int batchSize, int insertsPerBatch)
+{
+  std::cout << "Scans of " << key << " inserting " << insertsPerBatch << " entries for it after every " << batchSize << " returned" << std::endl;
+
+  // a forward scan gets record ids sorting before the ones it returned, a backward scan ones sorting after, so the
+  // inserts shift the rest of the list and split its pages without being returned themselves
+  int newPageNo[2] = {90000, 900000};
+  int found = 0;
+  for(int d = 0; d < 2; d++)
+  {
+    const size_t total = index->countRange(&key, GTE, &key, LTE);
+    std::vector<RecordId> before(total + 1);
+    if( index->lookupAll(&key, &before[0], before.size()) != total )
+      return -1;
+    before.resize(total);
+    std::sort(before.begin(), before.end(), postingLess);
+
+    std::vector<RecordId> rids;
+    std::vector<RecordId> batch(batchSize);
+    index->startScan(&key, GTE, &key, LTE, d == 0 ? FORWARD : BACKWARD);
+    size_t n;
+    while( rids.size() <= total && (n = index->scanNextBatch(&batch[0], batchSize)) > 0 )
+    {
+      rids.insert(rids.end(), batch.begin(), batch.begin() + n);
+      for(int i = 0; i < insertsPerBatch; i++)
+      {
+        RecordId rid;
+        rid.page_number = d == 0 ? newPageNo[d]++ : newPageNo[d]--;
+        rid.slot_number = 0;
+        rid.padding = 0;
+        index->insertEntry(&key, rid);
+      }
+    }
+    index->endScan();
+
+    // every entry there before the scan is returned once, and nothing else
+    if( rids.size() != total )
+      return -1;
+    std::sort(rids.begin(), rids.end(), postingLess);
+    for(size_t i = 0; i < total; i++)
+    {
+      if( !(rids[i] == before[i]) )
+        return -1;
+    }
+    if( d == 0 )
+      found = (int) rids.size();
+  }
+  std::cout << "Number of results: " << found << std::endl;
+  return found;
+}
+
+int intScanInserts(BTreeIndex * index, int key, int numDuplicates, int batchSize, int insertsPerBatch)
+{
+  std::cout << "Scans of " << key << " with " << numDuplicates << " more entries, inserting " << insertsPerBatch << " entries for it and smaller keys after every " << batchSize << " returned" << std::endl;
+
+  // record ids of no real record in random order, distinct since the low digits count them
+  int numNew = 0;
+  for(int i = 0; i < numDuplicates; i++)
+  {
+    RecordId rid;
+    rid.page_number = (random() % 100000) * 1000 + numNew++;
+    rid.slot_number = 0;
+    rid.padding = 0;
+    index->insertEntry(&key, rid);
+  }
+
+  int found = 0;
+  for(int d = 0; d < 2; d++)
+  {
+    const size_t total = index->countRange(&key, GTE, &key, LTE);
+    std::vector<RecordId> before(total + 1);
+    if( index->lookupAll(&key, &before[0], before.size()) != total )
+      return -1;
+    before.resize(total);
+    std::sort(before.begin(), before.end(), postingLess);
+
+    // one new entry of the key goes before or after the next entry of the scan, and entries of smaller keys shift them
+    // all until the leaf is full and the entries of the key are packed into a posting list
+    std::vector<RecordId> rids;
+    std::vector<RecordId> batch(batchSize);
+    index->startScan(&key, GTE, &key, LTE, d == 0 ? FORWARD : BACKWARD);
+    size_t n;
+    while( rids.size() <= 20 * total && (n = index->scanNextBatch(&batch[0], batchSize)) > 0 )
+    {
+      rids.insert(rids.end(), batch.begin(), batch.begin() + n);
+      for(int i = 0; i < insertsPerBatch; i++)
+      {
+        RecordId rid;
+        rid.page_number = (random() % 100000) * 1000 + numNew++;
+        rid.slot_number = 0;
+        rid.padding = 0;
+        const int lowerKey = key - 3 - numNew % 100;
+        index->insertEntry(i == 0 ? &key : &lowerKey, rid);
+      }
+    }
+    index->endScan();
+
+    // no entry is returned twice, and every entry there before the scan is returned
+    std::sort(rids.begin(), rids.end(), postingLess);
+    if( std::adjacent_find(rids.begin(), rids.end()) != rids.end() )
+      return -1;
+    for(size_t i = 0; i < total; i++)
+    {
+      if( !std::binary_search(rids.begin(), rids.end(), before[i], postingLess) )
+        return -1;
+    }
+    if( d == 0 )
+      found = (int) total;
+  }
+  std::cout << "Number of results: " << found << std::endl;
+  return found;
+}
+
+int intLookupBatch(BTreeIndex * index, int lowVal, int highVal, int step, bool interleaved)
+{
+  std::cout << (interleaved ? "Interleaved" : "Batched") << " lookups for every " << step << " keys of [" << lowVal << "," << highVal << ")" << std::endl;
+
+  std::vector<int> keys;
+  for(int key = lowVal; key < highVal; key += step)
+    keys.push_back(key);
+  // probe in random order, the index sorts the keys itself
+  for(size_t i = keys.size(); i > 1; i--)
+    std::swap(keys[i - 1], keys[random() % i]);
+
+  const size_t n = keys.size();
+  std::vector<const void*> keyPtrs(n);
+  for(size_t i = 0; i < n; i++)
+    keyPtrs[i] = &keys[i];
+  std::vector<RecordId> rids(n);
+  bool *found = new bool[n];
+  int numResults = (int) (interleaved ? index->lookupInterleaved(&keyPtrs[0], n, &rids[0], found)
+                                      : index->lookupBatch(&keyPtrs[0], n, &rids[0], found));
+
+  Page *curPage;
+  for(size_t i = 0; i < n; i++)
+  {
+    if( !found[i] )
+      continue;
+    bufMgr->readPage(file1, rids[i].page_number, curPage);
+    RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(rids[i]).data()));
+    bufMgr->unPinPage(file1, rids[i].page_number, false);
+    if( myRec.i != keys[i] )
+    {
+      std::cout << "Lookup of " << keys[i] << " returned " << myRec.i << std::endl;
+      numResults = -1;
+      break;
+    }
+  }
+  delete [] found;
+  std::cout << "Number of results: " << numResults << std::endl;
+  return numResults;
+}
+
+// scans backward and checks that the keys come in descending order within the range, stopping after limit entries
+int intScanBackward(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize, int limit)
+{
+  std::cout << "Backward scan in batches of " << batchSize << " for ";
+  if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
+  std::cout << lowVal << "," << highVal;
+  if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
+  std::cout << ", first " << limit << std::endl;
+
+  try
+  {
+    index->startScan(&lowVal, lowOp, &highVal, highOp, BACKWARD);
+  }
+  catch(const NoSuchKeyFoundException &e)
+  {
+    std::cout << "No Key Found satisfying the scan criteria." << std::endl;
+    return 0;
+  }
+
+  int numResults = 0;
+  int prevKey = 0;
+  std::vector<RecordId> rids(batchSize);
+  Page *curPage;
+  while( numResults < limit )
+  {
+    size_t n;
+    if( batchSize == 1 )
+    {
+      try
+      {
+        index->scanNext(rids[0]);
+        n = 1;
+      }
+      catch(const IndexScanCompletedException &e)
+      {
+        n = 0;
+      }
+    }
+    else
+      n = index->scanNextBatch(&rids[0], std::min(batchSize, (size_t) (limit - numResults)));
+    if( n == 0 )
+      break;
+
+    for(size_t i = 0; i < n; i++)
+    {
+      bufMgr->readPage(file1, rids[i].page_number, curPage);
+      RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(rids[i]).data()));
+      bufMgr->unPinPage(file1, rids[i].page_number, false);
+      if( myRec.i > highVal || (myRec.i == highVal && highOp == LT) || myRec.i < lowVal || (myRec.i == lowVal && lowOp == GT) ||
+          (numResults > 0 && myRec.i >= prevKey) )
+      {
+        std::cout << "Out of order or range: " << myRec.i << " after " << prevKey << std::endl;
+        index->endScan();
+        return -1;
+      }
+      prevKey = myRec.i;
+      numResults++;
+    }
+  }
+  index->endScan();
+  std::cout << "Number of results: " << numResults << std::endl;
+  return numResults;
+}
+
+int intCountRange(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+  std::cout << "Count range (" << lowVal << "," << lowOp << "," << highVal << "," << highOp << ")" << std::endl;
+
+  int numResults = (int) index->countRange(&lowVal, lowOp, &highVal, highOp);
+  std::cout << "Number of results: " << numResults << std::endl;
+  return numResults;
+}
+
+int intRanks(BTreeIndex * index, int lowVal, int highVal, int step)
+{
+  std::cout << "Rank and select for every " << step << " keys of [" << lowVal << "," << highVal << ")" << std::endl;
+
+  // the keys of the relation are 0 to n-1, so the entry of a key is at the position of its rank
+  int numResults = 0;
+  Page *curPage;
+  RecordId selectRid;
+  for(int key = lowVal; key < highVal; key += step)
+  {
+    int expected = std::max(key, 0);
+    if( (int) index->rank(&key) != expected )
+    {
+      std::cout << "Rank of " << key << " returned " << index->rank(&key) << std::endl;
+      return -1;
+    }
+    if( !index->select(expected, selectRid) )
+      return -1;
+    bufMgr->readPage(file1, selectRid.page_number, curPage);
+    RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(selectRid).data()));
+    bufMgr->unPinPage(file1, selectRid.page_number, false);
+    if( myRec.i != expected )
+    {
+      std::cout << "Select of " << expected << " returned " << myRec.i << std::endl;
+      return -1;
+    }
+    numResults++;
+  }
+  std::cout << "Number of results: " << numResults << std::endl;
+  return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// intScanInterleaved
+// -----------------------------------------------------------------------------
+
+int intScanInterleaved(BTreeIndex * index, int lowVal1, int highVal1, int lowVal2, int highVal2)
+{
+  std::cout << "Interleaved scans for [" << lowVal1 << "," << highVal1 << ") and [";
+  std::cout << lowVal2 << "," << highVal2 << ")" << std::endl;
+
+  ScanCursor cursor1(index);
+  ScanCursor cursor2(index);
+  cursor1.startScan(&lowVal1, GTE, &highVal1, LT);
+  cursor2.startScan(&lowVal2, GTE, &highVal2, LT);
+
+  // take turns between the cursors, and restart the scan of the index in between, which must not disturb them
+  ScanCursor *cursors[2] = {&cursor1, &cursor2};
+  int lastKey[2] = {lowVal1 - 1, lowVal2 - 1};
+  bool done[2] = {false, false};
+  int numResults = 0;
+  Page *curPage;
+  RecordId scanRid;
+  while( !done[0] || !done[1] )
+  {
+    for(int c = 0; c < 2; c++)
+    {
+      if( done[c] )
+        continue;
+      try
+      {
+        cursors[c]->scanNext(scanRid);
+      }
+      catch(const IndexScanCompletedException &e)
+      {
+        done[c] = true;
+        continue;
+      }
+      bufMgr->readPage(file1, scanRid.page_number, curPage);
+      RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+      bufMgr->unPinPage(file1, scanRid.page_number, false);
+      if( myRec.i != lastKey[c] + 1 )
+      {
+        std::cout << "Cursor " << c << " returned " << myRec.i << " after " << lastKey[c] << std::endl;
+        return -1;
+      }
+      lastKey[c] = myRec.i;
+      numResults++;
+    }
+    int low = lastKey[0];
+    int high = low + 10;
+    index->startScan(&low, GTE, &high, LT);
+  }
+  index->endScan();
+  cursor1.endScan();
+  cursor2.endScan();
+
+  std::cout << "Number of results: " << numResults << std::endl << std::endl;
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// doubleTests
+// -----------------------------------------------------------------------------
+
+void doubleTests(int isLarge)
+{
+  std::cout << "Create a B+ Tree index on the double field" << std::endl;
+  BTreeIndex index(relationName, doubleIndexName, bufMgr, offsetof(tuple,d), DOUBLE);
+
+	// run some tests
+	checkPassFail(doubleScan(&index,25,GT,40,LT), 14)
+	checkPassFail(doubleScan(&index,20,GTE,35,LTE), 16)
+	checkPassFail(doubleScan(&index,-3,GT,3,LT), 3)
+	checkPassFail(doubleScan(&index,996,GT,1001,LT), 4)
+	checkPassFail(doubleScan(&index,0,GT,1,LT), 0)
+	checkPassFail(doubleScan(&index,300,GT,400,LT), 99)
+	checkPassFail(doubleScan(&index,3000,GTE,4000,LT), 1000)
+        // keys between the integers
+        checkPassFail(doubleScan(&index,24.5,GT,40.5,LT), 16)
+        checkPassFail(doubleScan(&index,0.5,GTE,0.9,LTE), 0)
+        if (isLarge == 1){
+            checkPassFail(doubleScan(&index,30000,GTE,40000,LTE), 10001)
+            checkPassFail(doubleScan(&index,290000,GTE,300000,LT), 10000)
+        }
+}
+
+int doubleScan(BTreeIndex * index, double lowVal, Operator lowOp, double highVal, Operator highOp, ScanDirection direction)
+{
+  RecordId scanRid;
+	Page *curPage;
+
+  std::cout << (direction == BACKWARD ? "Backward scan for " : "Scan for ");
+  if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
+  std::cout << lowVal << "," << highVal;
+  if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
+  std::cout << std::endl;
+
+  int numResults = 0;
+  double prevKey = 0;
+
+	try
+	{
+  	index->startScan(&lowVal, lowOp, &highVal, highOp, direction);
+	}
+	catch(const NoSuchKeyFoundException &e)
+	{
+    std::cout << "No Key Found satisfying the scan criteria." << std::endl;
+		return 0;
+	}
+
+	while(1)
+	{
+		try
+		{
+			index->scanNext(scanRid);
+			bufMgr->readPage(file1, scanRid.page_number, curPage);
+			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+			bufMgr->unPinPage(file1, scanRid.page_number, false);
+
+			// the keys are distinct, each one must come strictly after the previous one in the direction of the scan
+			if( numResults > 0 && (direction == BACKWARD ? myRec.d >= prevKey : myRec.d <= prevKey) )
+			{
+				std::cout << "Out of order: " << myRec.d << " after " << prevKey << std::endl;
+				index->endScan();
+				return -1;
+			}
+			prevKey = myRec.d;
+
+			if( numResults < 5 )
+			{
+				std::cout << "rid:" << scanRid.page_number << "," << scanRid.slot_number;
+				std::cout << " -->:" << myRec.i << ":" << myRec.d << ":" << myRec.s << ":" <<std::endl;
+			}
+			else if( numResults == 5 )
+			{
+				std::cout << "..." << std::endl;
+			}
+		}
+		catch(const IndexScanCompletedException &e)
+		{
+			break;
+		}
+
+		numResults++;
+	}
+
+  if( numResults >= 5 )
+  {
+    std::cout << "Number of results: " << numResults << std::endl;
+  }
+  index->endScan();
+  std::cout << std::endl;
+
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// stringTests
+// -----------------------------------------------------------------------------
+
+int doubleCountRange(BTreeIndex * index, double lowVal, Operator lowOp, double highVal, Operator highOp)
+{
+  std::cout << "Count range (" << lowVal << "," << lowOp << "," << highVal << "," << highOp << ")" << std::endl;
+
+  int numResults = (int) index->countRange(&lowVal, lowOp, &highVal, highOp);
+  std::cout << "Number of results: " << numResults << std::endl;
+  return numResults;
+}
+
+void stringTests()
+{
+  std::cout << "Create a B+ Tree index on the string field" << std::endl;
+  BTreeIndex index(relationName, stringIndexName, bufMgr, offsetof(tuple,s), STRING);
+
+	// run some tests
+	checkPassFail(stringScan(&index,25,GT,40,LT), 14)
+	checkPassFail(stringScan(&index,20,GTE,35,LTE), 16)
+	checkPassFail(stringScan(&index,-3,GT,3,LT), 3)
+	checkPassFail(stringScan(&index,996,GT,1001,LT), 4)
+	checkPassFail(stringScan(&index,0,GT,1,LT), 0)
+	checkPassFail(stringScan(&index,300,GT,400,LT), 99)
+	checkPassFail(stringScan(&index,3000,GTE,4000,LT), 1000)
+	checkPassFail(stringPrefixCounts(&index,0,3000), 3000)
+}
+
+int stringPrefixCounts(BTreeIndex * index, int lowVal, int highVal)
+{
+  std::cout << "Counts from the number prefix to the key for every key of [" << lowVal << "," << highVal << ")" << std::endl;
+
+  // separators between leaves are the shortest prefixes that tell the keys apart, here the number prefix
+  int numResults = 0;
+  for(int i = lowVal; i < highVal; i++)
+  {
+    char prefix[100];
+    sprintf(prefix, "%05d", i);
+    char key[100];
+    sprintf(key, "%05d string record", i);
+    RecordId rid;
+    if( index->countRange(prefix, GTE, key, LTE) == 1 && index->countRange(prefix, GT, key, LT) == 0 && index->lookup(key, rid) )
+      numResults++;
+  }
+  std::cout << "Number of results: " << numResults << std::endl;
+  return numResults;
+}
+
+int stringScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+  RecordId scanRid;
+	Page *curPage;
+
+  std::cout << "Scan for ";
+  if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
+  std::cout << lowVal << "," << highVal;
+  if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
+  std::cout << std::endl;
+
+  char lowValStr[100];
+  sprintf(lowValStr,"%05d string record",lowVal);
+  char highValStr[100];
+  sprintf(highValStr,"%05d string record",highVal);
+
+  int numResults = 0;
+
+	try
+	{
+  	index->startScan(lowValStr, lowOp, highValStr, highOp);
+	}
+	catch(const NoSuchKeyFoundException &e)
+	{
+    std::cout << "No Key Found satisfying the scan criteria." << std::endl;
+		return 0;
+	}
+
+	while(1)
+	{
+		try
+		{
+			index->scanNext(scanRid);
+			bufMgr->readPage(file1, scanRid.page_number, curPage);
+			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+			bufMgr->unPinPage(file1, scanRid.page_number, false);
+
+			if( numResults < 5 )
+			{
+				std::cout << "rid:" << scanRid.page_number << "," << scanRid.slot_number;
+				std::cout << " -->:" << myRec.i << ":" << myRec.d << ":" << myRec.s << ":" <<std::endl;
+			}
+			else if( numResults == 5 )
+			{
+				std::cout << "..." << std::endl;
+			}
+		}
+		catch(const IndexScanCompletedException &e)
+		{
+			break;
+		}
+
+		numResults++;
+	}
+
+  if( numResults >= 5 )
+  {
+    std::cout << "Number of results: " << numResults << std::endl;
+  }
+  index->endScan();
+  std::cout << std::endl;
+
+	return numResults;
+}
+
+void test15()
+{
+	// Scan a relation of 50000 tuples through an index on a buffer pool of 40 frames, so the scans queue read-ahead
+	// and the interleaved lookups queue the pages they wait for for the prefetch thread. The index is destroyed and its file removed while a scan's prefetches may still be
+	// queued, and pages queued for the heap file must be dropped by flushFile
+	std::cout << "--------------------" << std::endl;
+	std::cout << "readAheadSmallBufferPool" << std::endl;
+	createRelationForward(50000);
+
+	BufMgr * savedBufMgr = bufMgr;
+	bufMgr = new BufMgr(40);
+	for(int round = 0; round < 3; round++)
+	{
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		checkPassFail(intScanBatch(&index,0,GTE,50000,LT,1000), 50000)
+		// interleaved descents that reach pages not in the pool wait for the prefetch thread to read them
+		checkPassFail(intLookupBatch(&index,0,50000,7,true), 7143)
+
+		// stop a long scan half way, right after it moved to new leaves, and close the index at once
+		int lowVal = 0, highVal = 50000, numResults = 0;
+		size_t n;
+		std::vector<RecordId> rids(500);
+		index.startScan(&lowVal, GTE, &highVal, LT);
+		while(numResults < 25000 && (n = index.scanNextBatch(&rids[0], rids.size())) > 0)
+			numResults += (int) n;
+		index.endScan();
+		checkPassFail(numResults, 25000)
+	}
+	File::remove(intIndexName);
+
+	// the heap file is flushed with its pages queued, none of them may be read after flushFile returned
+	for(PageId pageNo = 1; pageNo <= 10; pageNo++)
+		bufMgr->prefetchPageAsync(file1, pageNo);
+	bufMgr->flushFile(file1);
+	const int diskreads = bufMgr->getBufStats().diskreads;
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	checkPassFail(bufMgr->getBufStats().diskreads - diskreads, 0)
+
+	deleteRelation();
+	delete bufMgr;
+	bufMgr = savedBufMgr;
+}
+
+void test16()
+{
+	// Insert the entries of a relation of 100000 tuples on (i, d) in random order into a composite index over an empty
+	// relation. Composite keys make non-leaf nodes narrow, so the root splits and the parents of leaves split again while
+	// the nodes are cached. The lookups of every entry inserted so far are checked as the tree grows, and scans at the end.
+	// The 24 frame pool caches 3 nodes, of which only 1 may be a parent of leaves, so the other parents are read through
+	// the buffer pool
+	std::cout << "--------------------" << std::endl;
+	std::cout << "nodeCacheSplits" << std::endl;
+	const int numKeys = 100000;
+	createRelationGroups(numKeys, 7);
+
+	std::vector< std::pair<RECORD, RecordId> > entries;
+	{
+		FileScan fscan(relationName, bufMgr);
+		try
+		{
+			RecordId scanRid;
+			while(1)
+			{
+				fscan.scanNext(scanRid);
+				std::string recordStr = fscan.getRecord();
+				entries.push_back(std::make_pair(*reinterpret_cast<const RECORD*>(recordStr.c_str()), scanRid));
+			}
+		}
+		catch(const EndOfFileException &e)
+		{
+		}
+	}
+	for(size_t k = entries.size() - 1; k > 0; k--)
+		std::swap(entries[k], entries[random() % (k + 1)]);
+
+	std::vector<KeyAttr> keyAttrs(2);
+	keyAttrs[0].attrByteOffset = offsetof(tuple,i);
+	keyAttrs[0].attrType = INTEGER;
+	keyAttrs[1].attrByteOffset = offsetof(tuple,d);
+	keyAttrs[1].attrType = DOUBLE;
+
+	const std::string emptyRelationName = "relB";
+	try
+	{
+		File::remove(emptyRelationName);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+	{
+		PageFile emptyFile = PageFile::create(emptyRelationName);
+	}
+
+	BufMgr * savedBufMgr = bufMgr;
+	for(int small = 0; small < 2; small++)
+	{
+		if(small)
+			bufMgr = new BufMgr(24);
+		std::string cacheIndexName;
+		{
+			BTreeIndex index(emptyRelationName, cacheIndexName, bufMgr, keyAttrs, false);
+			const int step = numKeys / 4;
+			for(int first = 0; first < numKeys; first += step)
+			{
+				for(int k = first; k < first + step; k++)
+					index.insertEntry(&entries[k].first, entries[k].second);
+				checkPassFail(compositeLookups(&index, entries, 0, first + step), first + step)
+			}
+			checkPassFail(index.getTreeHeight(), 2)
+			if(small)
+				checkPassFail(index.getNumCachedNodes(), 2)
+			checkPassFail(compositeScan(&index,-5,0,GTE,100,0,LTE,1), numKeys)
+			checkPassFail(compositeScan(&index,3,1000,GTE,3,2000,LT,2), 143)
+			checkPassFail(compositeScan(&index,6,0,GTE,6,0,LTE,1,BACKWARD), numKeys / 7)
+		}
+		File::remove(cacheIndexName);
+		if(small)
+		{
+			delete bufMgr;
+			bufMgr = savedBufMgr;
+		}
+	}
+	File::remove(emptyRelationName);
+	deleteRelation();
+}
+
+void test17()
+{
+	// Insert the entries of the double field of 200000 tuples in random order into an index over an empty relation, half
+	// of them first, then the other half timed: by one inserter into one index, and by four inserters next to a reader that
+	// looks up entries of the first half into another. An insert that does not split latches no node above its leaf, so the
+	// inserters do not queue up on the root and the four together are no slower than the single one beyond the reader's share
+	std::cout << "--------------------" << std::endl;
+	std::cout << "concurrentInsertThroughput" << std::endl;
+	createRelationForward(200000);
+
+	std::vector< std::pair<double, RecordId> > entries;
+	{
+		FileScan fscan(relationName, bufMgr);
+		try
+		{
+			RecordId scanRid;
+			while(1)
+			{
+				fscan.scanNext(scanRid);
+				std::string recordStr = fscan.getRecord();
+				entries.push_back(std::make_pair(reinterpret_cast<const RECORD*>(recordStr.c_str())->d, scanRid));
+			}
+		}
+		catch(const EndOfFileException &e)
+		{
+		}
+	}
+	for(size_t k = entries.size() - 1; k > 0; k--)
+		std::swap(entries[k], entries[random() % (k + 1)]);
+
+	const std::string emptyRelationName = "relB";
+	std::string emptyIndexName;
+	try
+	{
+		File::remove(emptyRelationName);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+	{
+		PageFile emptyFile = PageFile::create(emptyRelationName);
+	}
+
+	double singleSeconds, concurrentSeconds;
+	int found = 0;
+	{
+		BTreeIndex index(emptyRelationName, emptyIndexName, bufMgr, offsetof(tuple,d), DOUBLE, false);
+		singleSeconds = timedInserts(&index, &entries, 1, NULL);
+		checkPassFail(doubleCountRange(&index,0,GTE,200000,LT), 200000)
+	}
+	File::remove(emptyIndexName);
+	{
+		BTreeIndex index(emptyRelationName, emptyIndexName, bufMgr, offsetof(tuple,d), DOUBLE, false);
+		concurrentSeconds = timedInserts(&index, &entries, 4, &found);
+		checkPassFail(found, (int) ((entries.size() + 193) / 194))
+		// the inserts that did not split are counted once the counts are read
+		checkPassFail(doubleCountRange(&index,0,GTE,200000,LT), 200000)
+		checkPassFail(doubleCountRange(&index,159000,GTE,160000,LT), 1000)
+		checkPassFail(doubleScan(&index,159000,GTE,160000,LT), 1000)
+	}
+	File::remove(emptyIndexName);
+
+	std::cout << "Inserts per second, one inserter: " << (int) (entries.size() / 2 / singleSeconds)
+	          << ", four inserters and a reader: " << (int) (entries.size() / 2 / concurrentSeconds) << std::endl;
+	checkPassFail((concurrentSeconds < 2 * singleSeconds), true)
+
+	File::remove(emptyRelationName);
+	deleteRelation();
+}
+
+// inserts the even entries, then times the insertion of the odd ones by numInserters threads,
+// next to a reader that looks up every 194th entry if found is not NULL
+double timedInserts(BTreeIndex *index, const std::vector< std::pair<double, RecordId> > *entries, int numInserters, int *found)
+{
+	insertEntries(index, entries, 0, 2);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for(int t = 0; t < numInserters; t++)
+		threads.push_back(std::thread(insertEntries, index, entries, 2 * t + 1, 2 * numInserters));
+	if(found != NULL)
+		threads.push_back(std::thread(lookupEntries, index, entries, 0, 194, found));
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void test18()
+{
+	// Insert 230000 string keys of four letters into indexes over an empty relation. Neighbouring leaves are told apart by
+	// four characters, so the non-leaf nodes store separators of five bytes instead of ten and hold about 540 children instead
+	// of 454. In increasing order the leaves end up 0.9 full, about 500 of them, which fit under a single root. In random
+	// order the nodes split in the middle and take separators in between their keys
+	std::cout << "--------------------" << std::endl;
+	std::cout << "stringSeparators" << std::endl;
+	const int numKeys = 230000;
+	std::vector<int> order(numKeys);
+	for(int k = 0; k < numKeys; k++)
+		order[k] = k;
+
+	const std::string emptyRelationName = "relB";
+	try
+	{
+		File::remove(emptyRelationName);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+	{
+		PageFile emptyFile = PageFile::create(emptyRelationName);
+	}
+
+	for(int shuffled = 0; shuffled < 2; shuffled++)
+	{
+		if(shuffled)
+			for(int k = numKeys - 1; k > 0; k--)
+				std::swap(order[k], order[random() % (k + 1)]);
+		std::string separatorIndexName;
+		{
+			BTreeIndex index(emptyRelationName, separatorIndexName, bufMgr, offsetof(tuple,s), STRING, false);
+			char key[STRINGSIZE + 1];
+			for(int k = 0; k < numKeys; k++)
+			{
+				separatorKey(order[k], key);
+				RecordId rid;
+				rid.page_number = order[k] / 100 + 1;
+				rid.slot_number = order[k] % 100;
+				index.insertEntry(key, rid);
+			}
+			if(!shuffled)
+				checkPassFail(index.getTreeHeight(), 1)
+
+			int found = 0;
+			for(int k = 0; k < numKeys; k++)
+			{
+				separatorKey(k, key);
+				RecordId rid;
+				if(index.lookup(key, rid) && rid.page_number == (PageId) (k / 100 + 1) && rid.slot_number == k % 100)
+					found++;
+			}
+			checkPassFail(found, numKeys)
+			char lowKey[STRINGSIZE + 1], highKey[STRINGSIZE + 1];
+			separatorKey(0, lowKey);
+			separatorKey(numKeys - 1, highKey);
+			checkPassFail((int) index.countRange(lowKey, GTE, highKey, LTE), numKeys)
+			separatorKey(100000, lowKey);
+			separatorKey(150000, highKey);
+			checkPassFail((int) index.countRange(lowKey, GTE, highKey, LT), 50000)
+			checkPassFail((int) index.countRange("b", GTE, "c", LT), 26 * 26 * 26)
+		}
+		File::remove(separatorIndexName);
+	}
+	File::remove(emptyRelationName);
+}
+
+// writes key k of test18: the four base 26 digits of k as letters, most significant first, and a suffix
+void separatorKey(int k, char *key)
+{
+	for(int i = 3; i >= 0; i--)
+	{
+		key[i] = 'a' + k % 26;
+		k /= 26;
+	}
+	strcpy(key + 4, " key");
+}
+
+// looks up entries[first, last) in a composite index on (i, d) and returns the number found with their record id
+int compositeLookups(BTreeIndex * index, const std::vector< std::pair<RECORD, RecordId> > &entries, int first, int last)
+{
+	std::cout << "Lookups of " << last - first << " composite keys" << std::endl;
+	int numFound = 0;
+	for(int k = first; k < last; k++)
+	{
+		RecordId rid;
+		if(index->lookup(&entries[k].first, rid) && rid == entries[k].second)
+			numFound++;
+	}
+	std::cout << "Number of results: " << numFound << std::endl;
+	return numFound;
+}
+
+// -----------------------------------------------------------------------------
+// errorTests
+// -----------------------------------------------------------------------------
+
+void errorTests()
+{
+	{
+		std::cout << "Error handling tests" << std::endl;
+		std::cout << "--------------------" << std::endl;
+		// Given error test
+
+		try
+		{
+			File::remove(relationName);
+		}
+		catch(const FileNotFoundException &e)
+		{
+		}
+
+		file1 = new PageFile(relationName, true);
+		
+		// initialize all of record1.s to keep purify happy
+		memset(record1.s, ' ', sizeof(record1.s));
+		PageId new_page_number;
+		Page new_page = file1->allocatePage(new_page_number);
+
+		// Insert a bunch of tuples into the relation.
+		for(int i = 0; i <10; i++ ) 
+		{
+		  sprintf(record1.s, "%05d string record", i);
+		  record1.i = i;
+		  record1.d = (double)i;
+		  std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
+
+			while(1)
+			{
+				try
+				{
+		  		new_page.insertRecord(new_data);
+					break;
 				}
 				catch(const InsufficientSpaceException &e)
 				{
@@ -608,6 +2560,69 @@ void errorTests()
 			std::cout << "BadScanrangeException Test 1 Passed." << std::endl;
 		}
 
+		std::cout << "Prefix scan of an index on one attribute" << std::endl;
+		try
+		{
+			index.startPrefixScan(&int2, GTE, &int5, LTE, 1);
+			std::cout << "BadScanParamException Test 1 Failed." << std::endl;
+		}
+		catch(const BadScanParamException &e)
+		{
+			std::cout << "BadScanParamException Test 1 Passed." << std::endl;
+		}
+
+		std::cout << "Skip scan of an index on one attribute" << std::endl;
+		try
+		{
+			index.startSkipScan(&record1, GTE, &record1, LTE);
+			std::cout << "BadScanParamException Test 2 Failed." << std::endl;
+		}
+		catch(const BadScanParamException &e)
+		{
+			std::cout << "BadScanParamException Test 2 Passed." << std::endl;
+		}
+
+		std::cout << "Record of an index of record ids" << std::endl;
+		try
+		{
+			index.insertRecord(&record1);
+			std::cout << "BadIndexInfoException Test 1 Failed." << std::endl;
+		}
+		catch(const BadIndexInfoException &e)
+		{
+			std::cout << "BadIndexInfoException Test 1 Passed." << std::endl;
+		}
+
+		std::string clusteredIndexName;
+		{
+			BTreeIndex clustered(relationName, clusteredIndexName, bufMgr, offsetof(tuple,i), INTEGER, CLUSTERED, sizeof(RECORD));
+			std::cout << "Record id of a clustered index" << std::endl;
+			try
+			{
+				clustered.insertEntry(&int2, rid);
+				std::cout << "BadIndexInfoException Test 2 Failed." << std::endl;
+			}
+			catch(const BadIndexInfoException &e)
+			{
+				std::cout << "BadIndexInfoException Test 2 Passed." << std::endl;
+			}
+
+			std::cout << "Record id scan of a clustered index" << std::endl;
+			clustered.startScan(&int2, GTE, &int5, LTE);
+			try
+			{
+				RecordId outRid;
+				clustered.scanNext(outRid);
+				std::cout << "BadIndexInfoException Test 3 Failed." << std::endl;
+			}
+			catch(const BadIndexInfoException &e)
+			{
+				std::cout << "BadIndexInfoException Test 3 Passed." << std::endl;
+			}
+			clustered.endScan();
+		}
+		File::remove(clusteredIndexName);
+
 		deleteRelation();
 	}
 
@@ -0,0 +1,280 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace badgerdb
+{
+
+/*
+NODESEARCHKERNEL names the kernel nodeLowerBound and nodeUpperBound use for int keys, picked at compile time.
+Build with -mavx2 (or -march=native) to get the AVX2 kernel, x86-64 builds get SSE2 by default.
+NODESEARCHWINDOW is the number of keys the int search counts with vector compares, once branchless binary search
+has narrowed the node down to it. It is tuned with node_search_bench ("make bench"): two vector compares either way.
+*/
+#if defined(__AVX2__)
+const char* const NODESEARCHKERNEL = "avx2";
+const int NODESEARCHWINDOW = 16;
+#elif defined(__SSE2__)
+const char* const NODESEARCHKERNEL = "sse2";
+const int NODESEARCHWINDOW = 8;
+#else
+const char* const NODESEARCHKERNEL = "scalar";
+const int NODESEARCHWINDOW = 1;
+#endif
+
+/*
+NODESEARCHWINDOW64 is the same for 64 bit keys, which is how DOUBLE keys are compared once normalized.
+Only AVX2 compares 64 bit integers 4 at a time, without it the branchless binary search runs down to a single key.
+*/
+#if defined(__AVX2__)
+const int NODESEARCHWINDOW64 = 8;
+#else
+const int NODESEARCHWINDOW64 = 1;
+#endif
+
+/**
+ * @brief Returns the order-preserving form of a double: as signed integers the results order the way the doubles do.
+ * The bits of a positive double already order that way, a negative double gets all but its sign bit flipped.
+ * -0.0 is normalized like 0.0, since the two compare equal.
+ */
+inline std::int64_t normalizeDouble( double value )
+{
+	if( value == 0 )
+		value = 0;
+	std::int64_t bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	return bits < 0 ? bits ^ INT64_MAX : bits;
+}
+
+/**
+ * @brief Reads 8 bytes as a big-endian number, so that numbers read from zero padded byte strings order the way memcmp orders the strings.
+ */
+inline std::uint64_t loadBigEndian64( const char* bytes )
+{
+	std::uint64_t value = 0;
+	for( int i = 0; i < 8; i++ )
+		value = ( value << 8 ) | (unsigned char) bytes[i];
+	return value;
+}
+
+/**
+ * @brief Reads 2 bytes as a big-endian number, see loadBigEndian64.
+ */
+inline std::uint32_t loadBigEndian16( const char* bytes )
+{
+	return ( (std::uint32_t) (unsigned char) bytes[0] << 8 ) | (unsigned char) bytes[1];
+}
+
+/**
+ * @brief Returns the number of keys in the sorted array keys[0, n) that are less than key, by walking the keys one at a time.
+ * This is the search the node code used before the search kernels, kept as the baseline of the microbenchmark.
+ */
+template <class T>
+inline int linearLowerBound( const T* keys, int n, const T& key )
+{
+	int i = 0;
+	while( i < n && keys[i] < key )
+		i++;
+	return i;
+}
+
+/**
+ * @brief Returns the number of keys in the sorted array keys[0, n) that are less than or equal to key, by walking the keys one at a time.
+ */
+template <class T>
+inline int linearUpperBound( const T* keys, int n, const T& key )
+{
+	int i = 0;
+	while( i < n && !( key < keys[i] ) )
+		i++;
+	return i;
+}
+
+/**
+ * @brief Returns the number of keys in the sorted array keys[0, n) that are less than key.
+ * Branchless binary search: every step halves the range with a conditional move instead of a branch.
+ */
+template <class T>
+inline int binaryLowerBound( const T* keys, int n, const T& key )
+{
+	if( n == 0 )
+		return 0;
+	const T* base = keys;
+	while( n > 1 )
+	{
+		int half = n / 2;
+		base = ( base[half] < key ) ? base + half : base;
+		n -= half;
+	}
+	return ( base - keys ) + ( *base < key );
+}
+
+/**
+ * @brief Returns the number of keys in the sorted array keys[0, n) that are less than or equal to key.
+ * Branchless binary search, see binaryLowerBound.
+ */
+template <class T>
+inline int binaryUpperBound( const T* keys, int n, const T& key )
+{
+	if( n == 0 )
+		return 0;
+	const T* base = keys;
+	while( n > 1 )
+	{
+		int half = n / 2;
+		base = ( key < base[half] ) ? base : base + half;
+		n -= half;
+	}
+	return ( base - keys ) + !( key < *base );
+}
+
+/**
+ * @brief Counts the keys of keys[0, n) that are less than key (orEqual false) or less than or equal to key (orEqual true).
+ * The keys do not need to be sorted. Uses vector compares on x86, 8 keys at a time with AVX2 and 4 with SSE2.
+ */
+inline int countLessInt( const int* keys, int n, int key, bool orEqual )
+{
+	int count = 0;
+	int i = 0;
+#if defined(__AVX2__)
+	const __m256i keyVec = _mm256_set1_epi32( key );
+	for( ; i + 8 <= n; i += 8 )
+	{
+		__m256i v = _mm256_loadu_si256( (const __m256i*) ( keys + i ) );
+		// less: key > v, less or equal: !(v > key)
+		__m256i mask = orEqual ? _mm256_cmpgt_epi32( v, keyVec ) : _mm256_cmpgt_epi32( keyVec, v );
+		int bits = __builtin_popcount( _mm256_movemask_ps( _mm256_castsi256_ps( mask ) ) );
+		count += orEqual ? 8 - bits : bits;
+	}
+#endif
+#if defined(__SSE2__)
+	const __m128i keyVec4 = _mm_set1_epi32( key );
+	for( ; i + 4 <= n; i += 4 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*) ( keys + i ) );
+		__m128i mask = orEqual ? _mm_cmpgt_epi32( v, keyVec4 ) : _mm_cmpgt_epi32( keyVec4, v );
+		int bits = __builtin_popcount( _mm_movemask_ps( _mm_castsi128_ps( mask ) ) );
+		count += orEqual ? 4 - bits : bits;
+	}
+#endif
+	for( ; i < n; i++ )
+		count += orEqual ? ( keys[i] <= key ) : ( keys[i] < key );
+	return count;
+}
+
+/**
+ * @brief Counts the keys of keys[0, n) that are less than key (orEqual false) or less than or equal to key (orEqual true),
+ * for 64 bit keys. Uses vector compares with AVX2, 4 keys at a time.
+ */
+inline int countLessInt64( const std::int64_t* keys, int n, std::int64_t key, bool orEqual )
+{
+	int count = 0;
+	int i = 0;
+#if defined(__AVX2__)
+	const __m256i keyVec = _mm256_set1_epi64x( key );
+	for( ; i + 4 <= n; i += 4 )
+	{
+		__m256i v = _mm256_loadu_si256( (const __m256i*) ( keys + i ) );
+		__m256i mask = orEqual ? _mm256_cmpgt_epi64( v, keyVec ) : _mm256_cmpgt_epi64( keyVec, v );
+		int bits = __builtin_popcount( _mm256_movemask_pd( _mm256_castsi256_pd( mask ) ) );
+		count += orEqual ? 4 - bits : bits;
+	}
+#endif
+	for( ; i < n; i++ )
+		count += orEqual ? ( keys[i] <= key ) : ( keys[i] < key );
+	return count;
+}
+
+/**
+ * @brief Returns the number of keys in the sorted array keys[0, n) that are less than key, i.e. the index of the first key >= key.
+ * This is the search used inside B+ Tree nodes. The generic version is a branchless binary search.
+ */
+template <class T>
+inline int nodeLowerBound( const T* keys, int n, const T& key )
+{
+	return binaryLowerBound( keys, n, key );
+}
+
+/**
+ * @brief Returns the number of keys in the sorted array keys[0, n) that are less than or equal to key, i.e. the index of the first key > key.
+ */
+template <class T>
+inline int nodeUpperBound( const T* keys, int n, const T& key )
+{
+	return binaryUpperBound( keys, n, key );
+}
+
+/**
+ * @brief nodeLowerBound for int keys. Branchless binary search narrows the node down to NODESEARCHWINDOW keys,
+ * which are then counted with vector compares.
+ */
+inline int nodeLowerBound( const int* keys, int n, const int& key )
+{
+	const int* base = keys;
+	while( n > NODESEARCHWINDOW )
+	{
+		int half = n / 2;
+		base = ( base[half] < key ) ? base + half : base;
+		n -= half;
+	}
+	return ( base - keys ) + countLessInt( base, n, key, false );
+}
+
+/**
+ * @brief nodeUpperBound for int keys, see nodeLowerBound.
+ */
+inline int nodeUpperBound( const int* keys, int n, const int& key )
+{
+	const int* base = keys;
+	while( n > NODESEARCHWINDOW )
+	{
+		int half = n / 2;
+		base = ( key < base[half] ) ? base : base + half;
+		n -= half;
+	}
+	return ( base - keys ) + countLessInt( base, n, key, true );
+}
+
+/**
+ * @brief nodeLowerBound for 64 bit keys, like the one for int keys with NODESEARCHWINDOW64.
+ */
+inline int nodeLowerBound( const std::int64_t* keys, int n, const std::int64_t& key )
+{
+	const std::int64_t* base = keys;
+	while( n > NODESEARCHWINDOW64 )
+	{
+		int half = n / 2;
+		base = ( base[half] < key ) ? base + half : base;
+		n -= half;
+	}
+	return ( base - keys ) + countLessInt64( base, n, key, false );
+}
+
+/**
+ * @brief nodeUpperBound for 64 bit keys, see nodeLowerBound.
+ */
+inline int nodeUpperBound( const std::int64_t* keys, int n, const std::int64_t& key )
+{
+	const std::int64_t* base = keys;
+	while( n > NODESEARCHWINDOW64 )
+	{
+		int half = n / 2;
+		base = ( key < base[half] ) ? base : base + half;
+		n -= half;
+	}
+	return ( base - keys ) + countLessInt64( base, n, key, true );
+}
+
+}
@@ -0,0 +1,132 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+// Microbenchmark of the B+ Tree node search kernels. Searches random keys in a full leaf and a full
+// non-leaf node with the old linear walk, the branchless binary search and nodeLowerBound, and prints
+// the time per search. Build and run with "make bench".
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "btree.h"
+
+using namespace badgerdb;
+
+const int numProbes = 1 << 16;
+const int numRounds = 50;
+
+/**
+ * Keeps the result of a search alive so the compiler cannot drop the search.
+ */
+volatile long searchSink;
+
+/**
+ * Runs every probe numRounds times through search and returns the average time per search in nanoseconds.
+ */
+template <class T, class Search>
+double timeSearch(const std::vector<T> &keys, const std::vector<T> &probes, Search search)
+{
+	long total = 0;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for(int round = 0; round < numRounds; round++)
+	{
+		for(int p = 0; p < numProbes; p++)
+			total += search(&keys[0], (int) keys.size(), probes[p]);
+	}
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	searchSink = total;
+	return std::chrono::duration<double, std::nano>(end - start).count() / ((double) numRounds * numProbes);
+}
+
+int linearInt(const int *keys, int n, const int &key) { return linearLowerBound(keys, n, key); }
+int binaryInt(const int *keys, int n, const int &key) { return binaryLowerBound(keys, n, key); }
+int kernelInt(const int *keys, int n, const int &key) { return nodeLowerBound(keys, n, key); }
+int linearDouble(const double *keys, int n, const double &key) { return linearLowerBound(keys, n, key); }
+int kernelDouble(const double *keys, int n, const double &key) { return nodeLowerBound(keys, n, key); }
+
+/**
+ * Benchmarks the int kernels on a node of the given size. Keys are the even numbers, probes hit and miss keys.
+ * Returns false if the kernels do not agree with the linear walk.
+ */
+bool benchInt(const char *nodeName, int nodeSize)
+{
+	std::vector<int> keys(nodeSize);
+	for(int i = 0; i < nodeSize; i++)
+		keys[i] = 2 * i;
+	std::vector<int> probes(numProbes);
+	for(int p = 0; p < numProbes; p++)
+		probes[p] = (int) (random() % (2 * nodeSize + 2)) - 1;
+
+	for(int p = 0; p < numProbes; p++)
+	{
+		int expected = linearLowerBound(&keys[0], nodeSize, probes[p]);
+		int expectedUpper = linearUpperBound(&keys[0], nodeSize, probes[p]);
+		if(binaryLowerBound(&keys[0], nodeSize, probes[p]) != expected || nodeLowerBound(&keys[0], nodeSize, probes[p]) != expected ||
+			 binaryUpperBound(&keys[0], nodeSize, probes[p]) != expectedUpper || nodeUpperBound(&keys[0], nodeSize, probes[p]) != expectedUpper)
+		{
+			std::cout << "Search kernels disagree on key " << probes[p] << std::endl;
+			return false;
+		}
+	}
+
+	std::cout << "int " << nodeName << " (" << nodeSize << " keys), ns per search:" << std::endl;
+	std::cout << "  linear:         " << timeSearch(keys, probes, linearInt) << std::endl;
+	std::cout << "  binary:         " << timeSearch(keys, probes, binaryInt) << std::endl;
+	std::cout << "  nodeLowerBound: " << timeSearch(keys, probes, kernelInt) << std::endl;
+	return true;
+}
+
+int kernelDoubleKey(const DoubleKey *keys, int n, const DoubleKey &key) { return nodeLowerBound(keys, n, key); }
+
+/**
+ * Benchmarks the double kernels on a leaf, see benchInt. Keys are spread around zero, so the normalized keys
+ * searched by the DoubleKey kernel cover both signs.
+ */
+bool benchDouble(int nodeSize)
+{
+	std::vector<double> keys(nodeSize);
+	std::vector<DoubleKey> normalizedKeys(nodeSize);
+	for(int i = 0; i < nodeSize; i++)
+	{
+		keys[i] = i - nodeSize / 2;
+		normalizedKeys[i] = KeyTraits<DoubleKey>::fromBytes(&keys[i]);
+	}
+	std::vector<double> probes(numProbes);
+	std::vector<DoubleKey> normalizedProbes(numProbes);
+	for(int p = 0; p < numProbes; p++)
+	{
+		probes[p] = (random() % (2 * nodeSize + 2)) / 2.0 - 0.5 - nodeSize / 2;
+		normalizedProbes[p] = KeyTraits<DoubleKey>::fromBytes(&probes[p]);
+	}
+
+	for(int p = 0; p < numProbes; p++)
+	{
+		int expected = linearLowerBound(&keys[0], nodeSize, probes[p]);
+		if(nodeLowerBound(&keys[0], nodeSize, probes[p]) != expected ||
+			 nodeLowerBound(&normalizedKeys[0], nodeSize, normalizedProbes[p]) != expected ||
+			 nodeUpperBound(&normalizedKeys[0], nodeSize, normalizedProbes[p]) != linearUpperBound(&keys[0], nodeSize, probes[p]))
+		{
+			std::cout << "Search kernels disagree on key " << probes[p] << std::endl;
+			return false;
+		}
+	}
+
+	std::cout << "double leaf (" << nodeSize << " keys), ns per search:" << std::endl;
+	std::cout << "  linear:         " << timeSearch(keys, probes, linearDouble) << std::endl;
+	std::cout << "  nodeLowerBound: " << timeSearch(keys, probes, kernelDouble) << std::endl;
+	std::cout << "  DoubleKey:      " << timeSearch(normalizedKeys, normalizedProbes, kernelDoubleKey) << std::endl;
+	return true;
+}
+
+int main()
+{
+	std::cout << "Node search kernel for int keys: " << NODESEARCHKERNEL << std::endl;
+	if(!benchInt("leaf", INTARRAYLEAFSIZE) || !benchInt("non-leaf", INTARRAYNONLEAFSIZE) || !benchDouble(DOUBLEARRAYLEAFSIZE))
+		return 1;
+	return 0;
+}
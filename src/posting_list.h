@@ -0,0 +1,249 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "types.h"
+#include "page.h"
+
+namespace badgerdb
+{
+
+/*
+A key with many record ids is stored once in its leaf, with a posting list instead of a record id. The leaf entry's
+slot number has POSTINGFLAG set, which no record's slot number has since a page holds far fewer slots, and keeps the
+number of record ids of the list in the other bits. Its page number is the first page of the posting list.
+The record ids of a posting list are kept sorted and stored as varint coded differences to the one before,
+on a chain of PostingPage pages. A leaf moves the entries of a key into a posting list once it holds
+POSTINGTHRESHOLD of them and runs out of room, so indexes with few duplicates keep the plain leaf format.
+*/
+const SlotId POSTINGFLAG = 0x8000;
+const int POSTINGTHRESHOLD = 16;
+
+/**
+ * @brief Largest number of record ids a leaf entry counts for its posting list. Longer lists keep this count in the
+ * entry, their size is read from the first page of the list.
+ */
+const int MAXPOSTINGCOUNT = 0x7FFF;
+
+/**
+ * @brief Number of bytes of coded record ids on a posting page.
+ */
+//                                         numRids, numBytes, totalRids   next, prev, last page   firstRid, lastRid
+const int POSTINGDATASIZE = Page::SIZE - 3 * sizeof( int ) - 3 * sizeof( PageId ) - 2 * sizeof( RecordId );
+
+/**
+ * @brief Structure of the pages of a posting list. The first page of the list also keeps the totals of the list.
+ */
+struct PostingPage{
+  /**
+   * Number of record ids on this page.
+   */
+	int numRids;
+
+  /**
+   * Number of bytes of data used.
+   */
+	int numBytes;
+
+  /**
+   * Number of record ids in the whole list. Only kept on the first page.
+   */
+	int totalRids;
+
+  /**
+   * Page number of the next page of the list, Page::INVALID_NUMBER on the last page.
+   */
+	PageId nextPageNo;
+
+  /**
+   * Page number of the previous page of the list, Page::INVALID_NUMBER on the first page.
+   */
+	PageId prevPageNo;
+
+  /**
+   * Page number of the last page of the list. Only kept on the first page, appends go straight there.
+   */
+	PageId lastPageNo;
+
+  /**
+   * Smallest record id on this page, stored in full.
+   */
+	RecordId firstRid;
+
+  /**
+   * Largest record id on this page, the one the next append is coded against.
+   */
+	RecordId lastRid;
+
+  /**
+   * Varint coded differences of the record ids after firstRid.
+   */
+	unsigned char data[ POSTINGDATASIZE ];
+};
+
+/**
+ * @brief Returns whether a leaf entry's record id is the first page of a posting list.
+ */
+inline bool isPosting( const RecordId& rid )
+{
+	return ( rid.slot_number & POSTINGFLAG ) != 0;
+}
+
+/**
+ * @brief Returns the record id a leaf entry links to the posting list starting at page headPageNo with.
+ * numRids is the number of record ids in the list, counts past MAXPOSTINGCOUNT are kept as MAXPOSTINGCOUNT.
+ */
+inline RecordId postingLink( const PageId headPageNo, const int numRids )
+{
+	RecordId rid;
+	rid.page_number = headPageNo;
+	rid.slot_number = POSTINGFLAG | (SlotId) std::min( numRids, MAXPOSTINGCOUNT );
+	rid.padding = 0;
+	return rid;
+}
+
+/**
+ * @brief Returns the number of record ids a leaf entry counts for its posting list, MAXPOSTINGCOUNT for longer lists.
+ */
+inline int postingLinkCount( const RecordId& link )
+{
+	return link.slot_number & MAXPOSTINGCOUNT;
+}
+
+/**
+ * @brief Returns the leaf entry link after n record ids were added to its posting list.
+ */
+inline RecordId postingLinkAdd( const RecordId& link, const int n )
+{
+	return postingLink( link.page_number, postingLinkCount( link ) + n );
+}
+
+/**
+ * @brief Returns a record id as one number, in the order posting lists keep record ids in.
+ */
+inline std::uint64_t postingValue( const RecordId& rid )
+{
+	return ( (std::uint64_t) rid.page_number << 16 ) | rid.slot_number;
+}
+
+/**
+ * @brief Returns the record id postingValue returned value for.
+ */
+inline RecordId postingRid( const std::uint64_t value )
+{
+	RecordId rid;
+	rid.page_number = (PageId) ( value >> 16 );
+	rid.slot_number = (SlotId) ( value & 0xFFFF );
+	rid.padding = 0;
+	return rid;
+}
+
+/**
+ * @brief Orders record ids the way posting lists keep them, for std::sort.
+ */
+inline bool postingLess( const RecordId& a, const RecordId& b )
+{
+	return postingValue( a ) < postingValue( b );
+}
+
+/**
+ * @brief Writes value as a varint, seven bits a byte with the high bit set on all but the last byte.
+ * @return Number of bytes written, at most 10.
+ */
+inline int encodeVarint( std::uint64_t value, unsigned char* out )
+{
+	int n = 0;
+	while( value >= 0x80 )
+	{
+		out[n++] = (unsigned char) ( value | 0x80 );
+		value >>= 7;
+	}
+	out[n++] = (unsigned char) value;
+	return n;
+}
+
+/**
+ * @brief Reads a varint written by encodeVarint and moves in past it.
+ */
+inline std::uint64_t decodeVarint( const unsigned char*& in )
+{
+	std::uint64_t value = 0;
+	int shift = 0;
+	while( *in & 0x80 )
+	{
+		value |= (std::uint64_t) ( *in++ & 0x7F ) << shift;
+		shift += 7;
+	}
+	value |= (std::uint64_t) *in++ << shift;
+	return value;
+}
+
+/**
+ * @brief Copies the record ids of a posting page into rids, in order.
+ */
+inline void decodePostingPage( const PostingPage* page, std::vector<RecordId>& rids )
+{
+	rids.clear();
+	if( page->numRids == 0 )
+		return;
+	rids.reserve( page->numRids );
+	rids.push_back( page->firstRid );
+	std::uint64_t value = postingValue( page->firstRid );
+	const unsigned char* in = page->data;
+	for( int i = 1; i < page->numRids; i++ )
+	{
+		value += decodeVarint( in );
+		rids.push_back( postingRid( value ) );
+	}
+}
+
+/**
+ * @brief Appends a record id larger than the last one on a posting page, if its difference fits on the page.
+ * @return Whether the record id was appended.
+ */
+inline bool appendPostingPage( PostingPage* page, const RecordId& rid )
+{
+	if( page->numRids == 0 )
+	{
+		page->firstRid = rid;
+		page->lastRid = rid;
+		page->numRids = 1;
+		page->numBytes = 0;
+		return true;
+	}
+	unsigned char buf[ 10 ];
+	int len = encodeVarint( postingValue( rid ) - postingValue( page->lastRid ), buf );
+	if( page->numBytes + len > POSTINGDATASIZE )
+		return false;
+	for( int i = 0; i < len; i++ )
+		page->data[ page->numBytes + i ] = buf[ i ];
+	page->numBytes += len;
+	page->numRids++;
+	page->lastRid = rid;
+	return true;
+}
+
+/**
+ * @brief Rewrites a posting page with the sorted record ids rids[0, n), as many of them as fit.
+ * The page links and totals are left alone.
+ * @return Number of record ids written, at least one if n > 0.
+ */
+inline int encodePostingPage( PostingPage* page, const RecordId* rids, int n )
+{
+	page->numRids = 0;
+	page->numBytes = 0;
+	int i = 0;
+	while( i < n && appendPostingPage( page, rids[ i ] ) )
+		i++;
+	return i;
+}
+
+}